@@ -1,6 +1,10 @@
 #include <array>
+#include <bit>
 #include <cstdint>
 #include <image/FrameBuffer.hpp>
+#include <image/PngWriter.hpp>
+#include <string_view>
+#include <type_traits>
 
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include <external/stb_image_write.h>
@@ -12,21 +16,74 @@ void WriteToStream(void* context, void* data, int size) {
   auto* out = static_cast<std::ofstream*>(context);
   out->write(static_cast<const char*>(data), size);
 }
+
+// Pixels are handed to the encoders in place, as runs of bytes or floats
+static_assert(sizeof(PixelU8) == 3 && std::is_standard_layout_v<PixelU8>);
+static_assert(sizeof(PixelF32) == 3 * sizeof(float));
+
+// OpenEXR stores every value little endian
+template <typename T>
+void WriteLittleEndian(std::ofstream& out, T value) {
+  using Bits = std::conditional_t<sizeof(T) == 8, std::uint64_t,
+                                  std::uint32_t>;
+  auto bits = std::bit_cast<Bits>(value);
+  std::array<char, sizeof(T)> bytes{};
+  for (auto& byte : bytes) {
+    byte = static_cast<char>(bits & 0xffU);
+    bits >>= 8U;
+  }
+  out.write(bytes.data(), bytes.size());
+}
+
+void WriteExrAttribute(std::ofstream& out, std::string_view name,
+                       std::string_view type, std::uint32_t size) {
+  out.write(name.data(), static_cast<std::streamsize>(name.size()));
+  out.put('\0');
+  out.write(type.data(), static_cast<std::streamsize>(type.size()));
+  out.put('\0');
+  WriteLittleEndian(out, size);
+}
 }  // namespace
 
 void FrameBuffer::Set(std::size_t x, std::size_t y, const PixelU8& p) {
   const auto index = (y * width_) + x;
 
 #ifndef NDEBUG
-  // Bounds check (index must be strictly less than data_.size())
-  if (index >= data_.size()) [[unlikely]] {
+  // Bounds check (index must be strictly less than the pixel count)
+  if (index >= width_ * height_) [[unlikely]] {
     return;
   }
 #endif
 
+  if (IsHighDynamicRange()) {
+    // Undo the gamma 2 encoding of display bytes
+    const auto linear = [](std::uint8_t v) {
+      const float g = (static_cast<float>(v) + 0.5F) / 256.0F;
+      return g * g;
+    };
+    hdr_data_[index] = PixelF32(linear(p.R()), linear(p.G()), linear(p.B()));
+    return;
+  }
+
   data_[index] = p;
 }
 
+void FrameBuffer::Set(std::size_t x, std::size_t y, const PixelF32& p) {
+  const auto index = (y * width_) + x;
+
+#ifndef NDEBUG
+  if (index >= width_ * height_) [[unlikely]] {
+    return;
+  }
+#endif
+
+  if (IsHighDynamicRange()) {
+    hdr_data_[index] = p;
+  } else {
+    data_[index] = p.AsU8();
+  }
+}
+
 void FrameBuffer::Write(std::ofstream& out) {
   switch (format_) {
     case FileFormat::BMP:
@@ -38,6 +95,15 @@ void FrameBuffer::Write(std::ofstream& out) {
     case FileFormat::JPG:
       WriteAsJPG(out);
       break;
+    case FileFormat::HDR:
+      WriteAsHDR(out);
+      break;
+    case FileFormat::PFM:
+      WriteAsPFM(out);
+      break;
+    case FileFormat::EXR:
+      WriteAsEXR(out);
+      break;
     default:
       WriteAsBMP(out);
       break;
@@ -49,23 +115,8 @@ void FrameBuffer::WriteAsBMP(std::ofstream& out) {
     return;
   }
 
-  const int width = static_cast<int>(width_);
-  const int height = static_cast<int>(height_);
-
-  std::vector<std::uint8_t> rgb;
-  rgb.resize(width_ * height_ * 3);
-
-  for (std::size_t y = 0; y < height_; ++y) {
-    for (std::size_t x = 0; x < width_; ++x) {
-      const PixelU8& p = data_[(y * width_) + x];
-      const std::size_t offset = (y * width_ + x) * 3;
-      rgb[offset + 0] = p.R();
-      rgb[offset + 1] = p.G();
-      rgb[offset + 2] = p.B();
-    }
-  }
-
-  stbi_write_bmp_to_func(WriteToStream, &out, width, height, 3, rgb.data());
+  stbi_write_bmp_to_func(WriteToStream, &out, static_cast<int>(width_),
+                         static_cast<int>(height_), 3, data_.data());
 }
 
 void FrameBuffer::WriteAsPNG(std::ofstream& out) {
@@ -73,50 +124,144 @@ void FrameBuffer::WriteAsPNG(std::ofstream& out) {
     return;
   }
 
+#ifdef POLARIS_HAS_ZLIB
+  // Nothing is written when zlib fails, so stb_image_write can take over
+  if (WritePng(out, reinterpret_cast<const std::uint8_t*>(data_.data()),
+               width_, height_, util::ThreadPool::Default()) ||
+      !out.good()) {
+    return;
+  }
+#endif
   const int width = static_cast<int>(width_);
-  const int height = static_cast<int>(height_);
+  const int stride = width * 3;
+  stbi_write_png_to_func(WriteToStream, &out, width,
+                         static_cast<int>(height_), 3, data_.data(), stride);
+}
 
-  std::vector<std::uint8_t> rgb;
-  rgb.resize(width_ * height_ * 3);
+void FrameBuffer::WriteAsJPG(std::ofstream& out) {
+  if (!out.good()) {
+    return;
+  }
 
-  for (std::size_t y = 0; y < height_; ++y) {
-    for (std::size_t x = 0; x < width_; ++x) {
-      const PixelU8& p = data_[(y * width_) + x];
-      const std::size_t offset = (y * width_ + x) * 3;
-      rgb[offset + 0] = p.R();
-      rgb[offset + 1] = p.G();
-      rgb[offset + 2] = p.B();
-    }
+  constexpr int kJpegQuality = 90;
+  stbi_write_jpg_to_func(WriteToStream, &out, static_cast<int>(width_),
+                         static_cast<int>(height_), 3, data_.data(),
+                         kJpegQuality);
+}
+
+void FrameBuffer::WriteAsHDR(std::ofstream& out) {
+  if (!out.good()) {
+    return;
   }
 
-  const int stride = width * 3;
-  stbi_write_png_to_func(WriteToStream, &out, width, height, 3, rgb.data(),
-                         stride);
+  // stb encodes one scanline at a time straight from the buffer
+  stbi_write_hdr_to_func(WriteToStream, &out, static_cast<int>(width_),
+                         static_cast<int>(height_), 3,
+                         reinterpret_cast<const float*>(hdr_data_.data()));
 }
 
-void FrameBuffer::WriteAsJPG(std::ofstream& out) {
+void FrameBuffer::WriteAsPFM(std::ofstream& out) {
   if (!out.good()) {
     return;
   }
 
-  const int width = static_cast<int>(width_);
-  const int height = static_cast<int>(height_);
+  // A negative scale marks little endian data
+  const char* scale =
+      std::endian::native == std::endian::little ? "-1.0" : "1.0";
+  out << "PF\n" << width_ << ' ' << height_ << '\n' << scale << '\n';
+
+  // Rows go bottom to top
+  const auto row_bytes =
+      static_cast<std::streamsize>(width_ * sizeof(PixelF32));
+  for (std::size_t y = height_; y-- > 0;) {
+    out.write(reinterpret_cast<const char*>(&hdr_data_[y * width_]),
+              row_bytes);
+  }
+}
+
+void FrameBuffer::WriteAsEXR(std::ofstream& out) {
+  if (!out.good() || width_ == 0 || height_ == 0) {
+    return;
+  }
+
+  constexpr std::uint32_t kMagic = 20000630;
+  constexpr std::uint32_t kVersion = 2;  // Single part scanline file
+  constexpr std::uint32_t kFloat = 2;    // Pixel type of every channel
 
-  std::vector<std::uint8_t> rgb;
-  rgb.resize(width_ * height_ * 3);
+  const auto max_x = static_cast<std::int32_t>(width_ - 1);
+  const auto max_y = static_cast<std::int32_t>(height_ - 1);
 
+  WriteLittleEndian(out, kMagic);
+  WriteLittleEndian(out, kVersion);
+
+  // Channels are listed, and stored, in alphabetical order
+  constexpr std::array<char, 3> kChannels = {'B', 'G', 'R'};
+  WriteExrAttribute(out, "channels", "chlist",
+                    (kChannels.size() * 18) + 1);
+  for (const char channel : kChannels) {
+    out.put(channel);
+    out.put('\0');
+    WriteLittleEndian(out, kFloat);
+    WriteLittleEndian(out, std::uint32_t{0});  // pLinear and reserved
+    WriteLittleEndian(out, std::int32_t{1});   // x sampling
+    WriteLittleEndian(out, std::int32_t{1});   // y sampling
+  }
+  out.put('\0');
+
+  WriteExrAttribute(out, "compression", "compression", 1);
+  out.put('\0');  // None
+
+  for (const char* window : {"dataWindow", "displayWindow"}) {
+    WriteExrAttribute(out, window, "box2i", 16);
+    WriteLittleEndian(out, std::int32_t{0});
+    WriteLittleEndian(out, std::int32_t{0});
+    WriteLittleEndian(out, max_x);
+    WriteLittleEndian(out, max_y);
+  }
+
+  WriteExrAttribute(out, "lineOrder", "lineOrder", 1);
+  out.put('\0');  // Increasing y
+
+  WriteExrAttribute(out, "pixelAspectRatio", "float", 4);
+  WriteLittleEndian(out, 1.0F);
+
+  WriteExrAttribute(out, "screenWindowCenter", "v2f", 8);
+  WriteLittleEndian(out, 0.0F);
+  WriteLittleEndian(out, 0.0F);
+
+  WriteExrAttribute(out, "screenWindowWidth", "float", 4);
+  WriteLittleEndian(out, 1.0F);
+
+  out.put('\0');  // End of header
+
+  // Offset table, then one block per scanline: y, byte count and the row
+  // of each channel in turn
+  const auto row_bytes =
+      static_cast<std::uint32_t>(width_ * kChannels.size() * sizeof(float));
+  const std::uint64_t first_block =
+      static_cast<std::uint64_t>(out.tellp()) + (height_ * 8);
+  for (std::size_t y = 0; y < height_; ++y) {
+    WriteLittleEndian(out, first_block + (y * (8 + row_bytes)));
+  }
+
+  std::vector<float> row(width_ * kChannels.size());
   for (std::size_t y = 0; y < height_; ++y) {
     for (std::size_t x = 0; x < width_; ++x) {
-      const PixelU8& p = data_[(y * width_) + x];
-      const std::size_t offset = (y * width_ + x) * 3;
-      rgb[offset + 0] = p.R();
-      rgb[offset + 1] = p.G();
-      rgb[offset + 2] = p.B();
+      const auto& p = hdr_data_[(y * width_) + x];
+      row[x] = p.B();
+      row[width_ + x] = p.G();
+      row[(2 * width_) + x] = p.R();
     }
-  }
 
-  constexpr int kJpegQuality = 90;
-  stbi_write_jpg_to_func(WriteToStream, &out, width, height, 3, rgb.data(),
-                         kJpegQuality);
+    WriteLittleEndian(out, static_cast<std::int32_t>(y));
+    WriteLittleEndian(out, row_bytes);
+    if constexpr (std::endian::native == std::endian::little) {
+      out.write(reinterpret_cast<const char*>(row.data()), row_bytes);
+    } else {
+      for (const float value : row) {
+        WriteLittleEndian(out, value);
+      }
+    }
+  }
 }
 }  // namespace polaris::image
@@ -12,13 +12,31 @@ enum class FileFormat : std::uint8_t {
   BMP = 0,  // Windows Bitmap (stb_image_write)
   PNG,      // Portable Network Graphics (stb_image_write)
   JPG,      // JPEG (stb_image_write)
+  HDR,      // Radiance RGBE (stb_image_write), linear
+  PFM,      // Portable Float Map, linear
+  EXR,      // OpenEXR, uncompressed 32-bit float scanlines, linear
 };
 
+// Formats that keep linear radiance instead of display bytes
+[[nodiscard]] constexpr bool IsHighDynamicRange(FileFormat format) {
+  return format == FileFormat::HDR || format == FileFormat::PFM ||
+         format == FileFormat::EXR;
+}
+
+// Image in one of the output formats. Buffers for high dynamic range formats
+// hold linear float RGB; the others hold gamma encoded bytes. Either kind
+// accepts both pixel types and converts as needed.
 class FrameBuffer {
  public:
   FrameBuffer() = default;
 
   void Set(std::size_t x, std::size_t y, const PixelU8& p);
+  void Set(std::size_t x, std::size_t y, const PixelF32& p);
+
+  // Linear value of a high dynamic range buffer
+  [[nodiscard]] const PixelF32& Linear(std::size_t x, std::size_t y) const {
+    return hdr_data_[(y * width_) + x];
+  }
 
   void Write(std::ofstream& out);
 
@@ -26,21 +44,35 @@ class FrameBuffer {
     format_ = fmt;
     width_ = _width;
     height_ = _height;
-    data_.resize(width_ * height_);
+    if (IsHighDynamicRange()) {
+      data_.clear();
+      hdr_data_.resize(width_ * height_);
+    } else {
+      hdr_data_.clear();
+      data_.resize(width_ * height_);
+    }
   }
 
   [[nodiscard]] std::size_t Width() const { return width_; }
   [[nodiscard]] std::size_t Height() const { return height_; }
+  [[nodiscard]] FileFormat Format() const { return format_; }
+  [[nodiscard]] bool IsHighDynamicRange() const {
+    return image::IsHighDynamicRange(format_);
+  }
 
  private:
   void WriteAsPPM(std::ofstream& out);
   void WriteAsBMP(std::ofstream& out);
   void WriteAsPNG(std::ofstream& out);
   void WriteAsJPG(std::ofstream& out);
+  void WriteAsHDR(std::ofstream& out);
+  void WriteAsPFM(std::ofstream& out);
+  void WriteAsEXR(std::ofstream& out);
 
   FileFormat format_ = FileFormat::BMP;
   std::size_t width_ = 0, height_ = 0;
-  std::vector<PixelU8> data_;  // RGB byte data
+  std::vector<PixelU8> data_;       // RGB byte data
+  std::vector<PixelF32> hdr_data_;  // Linear RGB of HDR formats
 };
 }  // namespace polaris::image
 
@@ -0,0 +1,112 @@
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <image/MipMap.hpp>
+#include <utility>
+
+namespace polaris::image {
+
+namespace {
+
+// Bits of a coordinate within a tile spread to every other position
+constexpr auto kMortonSpread = [] {
+  std::array<std::uint16_t, TileLayout::kMaxTileSize> spread{};
+  for (std::size_t i = 0; i < spread.size(); ++i) {
+    for (std::size_t bit = 0; bit < 6; ++bit) {
+      spread[i] |= static_cast<std::uint16_t>(((i >> bit) & 1U) << (2 * bit));
+    }
+  }
+  return spread;
+}();
+
+}  // namespace
+
+TileLayout TileLayout::ForLevel(int width, int height) {
+  TileLayout layout;
+  layout.width = width;
+  layout.height = height;
+  const auto longest = static_cast<unsigned>(std::max(width, height));
+  layout.tile_size =
+      std::min(kMaxTileSize, static_cast<int>(std::bit_ceil(longest)));
+  layout.tiles_x = (width + layout.tile_size - 1) / layout.tile_size;
+  layout.tiles_y = (height + layout.tile_size - 1) / layout.tile_size;
+  return layout;
+}
+
+std::size_t TileLayout::WithinTile(int x, int y) const {
+  return 3 * static_cast<std::size_t>(kMortonSpread[x % tile_size] |
+                                      (kMortonSpread[y % tile_size] << 1U));
+}
+
+std::vector<TileLayout> MipMap::Layouts(int width, int height) {
+  std::vector<TileLayout> layouts;
+  if (width <= 0 || height <= 0) {
+    return layouts;
+  }
+  layouts.push_back(TileLayout::ForLevel(width, height));
+  while (width > 1 || height > 1) {
+    width = std::max(1, width / 2);
+    height = std::max(1, height / 2);
+    layouts.push_back(TileLayout::ForLevel(width, height));
+  }
+  return layouts;
+}
+
+MipMap::MipMap(const std::uint8_t* data, int width, int height) {
+  if (data == nullptr) {
+    return;
+  }
+
+  for (const auto& layout : Layouts(width, height)) {
+    Level level{layout, std::vector<std::uint8_t>(layout.TileCount() *
+                                                  layout.TileBytes())};
+    auto* texels = level.texels.data();
+    const auto tile_bytes = layout.TileBytes();
+    const auto last = Levels() - 1;
+    for (int y = 0; y < layout.height; ++y) {
+      for (int x = 0; x < layout.width; ++x) {
+        auto* texel =
+            texels + layout.Tile(x, y) * tile_bytes + layout.WithinTile(x, y);
+        if (last < 0) {
+          const auto* source =
+              data + 3 * (static_cast<std::size_t>(y) * width + x);
+          std::copy_n(source, 3, texel);
+          continue;
+        }
+
+        // Each level averages 2x2 blocks of the one before; an odd last row
+        // or column is folded into the block next to it by clamping
+        const auto a = TexelAt(last, 2 * x, 2 * y);
+        const auto b = TexelAt(last, 2 * x + 1, 2 * y);
+        const auto c = TexelAt(last, 2 * x, 2 * y + 1);
+        const auto d = TexelAt(last, 2 * x + 1, 2 * y + 1);
+        for (int k = 0; k < 3; ++k) {
+          texel[k] =
+              static_cast<std::uint8_t>((a[k] + b[k] + c[k] + d[k] + 2) / 4);
+        }
+      }
+    }
+    levels_.push_back(std::move(level));
+  }
+}
+
+Texel MipMap::TexelAt(int level, int x, int y) const {
+  const auto& entry = levels_[level];
+  const auto& layout = entry.layout;
+  x = std::clamp(x, 0, layout.width - 1);
+  y = std::clamp(y, 0, layout.height - 1);
+  const auto* texel = entry.texels.data() +
+                      layout.Tile(x, y) * layout.TileBytes() +
+                      layout.WithinTile(x, y);
+  return {texel[0], texel[1], texel[2]};
+}
+
+std::size_t MipMap::MemoryBytes() const {
+  std::size_t bytes = 0;
+  for (const auto& level : levels_) {
+    bytes += level.texels.size();
+  }
+  return bytes;
+}
+
+}  // namespace polaris::image
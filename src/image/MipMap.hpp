@@ -0,0 +1,170 @@
+#ifndef POLARIS_IMAGE_MIP_MAP_HPP
+#define POLARIS_IMAGE_MIP_MAP_HPP
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <image/Pixel.hpp>
+#include <span>
+#include <vector>
+
+namespace polaris::image {
+
+enum class TextureFilter : std::uint8_t {
+  Nearest = 0,  // Closest texel of the full size image
+  Bilinear,     // Blend of the four closest texels of the full size image
+  Trilinear,    // Blend of bilinear lookups in the two levels nearest the
+                // footprint's size
+};
+
+using Texel = std::array<std::uint8_t, 3>;
+
+// Placement of one level's texels in square tiles, stored row by row, with
+// the texels of a tile in Morton order
+struct TileLayout {
+  static constexpr int kMaxTileSize = 64;
+
+  int width = 0;
+  int height = 0;
+  int tile_size = 0;  // Less than kMaxTileSize only for small levels
+  int tiles_x = 0;
+  int tiles_y = 0;
+
+  [[nodiscard]] static TileLayout ForLevel(int width, int height);
+
+  [[nodiscard]] std::size_t TileCount() const {
+    return static_cast<std::size_t>(tiles_x) * tiles_y;
+  }
+  [[nodiscard]] std::size_t TileBytes() const {
+    return 3 * static_cast<std::size_t>(tile_size) * tile_size;
+  }
+  // Tile holding (x, y), and the offset of its bytes within the tile
+  [[nodiscard]] std::size_t Tile(int x, int y) const {
+    return static_cast<std::size_t>(y / tile_size) * tiles_x + x / tile_size;
+  }
+  [[nodiscard]] std::size_t WithinTile(int x, int y) const;
+};
+
+// 8-bit RGB image with its chain of levels, each half the size of the one
+// before, down to a single texel. Tiling keeps lookups near each other in
+// both directions on the same few cache lines.
+class MipMap {
+ public:
+  MipMap() = default;
+  // `data` holds `width` x `height` texels of three bytes, top row first
+  MipMap(const std::uint8_t* data, int width, int height);
+
+  // Layouts of the levels of a `width` x `height` image
+  [[nodiscard]] static std::vector<TileLayout> Layouts(int width, int height);
+
+  [[nodiscard]] bool Empty() const { return levels_.empty(); }
+  [[nodiscard]] int Levels() const { return static_cast<int>(levels_.size()); }
+  [[nodiscard]] int Width(int level) const { return Layout(level).width; }
+  [[nodiscard]] int Height(int level) const { return Layout(level).height; }
+  [[nodiscard]] const TileLayout& Layout(int level) const {
+    return levels_[level].layout;
+  }
+  // Tiles of `level` back to back, as Layout() places them
+  [[nodiscard]] std::span<const std::uint8_t> LevelData(int level) const {
+    return levels_[level].texels;
+  }
+
+  // Texel at (x, y) of `level`, clamped to its edges
+  [[nodiscard]] Texel TexelAt(int level, int x, int y) const;
+
+  // Bytes of texels over all levels, padding included
+  [[nodiscard]] std::size_t MemoryBytes() const;
+
+ private:
+  struct Level {
+    TileLayout layout;
+    std::vector<std::uint8_t> texels;
+  };
+
+  std::vector<Level> levels_;
+};
+
+namespace detail {
+constexpr double kByteScale = 1.0 / 255.0;
+
+inline PixelF64 ToPixel(const Texel& texel) {
+  return {kByteScale * texel[0], kByteScale * texel[1],
+          kByteScale * texel[2]};
+}
+
+inline PixelF64 Lerp(const PixelF64& a, const PixelF64& b, double t) {
+  return {a.R() + t * (b.R() - a.R()), a.G() + t * (b.G() - a.G()),
+          a.B() + t * (b.B() - a.B())};
+}
+}  // namespace detail
+
+// Lookups at (s, t) in any image holding mip levels, with [0, 1] spanning
+// the image left to right and top to bottom. `Image` provides Levels(),
+// Width(level), Height(level) and TexelAt(level, x, y), clamped to edges.
+template <typename Image>
+[[nodiscard]] PixelF64 NearestLookup(const Image& image, int level, double s,
+                                     double t) {
+  return detail::ToPixel(
+      image.TexelAt(level, static_cast<int>(s * image.Width(level)),
+                    static_cast<int>(t * image.Height(level))));
+}
+
+template <typename Image>
+[[nodiscard]] PixelF64 BilinearLookup(const Image& image, int level, double s,
+                                      double t) {
+  // Texel centres sit at half-integer positions
+  const auto x = s * image.Width(level) - 0.5;
+  const auto y = t * image.Height(level) - 0.5;
+  const auto x0 = std::floor(x);
+  const auto y0 = std::floor(y);
+  const auto ix = static_cast<int>(x0);
+  const auto iy = static_cast<int>(y0);
+
+  using detail::Lerp;
+  using detail::ToPixel;
+  const auto top = Lerp(ToPixel(image.TexelAt(level, ix, iy)),
+                        ToPixel(image.TexelAt(level, ix + 1, iy)), x - x0);
+  const auto bottom =
+      Lerp(ToPixel(image.TexelAt(level, ix, iy + 1)),
+           ToPixel(image.TexelAt(level, ix + 1, iy + 1)), x - x0);
+  return Lerp(top, bottom, y - y0);
+}
+
+// `width` is the size of the footprint in the units of (s, t)
+template <typename Image>
+[[nodiscard]] PixelF64 TrilinearLookup(const Image& image, double s, double t,
+                                       double width) {
+  // Level whose texels are as wide as the footprint
+  const auto texels = width * std::max(image.Width(0), image.Height(0));
+  if (!(texels > 1.0)) {
+    return BilinearLookup(image, 0, s, t);
+  }
+  const auto last = image.Levels() - 1;
+  const auto lod = std::min(std::log2(texels), static_cast<double>(last));
+  const auto level = static_cast<int>(lod);
+  if (level == last) {
+    return BilinearLookup(image, level, s, t);
+  }
+  return detail::Lerp(BilinearLookup(image, level, s, t),
+                      BilinearLookup(image, level + 1, s, t), lod - level);
+}
+
+template <typename Image>
+[[nodiscard]] PixelF64 FilteredLookup(const Image& image, TextureFilter filter,
+                                      double s, double t, double width) {
+  switch (filter) {
+    case TextureFilter::Nearest:
+      return NearestLookup(image, 0, s, t);
+    case TextureFilter::Bilinear:
+      return BilinearLookup(image, 0, s, t);
+    case TextureFilter::Trilinear:
+      break;
+  }
+  return TrilinearLookup(image, s, t, width);
+}
+
+}  // namespace polaris::image
+
+#endif
@@ -3,17 +3,22 @@
 
 namespace polaris::image {
 namespace {
-double LinearToGamma(double v) { return v > 0 ? std::sqrt(v) : 0; }
+template <std::floating_point T>
+T LinearToGamma(T v) { return v > 0 ? std::sqrt(v) : 0; }
 }  // anonymous namespace
 
-PixelU8 PixelF64::AsU8() const {
-  double gR = LinearToGamma(r);
-  double gG = LinearToGamma(g);
-  double gB = LinearToGamma(b);
+template <std::floating_point T>
+PixelU8 BasicPixel<T>::AsU8() const {
+  T gR = LinearToGamma(r);
+  T gG = LinearToGamma(g);
+  T gB = LinearToGamma(b);
 
-  static const math::Interval intensity(0, 0.9999);
+  static const math::BasicInterval<T> intensity(0, T(0.9999));
   return PixelU8(static_cast<int>(intensity.Clamp(gR) * 256),
                  static_cast<int>(intensity.Clamp(gG) * 256),
                  static_cast<int>(intensity.Clamp(gB) * 256));
 }
+
+template class BasicPixel<float>;
+template class BasicPixel<double>;
 }  // namespace polaris::image
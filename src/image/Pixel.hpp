@@ -1,6 +1,8 @@
 #ifndef POLARIS_IMAGE_PIXEL_HPP
 #define POLARIS_IMAGE_PIXEL_HPP
 
+#include <concepts>
+#include <cstdint>
 #include <fstream>
 #include <math/Vec.hpp>
 
@@ -30,74 +32,88 @@ class PixelU8 {
   std::uint8_t r = 0, g = 0, b = 0;
 };
 
-// Pixel is stored as floating point values in the range [0.0, 1.0]
-class PixelF64 {
+// Pixel is stored as floating point values in the range [0.0, 1.0]. Colour
+// stays in double by default even when geometry is traced in float, since it
+// is what samples accumulate into.
+template <std::floating_point T>
+class BasicPixel {
  public:
-  PixelF64() : r(0.0f), g(0.0f), b(0.0f) {}
-  PixelF64(double _r, double _g, double _b) : r(_r), g(_g), b(_b) {}
-  explicit PixelF64(const polaris::math::Vec3& v)
+  BasicPixel() : r(0), g(0), b(0) {}
+  BasicPixel(T _r, T _g, T _b) : r(_r), g(_g), b(_b) {}
+  explicit BasicPixel(const polaris::math::Vec3& v)
       : r(v.X()), g(v.Y()), b(v.Z()) {}
+  template <std::floating_point U>
+  explicit BasicPixel(const BasicPixel<U>& p)
+      : r(static_cast<T>(p.R())),
+        g(static_cast<T>(p.G())),
+        b(static_cast<T>(p.B())) {}
 
-  [[nodiscard]] double R() const { return r; }
-  [[nodiscard]] double G() const { return g; }
-  [[nodiscard]] double B() const { return b; }
+  [[nodiscard]] T R() const { return r; }
+  [[nodiscard]] T G() const { return g; }
+  [[nodiscard]] T B() const { return b; }
 
   [[nodiscard]] PixelU8 AsU8() const;
 
   // clang-format off
-  PixelF64& operator+=(const PixelF64& o) { r += o.r; g += o.g; b += o.b; return *this; }
-  PixelF64& operator-=(const PixelF64& o) { r -= o.r; g -= o.g; b -= o.b; return *this; }
-  PixelF64& operator*=(const PixelF64& o) { r *= o.r; g *= o.g; b *= o.b; return *this; }
-  PixelF64& operator/=(const PixelF64& o) { r /= o.r; g /= o.g; b /= o.b; return *this; }
+  BasicPixel& operator+=(const BasicPixel& o) { r += o.r; g += o.g; b += o.b; return *this; }
+  BasicPixel& operator-=(const BasicPixel& o) { r -= o.r; g -= o.g; b -= o.b; return *this; }
+  BasicPixel& operator*=(const BasicPixel& o) { r *= o.r; g *= o.g; b *= o.b; return *this; }
+  BasicPixel& operator/=(const BasicPixel& o) { r /= o.r; g /= o.g; b /= o.b; return *this; }
 
   // Interop with math::Vec3 (component-wise operations)
-  PixelF64& operator+=(const polaris::math::Vec3& v) { r += v.X(); g += v.Y(); b += v.Z(); return *this; }
-  PixelF64& operator-=(const polaris::math::Vec3& v) { r -= v.X(); g -= v.Y(); b -= v.Z(); return *this; }
-  PixelF64& operator*=(const polaris::math::Vec3& v) { r *= v.X(); g *= v.Y(); b *= v.Z(); return *this; }
-  PixelF64& operator/=(const polaris::math::Vec3& v) { r /= v.X(); g /= v.Y(); b /= v.Z(); return *this; }
+  BasicPixel& operator+=(const polaris::math::Vec3& v) { r += v.X(); g += v.Y(); b += v.Z(); return *this; }
+  BasicPixel& operator-=(const polaris::math::Vec3& v) { r -= v.X(); g -= v.Y(); b -= v.Z(); return *this; }
+  BasicPixel& operator*=(const polaris::math::Vec3& v) { r *= v.X(); g *= v.Y(); b *= v.Z(); return *this; }
+  BasicPixel& operator/=(const polaris::math::Vec3& v) { r /= v.X(); g /= v.Y(); b /= v.Z(); return *this; }
 
-  PixelF64& operator+=(double s) { r += s; g += s; b += s; return *this; }
-  PixelF64& operator-=(double s) { r -= s; g -= s; b -= s; return *this; }
-  PixelF64& operator*=(double s) { r *= s; g *= s; b *= s; return *this; }
-  PixelF64& operator/=(double s) { const double inv = 1.0f / s; r *= inv; g *= inv; b *= inv; return *this; }
+  BasicPixel& operator+=(T s) { r += s; g += s; b += s; return *this; }
+  BasicPixel& operator-=(T s) { r -= s; g -= s; b -= s; return *this; }
+  BasicPixel& operator*=(T s) { r *= s; g *= s; b *= s; return *this; }
+  BasicPixel& operator/=(T s) { const T inv = T(1) / s; r *= inv; g *= inv; b *= inv; return *this; }
 
-  PixelF64 operator+() const { return *this; }
-  PixelF64 operator-() const { return PixelF64{-r, -g, -b}; }
+  BasicPixel operator+() const { return *this; }
+  BasicPixel operator-() const { return BasicPixel{-r, -g, -b}; }
 
-  PixelF64 operator+(const PixelF64& o) const { PixelF64 t = *this; t += o; return t; }
-  PixelF64 operator-(const PixelF64& o) const { PixelF64 t = *this; t -= o; return t; }
-  PixelF64 operator*(const PixelF64& o) const { PixelF64 t = *this; t *= o; return t; }
-  PixelF64 operator/(const PixelF64& o) const { PixelF64 t = *this; t /= o; return t; }
+  BasicPixel operator+(const BasicPixel& o) const { BasicPixel t = *this; t += o; return t; }
+  BasicPixel operator-(const BasicPixel& o) const { BasicPixel t = *this; t -= o; return t; }
+  BasicPixel operator*(const BasicPixel& o) const { BasicPixel t = *this; t *= o; return t; }
+  BasicPixel operator/(const BasicPixel& o) const { BasicPixel t = *this; t /= o; return t; }
 
-  PixelF64 operator+(const polaris::math::Vec3& v) const { PixelF64 t = *this; t += v; return t; }
-  PixelF64 operator-(const polaris::math::Vec3& v) const { PixelF64 t = *this; t -= v; return t; }
-  PixelF64 operator*(const polaris::math::Vec3& v) const { PixelF64 t = *this; t *= v; return t; }
-  PixelF64 operator/(const polaris::math::Vec3& v) const { PixelF64 t = *this; t /= v; return t; }
+  BasicPixel operator+(const polaris::math::Vec3& v) const { BasicPixel t = *this; t += v; return t; }
+  BasicPixel operator-(const polaris::math::Vec3& v) const { BasicPixel t = *this; t -= v; return t; }
+  BasicPixel operator*(const polaris::math::Vec3& v) const { BasicPixel t = *this; t *= v; return t; }
+  BasicPixel operator/(const polaris::math::Vec3& v) const { BasicPixel t = *this; t /= v; return t; }
 
-  PixelF64 operator+(double s) const { PixelF64 t = *this; t += s; return t; }
-  PixelF64 operator-(double s) const { PixelF64 t = *this; t -= s; return t; }
-  PixelF64 operator*(double s) const { PixelF64 t = *this; t *= s; return t; }
-  PixelF64 operator/(double s) const { PixelF64 t = *this; t /= s; return t; }
+  BasicPixel operator+(T s) const { BasicPixel t = *this; t += s; return t; }
+  BasicPixel operator-(T s) const { BasicPixel t = *this; t -= s; return t; }
+  BasicPixel operator*(T s) const { BasicPixel t = *this; t *= s; return t; }
+  BasicPixel operator/(T s) const { BasicPixel t = *this; t /= s; return t; }
 
-  friend PixelF64 operator*(double s, const PixelF64& p) { return p * s; }
-  friend PixelF64 operator+(double s, const PixelF64& p) { return p + s; }
+  friend BasicPixel operator*(T s, const BasicPixel& p) { return p * s; }
+  friend BasicPixel operator+(T s, const BasicPixel& p) { return p + s; }
 
   // Symmetric free operators with Vec3 on the left-hand side
-  friend PixelF64 operator+(const polaris::math::Vec3& v, const PixelF64& p) { return p + v; }
-  friend PixelF64 operator*(const polaris::math::Vec3& v, const PixelF64& p) { return p * v; }
-  friend PixelF64 operator-(const polaris::math::Vec3& v, const PixelF64& p) { return {v.X() - p.r, v.Y() - p.g, v.Z() - p.b}; }
-  friend PixelF64 operator/(const polaris::math::Vec3& v, const PixelF64& p) { return {v.X() / p.r, v.Y() / p.g, v.Z() / p.b}; }
+  friend BasicPixel operator+(const polaris::math::Vec3& v, const BasicPixel& p) { return p + v; }
+  friend BasicPixel operator*(const polaris::math::Vec3& v, const BasicPixel& p) { return p * v; }
+  friend BasicPixel operator-(const polaris::math::Vec3& v, const BasicPixel& p) { return BasicPixel(v.X() - p.r, v.Y() - p.g, v.Z() - p.b); }
+  friend BasicPixel operator/(const polaris::math::Vec3& v, const BasicPixel& p) { return BasicPixel(v.X() / p.r, v.Y() / p.g, v.Z() / p.b); }
 
-  bool operator==(const PixelF64& o) const { return r == o.r && g == o.g && b == o.b; }
-  bool operator!=(const PixelF64& o) const { return !(*this == o); }
+  bool operator==(const BasicPixel& o) const { return r == o.r && g == o.g && b == o.b; }
+  bool operator!=(const BasicPixel& o) const { return !(*this == o); }
 
   explicit operator PixelU8() const { return AsU8(); }
   // clang-format on
 
  private:
-  double r, g, b;
+  T r, g, b;
 };
 
+using PixelF64 = BasicPixel<double>;
+using PixelF32 = BasicPixel<float>;
+
+extern template class BasicPixel<float>;
+extern template class BasicPixel<double>;
+
 }  // namespace polaris::image
 
 #endif
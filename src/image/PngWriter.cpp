@@ -0,0 +1,212 @@
+#ifdef POLARIS_HAS_ZLIB
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <image/PngWriter.hpp>
+#include <span>
+#include <vector>
+
+namespace polaris::image {
+namespace {
+constexpr std::size_t kChannels = 3;
+constexpr std::size_t kBandBytes = std::size_t{1} << 20;  // Filtered input
+constexpr std::size_t kWindowSize = std::size_t{1} << 15;  // Deflate window
+// Level 1 already beats stb_image_write's default on size for renders and
+// is several times faster than zlib's default level
+constexpr int kCompressionLevel = Z_BEST_SPEED;
+
+void WriteBigEndian(std::ostream& out, std::uint32_t value) {
+  const std::array<char, 4> bytes = {
+      static_cast<char>(value >> 24U), static_cast<char>(value >> 16U),
+      static_cast<char>(value >> 8U), static_cast<char>(value)};
+  out.write(bytes.data(), bytes.size());
+}
+
+void WriteChunk(std::ostream& out, const char (&type)[5],
+                std::span<const std::uint8_t> data) {
+  WriteBigEndian(out, static_cast<std::uint32_t>(data.size()));
+  out.write(type, 4);
+  out.write(reinterpret_cast<const char*>(data.data()),
+            static_cast<std::streamsize>(data.size()));
+
+  auto crc = crc32(0, reinterpret_cast<const Bytef*>(type), 4);
+  if (!data.empty()) {
+    crc = crc32_z(crc, data.data(), data.size());
+  }
+  WriteBigEndian(out, static_cast<std::uint32_t>(crc));
+}
+
+int Paeth(int a, int b, int c) {
+  const int p = a + b - c;
+  const int pa = std::abs(p - a);
+  const int pb = std::abs(p - b);
+  const int pc = std::abs(p - c);
+  if (pa <= pb && pa <= pc) {
+    return a;
+  }
+  return pb <= pc ? b : c;
+}
+
+// Filters one row into `out` (filter byte first) with whichever of the five
+// PNG filters gives the smallest sum of absolute values, the usual heuristic.
+// `prev` is the row above, all zeros for the first row.
+void FilterRow(const std::uint8_t* row, const std::uint8_t* prev,
+               std::size_t stride, std::uint8_t* out,
+               std::vector<std::uint8_t>& scratch) {
+  scratch.resize(stride);
+  std::uint64_t best_cost = ~std::uint64_t{0};
+
+  const auto try_filter = [&](std::uint8_t filter, auto predict) {
+    std::uint64_t cost = 0;
+    const auto emit = [&](std::size_t i, int predicted) {
+      const auto value = static_cast<std::uint8_t>(row[i] - predicted);
+      scratch[i] = value;
+      cost += static_cast<std::uint64_t>(
+          std::abs(static_cast<int>(static_cast<std::int8_t>(value))));
+    };
+
+    // The first pixel has no left neighbour
+    for (std::size_t i = 0; i < std::min(kChannels, stride); ++i) {
+      emit(i, predict(0, prev[i], 0));
+    }
+    for (std::size_t i = kChannels; i < stride; ++i) {
+      emit(i, predict(row[i - kChannels], prev[i], prev[i - kChannels]));
+    }
+
+    if (cost < best_cost) {
+      best_cost = cost;
+      out[0] = filter;
+      std::copy_n(scratch.data(), stride, out + 1);
+    }
+  };
+
+  try_filter(0, [](int, int, int) { return 0; });
+  try_filter(1, [](int a, int, int) { return a; });
+  try_filter(2, [](int, int b, int) { return b; });
+  try_filter(3, [](int a, int b, int) { return (a + b) / 2; });
+  try_filter(4, [](int a, int b, int c) { return Paeth(a, b, c); });
+}
+}  // namespace
+
+bool WritePng(std::ostream& out, const std::uint8_t* rgb, std::size_t width,
+              std::size_t height, util::ThreadPool& pool) {
+  if (width == 0 || height == 0) {
+    return false;
+  }
+
+  const std::size_t stride = width * kChannels;
+  const std::size_t filtered_stride = stride + 1;
+  const std::size_t rows_per_band =
+      std::max<std::size_t>(1, kBandBytes / filtered_stride);
+  const std::size_t band_count = (height + rows_per_band - 1) / rows_per_band;
+
+  // Filtering only looks one row up, so bands filter independently
+  std::vector<std::uint8_t> filtered(filtered_stride * height);
+  {
+    util::TaskGroup group(pool);
+    for (std::size_t band = 0; band < band_count; ++band) {
+      group.Run([&, band] {
+        std::vector<std::uint8_t> scratch;
+        const std::vector<std::uint8_t> zero_row(stride);
+        const auto last = std::min(height, (band + 1) * rows_per_band);
+        for (auto y = band * rows_per_band; y < last; ++y) {
+          FilterRow(rgb + (y * stride),
+                    y > 0 ? rgb + ((y - 1) * stride) : zero_row.data(), stride,
+                    filtered.data() + (y * filtered_stride), scratch);
+        }
+      });
+    }
+    group.Wait();
+  }
+
+  // Each band is a raw deflate stream ending on a byte boundary (a sync
+  // flush), so the bands concatenate into one zlib stream
+  struct Band {
+    std::vector<std::uint8_t> data;
+    uLong adler = 1;
+    std::size_t size = 0;
+    bool ok = false;
+  };
+  std::vector<Band> bands(band_count);
+  {
+    util::TaskGroup group(pool);
+    for (std::size_t i = 0; i < band_count; ++i) {
+      group.Run([&, i] {
+        const std::size_t begin = i * rows_per_band * filtered_stride;
+        const std::size_t end =
+            std::min(height, (i + 1) * rows_per_band) * filtered_stride;
+        auto* input = filtered.data() + begin;
+        auto& band = bands[i];
+        band.size = end - begin;
+        band.adler = adler32_z(1, input, band.size);
+
+        z_stream stream{};
+        if (deflateInit2(&stream, kCompressionLevel, Z_DEFLATED, -15, 8,
+                         Z_DEFAULT_STRATEGY) != Z_OK) {
+          return;
+        }
+        if (begin > 0) {
+          const auto window = std::min(begin, kWindowSize);
+          deflateSetDictionary(&stream, input - window,
+                               static_cast<uInt>(window));
+        }
+
+        band.data.resize(deflateBound(&stream, band.size) + 16);
+        stream.next_in = input;
+        stream.avail_in = static_cast<uInt>(band.size);
+        stream.next_out = band.data.data();
+        stream.avail_out = static_cast<uInt>(band.data.size());
+        const bool last = i + 1 == band_count;
+        const int result = deflate(&stream, last ? Z_FINISH : Z_SYNC_FLUSH);
+        band.ok = result == (last ? Z_STREAM_END : Z_OK) &&
+                  stream.avail_in == 0;
+        band.data.resize(stream.total_out);
+        deflateEnd(&stream);
+      });
+    }
+    group.Wait();
+  }
+  if (!std::ranges::all_of(bands, &Band::ok)) {
+    return false;
+  }
+
+  constexpr std::array<std::uint8_t, 8> kSignature = {0x89, 'P',  'N',  'G',
+                                                      '\r', '\n', 0x1a, '\n'};
+  out.write(reinterpret_cast<const char*>(kSignature.data()),
+            kSignature.size());
+
+  std::array<std::uint8_t, 13> header{};
+  for (int i = 0; i < 4; ++i) {
+    header[i] = static_cast<std::uint8_t>(width >> (24 - (8 * i)));
+    header[4 + i] = static_cast<std::uint8_t>(height >> (24 - (8 * i)));
+  }
+  header[8] = 8;  // Bits per channel
+  header[9] = 2;  // Truecolour
+  WriteChunk(out, "IHDR", header);
+
+  // zlib header, then one IDAT chunk per band, then the Adler-32 of all of
+  // the filtered data
+  constexpr std::array<std::uint8_t, 2> kZlibHeader = {0x78, 0x9c};
+  WriteChunk(out, "IDAT", kZlibHeader);
+  uLong adler = 1;
+  for (const auto& band : bands) {
+    WriteChunk(out, "IDAT", band.data);
+    adler = adler32_combine(adler, band.adler,
+                            static_cast<z_off_t>(band.size));
+  }
+  const std::array<std::uint8_t, 4> trailer = {
+      static_cast<std::uint8_t>(adler >> 24U),
+      static_cast<std::uint8_t>(adler >> 16U),
+      static_cast<std::uint8_t>(adler >> 8U), static_cast<std::uint8_t>(adler)};
+  WriteChunk(out, "IDAT", trailer);
+  WriteChunk(out, "IEND", {});
+
+  return static_cast<bool>(out);
+}
+
+}  // namespace polaris::image
+
+#endif
@@ -0,0 +1,22 @@
+#ifndef POLARIS_IMAGE_PNG_WRITER_HPP
+#define POLARIS_IMAGE_PNG_WRITER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <util/ThreadPool.hpp>
+
+namespace polaris::image {
+
+// Encodes tightly packed 8-bit RGB as PNG using zlib. The image is cut into
+// bands of rows which are filtered and deflated as separate tasks on `pool`,
+// each band primed with the end of the one before so the result compresses
+// about as well as a single stream. Only built when zlib is available
+// (POLARIS_HAS_ZLIB). False if zlib fails, in which case nothing has been
+// written, or if writing to `out` fails.
+bool WritePng(std::ostream& out, const std::uint8_t* rgb, std::size_t width,
+              std::size_t height, util::ThreadPool& pool);
+
+}  // namespace polaris::image
+
+#endif
@@ -5,12 +5,17 @@
     #pragma warning (push, 0)
 #endif
 
-#define STB_IMAGE_IMPLEMENTATION
-#define STBI_FAILURE_USERMSG
+// The stb_image implementation is compiled once, in RTWImage.cpp
 #include <external/stb_image.h>
 
+#include <array>
+#include <cmath>
 #include <cstdlib>
+#include <filesystem>
 #include <iostream>
+#include <string>
+#include <system_error>
+#include <vector>
 
 namespace polaris::image {
 class RTWImage {
@@ -18,39 +23,52 @@ public:
   RTWImage() = default; // seems wrong...
 
   explicit RTWImage(const char* image_filename) {
-    auto filename = std::string(image_filename);
-    auto *imagedir = getenv("RTW_IMAGES");
-
-    if (imagedir && load(std::string(imagedir) + "/" + image_filename)) return;
-    if (load(filename)) return;
-    if (load("images/" + filename)) return;
-    if (load("../images/" + filename)) return;
-    if (load("../../images/" + filename)) return;
-    if (load("../../../images/" + filename)) return;
-    if (load("../../../../images/" + filename)) return;
-    if (load("../../../../../images/" + filename)) return;
-    if (load("../../../../../../images/" + filename)) return;
+    for (const auto& candidate : Candidates(image_filename)) {
+      if (load(candidate)) return;
+    }
 
     std::cerr << "ERROR: Could not load image file '" << image_filename << "'.\n";
   }
 
+  // First of the places the constructor looks in that holds a file called
+  // `image_filename`, or an empty string
+  [[nodiscard]] static std::string FindFile(const char* image_filename) {
+    for (const auto& candidate : Candidates(image_filename)) {
+      std::error_code ec;
+      if (std::filesystem::is_regular_file(candidate, ec)) return candidate;
+    }
+    return {};
+  }
+
   ~RTWImage() {
     delete[] bdata_;
-    STBI_FREE(fdata_);
   }
 
   [[nodiscard]] bool load(const std::string& filename) {
+    // High dynamic range files are read as floats and clamped; others are
+    // read as bytes, skipping the float copy of the image
     auto n = bytes_per_pixel_;
-    fdata_ = stbi_loadf(filename.c_str(), &image_width_, &image_height_, &n, bytes_per_pixel_);
-    if (fdata_ == nullptr) return false;
+    if (stbi_is_hdr(filename.c_str()) != 0) {
+      auto *fdata = stbi_loadf(filename.c_str(), &image_width_, &image_height_, &n, bytes_per_pixel_);
+      if (fdata == nullptr) return false;
+      ConvertToBytes(fdata);
+      stbi_image_free(fdata);
+    } else {
+      auto *data = stbi_load(filename.c_str(), &image_width_, &image_height_, &n, bytes_per_pixel_);
+      if (data == nullptr) return false;
+      LinearizeBytes(data);
+      stbi_image_free(data);
+    }
 
     bytes_per_scanline_ = image_width_ * bytes_per_pixel_;
-    ConvertToBytes();
     return true;
   }
 
-  [[nodiscard]] int Width() const { return (fdata_ == nullptr) ? 0 : image_width_; }
-  [[nodiscard]] int Height() const { return (fdata_ == nullptr) ? 0 : image_height_; }
+  [[nodiscard]] int Width() const { return (bdata_ == nullptr) ? 0 : image_width_; }
+  [[nodiscard]] int Height() const { return (bdata_ == nullptr) ? 0 : image_height_; }
+
+  // All texels, a row at a time from the top
+  [[nodiscard]] const unsigned char* Data() const { return bdata_; }
 
   [[nodiscard]] const unsigned char* PixelData(int x, int y) const {
     static unsigned char magenta[] = { 255, 0, 255 };
@@ -64,12 +82,27 @@ public:
 
 private:
   const int bytes_per_pixel_ = 3;
-  float* fdata_ = nullptr;
   unsigned char* bdata_ = nullptr;
   int image_width_ = 0;
   int image_height_ = 0;
   int bytes_per_scanline_ = 0;
 
+  // Paths tried in turn: $RTW_IMAGES, the name itself, then images/ in
+  // the working directory and up to six directories above it
+  [[nodiscard]] static std::vector<std::string> Candidates(const char* image_filename) {
+    auto filename = std::string(image_filename);
+    std::vector<std::string> candidates;
+    if (auto *imagedir = getenv("RTW_IMAGES")) {
+      candidates.push_back(std::string(imagedir) + "/" + filename);
+    }
+    candidates.push_back(filename);
+    std::string prefix = "images/";
+    for (auto up = 0; up <= 6; up++, prefix = "../" + prefix) {
+      candidates.push_back(prefix + filename);
+    }
+    return candidates;
+  }
+
   [[nodiscard]] static int Clamp(int x, int low, int high) {
     if (x < low) return low;
     if (x < high) return x;
@@ -84,16 +117,34 @@ private:
     return static_cast<unsigned char>(256.0 * value);
   }
 
-  void ConvertToBytes() {
+  void ConvertToBytes(const float* fdata) {
     int total_bytes = image_width_ * image_height_ * bytes_per_pixel_;
     bdata_ = new unsigned char[total_bytes];
 
     auto *bptr = bdata_;
-    auto *fptr = fdata_;
+    const auto *fptr = fdata;
     for (auto i = 0; i < total_bytes; i++, fptr++, bptr++) {
       *bptr = FloatToByte(*fptr);
     }
   }
+
+  // The bytes stbi_loadf() and ConvertToBytes() make of each 8-bit value,
+  // which undoes the file's gamma of 2.2
+  void LinearizeBytes(const unsigned char* data) {
+    static const auto table = [] {
+      std::array<unsigned char, 256> entries{};
+      for (auto i = 0; i < 256; i++) {
+        entries[i] = FloatToByte(static_cast<float>(std::pow(static_cast<float>(i) / 255.0f, 2.2f)));
+      }
+      return entries;
+    }();
+
+    int total_bytes = image_width_ * image_height_ * bytes_per_pixel_;
+    bdata_ = new unsigned char[total_bytes];
+    for (auto i = 0; i < total_bytes; i++) {
+      bdata_[i] = table[data[i]];
+    }
+  }
 };
 } // namespace polaris::image
 
@@ -0,0 +1,155 @@
+#include <algorithm>
+#include <image/TileCache.hpp>
+#include <utility>
+
+namespace polaris::image {
+
+TileCache& TileCache::Shared() {
+  static TileCache cache(0);
+  return cache;
+}
+
+void TileCache::SetBudget(std::size_t budget_bytes) {
+  const std::scoped_lock lock(mutex_);
+  max_frames_ = std::max(budget_bytes / kFrameBytes, kMinFrames);
+}
+
+std::shared_ptr<PagedImage> TileCache::Add(TiledImage file) {
+  return std::make_shared<PagedImage>(*this, std::move(file));
+}
+
+TileCacheStats TileCache::Stats() const {
+  const std::scoped_lock lock(mutex_);
+  TileCacheStats stats;
+  stats.hits = hits_.load(std::memory_order_relaxed);
+  stats.misses = misses_;
+  stats.evictions = evictions_;
+  stats.resident_bytes = frames_.size() * kFrameBytes;
+  stats.budget_bytes = max_frames_ * kFrameBytes;
+  return stats;
+}
+
+void TileCache::CountHit() {
+  thread_local std::uint64_t tls_hits = 0;
+  if (++tls_hits == kHitBatch) {
+    hits_.fetch_add(kHitBatch, std::memory_order_relaxed);
+    tls_hits = 0;
+  }
+}
+
+TileCache::Frame* TileCache::TakeFrame() {
+  if (frames_.size() < max_frames_) {
+    frames_.push_back(arena_.Create<Frame>());
+    return frames_.back();
+  }
+
+  // Frames used since the hand last passed get another round; the hand
+  // clears their mark as it goes, so it stops within two turns
+  for (;;) {
+    auto* frame = frames_[hand_];
+    hand_ = (hand_ + 1) % frames_.size();
+    if (frame->owner.load(std::memory_order_relaxed) == nullptr ||
+        !frame->referenced.exchange(false, std::memory_order_relaxed)) {
+      return frame;
+    }
+  }
+}
+
+void TileCache::Fault(const PagedImage& image, int level, std::size_t tile) {
+  const std::scoped_lock lock(mutex_);
+  auto& slot = image.slots_[level][tile];
+  if (slot.load(std::memory_order_relaxed) != nullptr) {
+    return;
+  }
+  ++misses_;
+
+  // Written as a seqlock: lookups that overlap the refill see an odd or
+  // changed version and try again
+  auto* frame = TakeFrame();
+  const auto version = frame->version.load(std::memory_order_relaxed);
+  frame->version.store(version + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  if (const auto* owner = frame->owner.load(std::memory_order_relaxed)) {
+    const_cast<Slot*>(owner)->store(nullptr, std::memory_order_relaxed);
+    ++evictions_;
+  }
+  frame->owner.store(&slot, std::memory_order_relaxed);
+  const auto bytes = image.file_.Tile(level, tile);
+  for (std::size_t i = 0; i < bytes.size(); ++i) {
+    std::atomic_ref(frame->texels[i]).store(bytes[i],
+                                            std::memory_order_relaxed);
+  }
+  frame->referenced.store(true, std::memory_order_relaxed);
+
+  frame->version.store(version + 2, std::memory_order_release);
+  slot.store(frame, std::memory_order_release);
+  image.file_.Release(level, tile);
+}
+
+void TileCache::Drop(const PagedImage& image) {
+  const std::scoped_lock lock(mutex_);
+  for (int level = 0; level < image.Levels(); ++level) {
+    const auto tiles = image.file_.Layout(level).TileCount();
+    for (std::size_t tile = 0; tile < tiles; ++tile) {
+      auto* frame = image.slots_[level][tile].load(std::memory_order_relaxed);
+      if (frame != nullptr) {
+        frame->owner.store(nullptr, std::memory_order_relaxed);
+        frame->referenced.store(false, std::memory_order_relaxed);
+      }
+    }
+  }
+}
+
+PagedImage::PagedImage(TileCache& cache, TiledImage file)
+    : cache_(cache), file_(std::move(file)) {
+  for (int level = 0; level < file_.Levels(); ++level) {
+    slots_.push_back(
+        std::make_unique<TileCache::Slot[]>(file_.Layout(level).TileCount()));
+  }
+}
+
+PagedImage::~PagedImage() { cache_.Drop(*this); }
+
+Texel PagedImage::TexelAt(int level, int x, int y) const {
+  const auto& layout = file_.Layout(level);
+  x = std::clamp(x, 0, layout.width - 1);
+  y = std::clamp(y, 0, layout.height - 1);
+  const auto tile = layout.Tile(x, y);
+  const auto offset = layout.WithinTile(x, y);
+  const auto& slot = slots_[level][tile];
+
+  for (bool faulted = false;; faulted = true) {
+    auto* frame = slot.load(std::memory_order_acquire);
+    if (frame == nullptr) {
+      cache_.Fault(*this, level, tile);
+      continue;
+    }
+
+    const auto version = frame->version.load(std::memory_order_acquire);
+    if ((version & 1U) != 0 ||
+        frame->owner.load(std::memory_order_relaxed) != &slot) {
+      continue;
+    }
+    Texel texel;
+    for (std::size_t k = 0; k < texel.size(); ++k) {
+      texel[k] = std::atomic_ref(frame->texels[offset + k])
+                     .load(std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (frame->version.load(std::memory_order_relaxed) != version) {
+      continue;
+    }
+
+    // Only written when clear, so hot tiles stay shared between cores
+    if (!frame->referenced.load(std::memory_order_relaxed)) {
+      frame->referenced.store(true, std::memory_order_relaxed);
+    }
+    if (!faulted) {
+      cache_.CountHit();
+    }
+    return texel;
+  }
+}
+
+}  // namespace polaris::image
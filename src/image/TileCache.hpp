@@ -0,0 +1,120 @@
+#ifndef POLARIS_IMAGE_TILE_CACHE_HPP
+#define POLARIS_IMAGE_TILE_CACHE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <image/MipMap.hpp>
+#include <image/TiledImage.hpp>
+#include <memory>
+#include <mutex>
+#include <util/Arena.hpp>
+#include <vector>
+
+namespace polaris::image {
+
+class PagedImage;
+
+struct TileCacheStats {
+  std::uint64_t hits = 0;       // Lookups finding their tile in memory
+  std::uint64_t misses = 0;     // Tiles read in from their files
+  std::uint64_t evictions = 0;  // Tiles dropped to make room
+  std::size_t resident_bytes = 0;
+  std::size_t budget_bytes = 0;
+};
+
+// Tiles of paged images, held in a fixed budget of memory. Tiles are read
+// from their mapped files on first use into frames of the cache and, once
+// the budget is spent, take over the frame least recently used, as told by
+// the clock algorithm. Lookups take no lock: each reads the frame its tile
+// is in and checks the frame's version afterwards, trying again if the
+// frame was refilled meanwhile. Only reading a tile in takes the lock.
+class TileCache {
+ public:
+  explicit TileCache(std::size_t budget_bytes) { SetBudget(budget_bytes); }
+
+  TileCache(const TileCache&) = delete;
+  TileCache& operator=(const TileCache&) = delete;
+
+  // The cache image textures share
+  [[nodiscard]] static TileCache& Shared();
+
+  // At least kMinFrames tiles are kept whatever the budget, so the lookups
+  // of one filtered sample never push each other out. A smaller budget only
+  // stops the cache from growing; it never gives back memory.
+  void SetBudget(std::size_t budget_bytes);
+
+  // Pages `file` through the cache. The image must not outlive the cache.
+  [[nodiscard]] std::shared_ptr<PagedImage> Add(TiledImage file);
+
+  // Hits are counted by each thread and added in batches, so they may trail
+  // the lookups made by up to kHitBatch per thread
+  [[nodiscard]] TileCacheStats Stats() const;
+
+  static constexpr std::size_t kFrameBytes =
+      3 * TileLayout::kMaxTileSize * TileLayout::kMaxTileSize;
+  static constexpr std::size_t kMinFrames = 64;
+  static constexpr std::uint64_t kHitBatch = 1024;
+
+ private:
+  friend class PagedImage;
+
+  struct Frame;
+  using Slot = std::atomic<Frame*>;
+
+  struct Frame {
+    std::atomic<std::uint32_t> version{0};  // Odd while being refilled
+    std::atomic<bool> referenced{false};    // Used since the clock passed
+    std::atomic<const Slot*> owner{nullptr};  // Slot of the tile held
+    std::uint8_t texels[kFrameBytes];
+  };
+
+  // Reads a tile of `image` into a frame unless another thread has already
+  void Fault(const PagedImage& image, int level, std::size_t tile);
+  // Frame to hold a new tile; called with the lock held
+  [[nodiscard]] Frame* TakeFrame();
+  // Frees the frames of an image going away
+  void Drop(const PagedImage& image);
+  void CountHit();
+
+  mutable std::mutex mutex_;
+  util::Arena arena_;            // Frames, which are never freed
+  std::vector<Frame*> frames_;   // In clock order
+  std::size_t hand_ = 0;         // Next frame the clock looks at
+  std::size_t max_frames_ = kMinFrames;
+  std::atomic<std::uint64_t> hits_{0};
+  std::uint64_t misses_ = 0;
+  std::uint64_t evictions_ = 0;
+};
+
+// Image whose tiles are paged in through a TileCache, with the interface
+// the lookups of MipMap.hpp take
+class PagedImage {
+ public:
+  PagedImage(TileCache& cache, TiledImage file);
+  ~PagedImage();
+
+  PagedImage(const PagedImage&) = delete;
+  PagedImage& operator=(const PagedImage&) = delete;
+
+  [[nodiscard]] int Levels() const { return file_.Levels(); }
+  [[nodiscard]] int Width(int level) const { return file_.Layout(level).width; }
+  [[nodiscard]] int Height(int level) const {
+    return file_.Layout(level).height;
+  }
+
+  // Texel at (x, y) of `level`, clamped to its edges
+  [[nodiscard]] Texel TexelAt(int level, int x, int y) const;
+
+ private:
+  friend class TileCache;
+
+  TileCache& cache_;
+  TiledImage file_;
+  // Frame holding each tile, or null, by level
+  std::vector<std::unique_ptr<TileCache::Slot[]>> slots_;
+};
+
+}  // namespace polaris::image
+
+#endif
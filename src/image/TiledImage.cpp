@@ -0,0 +1,191 @@
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <image/RTWImage.hpp>
+#include <image/TiledImage.hpp>
+#include <system_error>
+#include <type_traits>
+
+namespace polaris::image {
+namespace {
+constexpr std::array<char, 4> kTiledMagic{'P', 'L', 'T', 'I'};
+constexpr std::uint32_t kTiledVersion = 1;
+
+// Levels start on page boundaries, so tiles of full size do too and can be
+// dropped from memory page by page
+constexpr std::uint64_t kLevelAlignment = 4096;
+// Block of pages a fault maps at most, on Linux
+constexpr std::uint64_t kFaultAround = 64 << 10;
+
+// Followed by the offset of each level, then the levels
+struct TiledHeader {
+  std::array<char, 4> magic = kTiledMagic;
+  std::uint32_t version = kTiledVersion;
+  std::uint64_t source_size = 0;
+  std::int64_t source_time = 0;
+  std::int32_t width = 0;
+  std::int32_t height = 0;
+};
+
+static_assert(std::is_trivially_copyable_v<TiledHeader>);
+
+constexpr std::uint64_t AlignLevel(std::uint64_t offset) {
+  return (offset + kLevelAlignment - 1) & ~(kLevelAlignment - 1);
+}
+
+std::int64_t ModifiedTime(const std::filesystem::path& path,
+                          std::error_code& ec) {
+  return std::filesystem::last_write_time(path, ec)
+      .time_since_epoch()
+      .count();
+}
+}  // namespace
+
+bool TiledImage::OpenFor(const std::filesystem::path& image_path) {
+  std::error_code ec;
+  const auto source_size = std::filesystem::file_size(image_path, ec);
+  const auto source_time = ModifiedTime(image_path, ec);
+  if (ec) {
+    return false;
+  }
+
+  auto path = image_path;
+  path += ".tiles";
+  if (Open(path, source_size, source_time)) {
+    return true;
+  }
+
+  // Decoded whole once; later runs only map the tiles they touch
+  MipMap mip_map;
+  {
+    RTWImage image;
+    if (!image.load(image_path.string())) {
+      return false;
+    }
+    mip_map = MipMap(image.Data(), image.Width(), image.Height());
+  }
+  return !mip_map.Empty() &&
+         WriteTiledImage(mip_map, source_size, source_time, path) &&
+         Open(path, source_size, source_time);
+}
+
+bool TiledImage::Open(const std::filesystem::path& path,
+                      std::uint64_t source_size, std::int64_t source_time) {
+  layouts_.clear();
+  offsets_.clear();
+  if (!file_.Open(path)) {
+    return false;
+  }
+
+  const auto bytes = file_.Bytes();
+  TiledHeader header;
+  if (bytes.size() >= sizeof(header)) {
+    std::memcpy(&header, bytes.data(), sizeof(header));
+  }
+  if (bytes.size() < sizeof(header) || header.magic != kTiledMagic ||
+      header.version != kTiledVersion || header.source_size != source_size ||
+      header.source_time != source_time) {
+    file_.Close();
+    return false;
+  }
+
+  auto layouts = MipMap::Layouts(header.width, header.height);
+  std::vector<std::uint64_t> offsets(layouts.size());
+  const auto table_bytes = sizeof(std::uint64_t) * offsets.size();
+  bool ok = !layouts.empty() && sizeof(header) + table_bytes <= bytes.size();
+  if (ok) {
+    std::memcpy(offsets.data(), bytes.data() + sizeof(header), table_bytes);
+  }
+  for (std::size_t level = 0; ok && level < layouts.size(); ++level) {
+    const auto& layout = layouts[level];
+    ok = offsets[level] <= bytes.size() &&
+         layout.TileCount() * layout.TileBytes() <=
+             bytes.size() - offsets[level];
+  }
+  if (!ok) {
+    file_.Close();
+    return false;
+  }
+
+  file_.AdviseRandom();
+  layouts_ = std::move(layouts);
+  offsets_ = std::move(offsets);
+  return true;
+}
+
+std::span<const std::uint8_t> TiledImage::Tile(int level,
+                                               std::size_t tile) const {
+  const auto tile_bytes = layouts_[level].TileBytes();
+  const auto* data = reinterpret_cast<const std::uint8_t*>(
+      file_.Bytes().data() + offsets_[level] + tile * tile_bytes);
+  return {data, tile_bytes};
+}
+
+void TiledImage::Release(int level, std::size_t tile) const {
+  // Faults map the pages around the one touched too, so the whole block
+  // around the tile goes. Tiles are only read while being copied, so no
+  // other reader needs the pages.
+  const auto bytes = file_.Bytes();
+  const auto tile_bytes = layouts_[level].TileBytes();
+  const auto start = offsets_[level] + tile * tile_bytes;
+  const auto first = start & ~(kFaultAround - 1);
+  const auto last = std::min<std::uint64_t>(
+      (start + tile_bytes + kFaultAround - 1) & ~(kFaultAround - 1),
+      bytes.size());
+  file_.Discard(bytes.subspan(first, last - first));
+}
+
+bool WriteTiledImage(const MipMap& mip_map, std::uint64_t source_size,
+                     std::int64_t source_time,
+                     const std::filesystem::path& path) {
+  TiledHeader header;
+  header.source_size = source_size;
+  header.source_time = source_time;
+  header.width = mip_map.Width(0);
+  header.height = mip_map.Height(0);
+
+  std::vector<std::uint64_t> offsets;
+  auto offset = sizeof(header) + sizeof(std::uint64_t) * mip_map.Levels();
+  for (int level = 0; level < mip_map.Levels(); ++level) {
+    offset = AlignLevel(offset);
+    offsets.push_back(offset);
+    offset += mip_map.LevelData(level).size();
+  }
+
+  // Written beside the target and renamed over it once complete
+  auto temp_path = path;
+  temp_path += ".tmp";
+  {
+    std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+      return false;
+    }
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(offsets.data()),
+              static_cast<std::streamsize>(sizeof(std::uint64_t) *
+                                           offsets.size()));
+    static constexpr char kPadding[kLevelAlignment] = {};
+    auto size = sizeof(header) + sizeof(std::uint64_t) * offsets.size();
+    for (int level = 0; level < mip_map.Levels(); ++level) {
+      const auto data = mip_map.LevelData(level);
+      out.write(kPadding, static_cast<std::streamsize>(offsets[level] - size));
+      out.write(reinterpret_cast<const char*>(data.data()),
+                static_cast<std::streamsize>(data.size()));
+      size = offsets[level] + data.size();
+    }
+    if (!out.flush()) {
+      return false;
+    }
+  }
+
+  std::error_code ec;
+  std::filesystem::rename(temp_path, path, ec);
+  if (ec) {
+    std::filesystem::remove(temp_path, ec);
+    return false;
+  }
+  return true;
+}
+
+}  // namespace polaris::image
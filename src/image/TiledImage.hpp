@@ -0,0 +1,56 @@
+#ifndef POLARIS_IMAGE_TILED_IMAGE_HPP
+#define POLARIS_IMAGE_TILED_IMAGE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <image/MipMap.hpp>
+#include <span>
+#include <util/MappedFile.hpp>
+#include <vector>
+
+// Tiled images are mip maps written to disk tile by tile, as MipMap lays
+// them out, so a renderer can map the file and read single tiles of it. The
+// copy of an image is kept beside it with ".tiles" appended to its name and
+// records the size and modification time of the image, being rewritten
+// once either changes.
+
+namespace polaris::image {
+
+class TiledImage {
+ public:
+  // Opens the tiled copy of the image file at `image_path`, writing it first
+  // when missing or out of date. False if the image cannot be read or the
+  // copy cannot be written.
+  bool OpenFor(const std::filesystem::path& image_path);
+
+  [[nodiscard]] bool IsOpen() const { return file_.IsOpen(); }
+  [[nodiscard]] int Levels() const { return static_cast<int>(layouts_.size()); }
+  [[nodiscard]] const TileLayout& Layout(int level) const {
+    return layouts_[level];
+  }
+
+  // Bytes of `tile` of `level`. They are read from disk when first touched.
+  [[nodiscard]] std::span<const std::uint8_t> Tile(int level,
+                                                   std::size_t tile) const;
+  // Lets the memory holding a tile go once it has been copied elsewhere
+  void Release(int level, std::size_t tile) const;
+
+ private:
+  bool Open(const std::filesystem::path& path, std::uint64_t source_size,
+            std::int64_t source_time);
+
+  util::MappedFile file_;
+  std::vector<TileLayout> layouts_;
+  std::vector<std::uint64_t> offsets_;  // Of each level's first tile
+};
+
+// Writes `mip_map` as the tiled copy of an image of `source_size` bytes
+// last modified at `source_time`. The file is replaced in one step.
+bool WriteTiledImage(const MipMap& mip_map, std::uint64_t source_size,
+                     std::int64_t source_time,
+                     const std::filesystem::path& path);
+
+}  // namespace polaris::image
+
+#endif
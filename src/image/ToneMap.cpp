@@ -0,0 +1,46 @@
+#include <algorithm>
+#include <cmath>
+#include <image/ToneMap.hpp>
+
+namespace polaris::image {
+
+PixelU8 ToneMap(const PixelF64& linear, const ToneMapSettings& settings) {
+  const PixelF64 exposed =
+      settings.exposure == 0.0 ? linear
+                               : linear * std::exp2(settings.exposure);
+
+  const auto apply = [&](double v) {
+    switch (settings.tone_operator) {
+      case ToneMapOperator::Reinhard:
+        return v / (1.0 + v);
+      case ToneMapOperator::ACES: {
+        v = std::max(v, 0.0);
+        return (v * ((2.51 * v) + 0.03)) / ((v * ((2.43 * v) + 0.59)) + 0.14);
+      }
+      case ToneMapOperator::Clamp:
+      default:
+        return v;
+    }
+  };
+
+  return PixelF64(apply(exposed.R()), apply(exposed.G()), apply(exposed.B()))
+      .AsU8();
+}
+
+FrameBuffer ToneMap(const FrameBuffer& hdr, FileFormat format,
+                    const ToneMapSettings& settings) {
+  FrameBuffer ldr;
+  ldr.Assign(format, hdr.Width(), hdr.Height());
+  if (!hdr.IsHighDynamicRange()) {
+    return ldr;
+  }
+
+  for (std::size_t y = 0; y < hdr.Height(); ++y) {
+    for (std::size_t x = 0; x < hdr.Width(); ++x) {
+      ldr.Set(x, y, ToneMap(PixelF64(hdr.Linear(x, y)), settings));
+    }
+  }
+  return ldr;
+}
+
+}  // namespace polaris::image
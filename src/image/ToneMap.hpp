@@ -0,0 +1,34 @@
+#ifndef POLARIS_IMAGE_TONE_MAP_HPP
+#define POLARIS_IMAGE_TONE_MAP_HPP
+
+#include <cstdint>
+#include <image/FrameBuffer.hpp>
+#include <image/Pixel.hpp>
+
+namespace polaris::image {
+
+enum class ToneMapOperator : std::uint8_t {
+  Clamp = 0,  // Values above 1 clip to white
+  Reinhard,   // x / (1 + x) per channel
+  ACES,       // Narkowicz's fit of the ACES filmic curve
+};
+
+struct ToneMapSettings {
+  double exposure = 0.0;  // In stops, applied before the operator
+  ToneMapOperator tone_operator = ToneMapOperator::Clamp;
+};
+
+// Maps linear radiance to a display pixel. Clamp at zero exposure matches
+// PixelF64::AsU8().
+[[nodiscard]] PixelU8 ToneMap(const PixelF64& linear,
+                              const ToneMapSettings& settings);
+
+// Post stage turning a high dynamic range buffer into one of `format`, so
+// exposure and operator can change without rendering again. Any other
+// buffer has no radiance to map and yields a black image.
+[[nodiscard]] FrameBuffer ToneMap(const FrameBuffer& hdr, FileFormat format,
+                                  const ToneMapSettings& settings);
+
+}  // namespace polaris::image
+
+#endif
@@ -1,132 +1,228 @@
-#include <math/BVH.hpp>
-#include <math/Vec.hpp>
-#include <memory>
+#include <charconv>
+#include <cstdint>
+#include <image/TileCache.hpp>
+#include <iostream>
+#include <math/Accelerator.hpp>
+#include <optional>
 #include <scene/Camera.hpp>
-#include <scene/Hittable.hpp>
-#include <scene/material/Dielectric.hpp>
-#include <scene/material/Lambertian.hpp>
-#include <scene/material/Metal.hpp>
-#include <scene/objects/Sphere.hpp>
-#include <scene/objects/Quad.hpp>
+#include <scene/SceneCache.hpp>
+#include <scene/SceneFile.hpp>
 #include <string>
-
-#include "image/Pixel.hpp"
-#include "scene/texture/CheckerTexture.hpp"
-#include "scene/texture/PerlinNoise.hpp"
+#include <string_view>
+#include <system_error>
+#include <util/Memory.hpp>
 
 using namespace polaris;
 
-// unused function
-// namespace {
-// std::shared_ptr<scene::objects::Sphere> CreateSphere(
-//     const math::Vec3& pos, double radius,
-//     const std::shared_ptr<scene::material::Material>& mat) {
-//   return std::make_shared<scene::objects::Sphere>(pos, radius, mat);
-// }
-// }  // namespace
+namespace {
+constexpr std::string_view kUsage =
+    "usage: polaris [options] <scene file> [output name]\n"
+    "  --no-cache            parse the scene even if its cache is up to date\n"
+    "  --resume <state>      add samples to the render saved in <state>\n"
+    "  --save-state <state>  save the samples taken to <state>\n"
+    "  --samples <n>         samples per pixel to take, or to add on resuming\n"
+    "  --exposure <stops>    replace the scene's exposure\n"
+    "  --tonemap <operator>  replace the scene's tone map operator\n"
+    "  --ldr <format>        also write the image tone mapped to bmp, png or\n"
+    "                        jpg, from a render in hdr, pfm or exr\n";
+
+// Whether all of `text` is a number, which is stored in `value`
+template <typename T>
+bool ParseNumber(std::string_view text, T& value) {
+  const auto* end = text.data() + text.size();
+  const auto [last, error] = std::from_chars(text.data(), end, value);
+  return error == std::errc() && last == end;
+}
+}  // namespace
 
 int main(int argc, char** argv) {
-  (void)argc;
-  (void)argv;
-
-  scene::HittableList world;
-  {
-    using namespace scene::objects;
-    using scene::material::Dielectric;
-    using scene::material::Lambertian;
-    using scene::material::Material;
-    using scene::material::Metal;
-
-  //   // Book cover image test
-
-  //   auto checker = std::make_shared<scene::texture::CheckerTexture>(0.32, image::PixelF64(0.2, 0.3, 0.1), image::PixelF64(0.9, 0.9, 0.9));
-  //   auto perlin = std::make_shared<scene::texture::NoiseTexture>(4);
-  //   world.Add(std::make_shared<Sphere>(math::Vec3(0,-1000,0), 1000, std::make_shared<Lambertian>(perlin)));
-
-  //   for (int a = -11; a < 11; a++) {
-  //     for (int b = -11; b < 11; b++) {
-  //       auto choose_mat = math::RandomDouble();
-  //       const math::Vec3 center(a + (0.9 * math::RandomDouble()), 0.2, b + (0.9 * math::RandomDouble()));
-
-  //       if ((center - math::Vec3(4, 0.2, 0)).Length() > 0.9) {
-  //         std::shared_ptr<Material> sphere_material;
-
-  //         if (choose_mat < 0.8) {
-  //           // diffuse
-  //           auto albedo = image::PixelF64(math::RandomDouble(), math::RandomDouble(), math::RandomDouble()) * image::PixelF64(math::RandomDouble(), math::RandomDouble(), math::RandomDouble());
-  //           sphere_material = std::make_shared<Lambertian>(albedo);
-  //           auto center2 = center + math::Vec3(0, math::RandomDouble(0, 0.5), 0);
-  //           world.Add(std::make_shared<Sphere>(center, center2, 0.2, sphere_material));
-  //         } else if (choose_mat < 0.95) {
-  //           // metal
-  //           auto albedo = image::PixelF64(math::RandomDouble(), math::RandomDouble(), math::RandomDouble());
-  //           auto fuzz = math::RandomDouble(0, 0.5);
-  //           sphere_material = std::make_shared<Metal>(albedo, fuzz);
-  //           world.Add(make_shared<Sphere>(center, 0.2, sphere_material));
-  //         } else {
-  //           // glass
-  //           sphere_material = std::make_shared<Dielectric>(1.5);
-  //           world.Add(std::make_shared<Sphere>(center, 0.2, sphere_material));
-  //         }
-  //       }
-  //     }
-  //   }
-
-  //   auto material1 = std::make_shared<Dielectric>(1.5);
-  //   world.Add(std::make_shared<Sphere>(math::Vec3(0, 1, 0), 1.0, material1));
-
-  //   auto material2 = std::make_shared<Lambertian>(image::PixelF64(0.4, 0.2, 0.1));
-  //   world.Add(std::make_shared<Sphere>(math::Vec3(-4, 1, 0), 1.0, material2));
-
-  //   auto material3 = std::make_shared<Metal>(image::PixelF64(0.7, 0.6, 0.5), 0.0);
-  //   world.Add(make_shared<Sphere>(math::Vec3(4, 1, 0), 1.0, material3));
-  // }
-  // world = scene::HittableList(std::make_shared<math::BVHNode>(world));
-
-  // scene::CameraSettings settings;
-  // settings.aspect_ratio = 16.0 / 9.0;
-  // settings.image_width = 1280;
-  // settings.samples_per_pixel = 10;
-  // settings.max_depth_ = 10;
-  // settings.fov = 20.0;
-  // settings.defocus_angle = 0.6;
-  // settings.focus_dist = 1.0;
-
-  // settings.output_format_ = image::FileFormat::PNG;
-
-  // scene::Camera cam(settings);
-  // cam.SetTarget(math::Vec3(13, 2, 3), math::Vec3{0, 0, 0});
-  // cam.Render(world);
-
-    // Materials
-    auto left_red     = std::make_shared<Lambertian>(image::PixelF64(1.0, 0.2, 0.2));
-    auto back_green   = std::make_shared<Lambertian>(image::PixelF64(0.2, 1.0, 0.2));
-    auto right_blue   = std::make_shared<Lambertian>(image::PixelF64(0.2, 0.2, 1.0));
-    auto upper_orange = std::make_shared<Lambertian>(image::PixelF64(1.0, 0.5, 0.0));
-    auto lower_teal   = std::make_shared<Lambertian>(image::PixelF64(0.2, 0.8, 0.8));
-
-    // Quads
-    world.Add(make_shared<Quad>(math::Vec3(-3,-2, 5), math::Vec3(0, 0,-4), math::Vec3(0, 4, 0), left_red));
-    world.Add(make_shared<Quad>(math::Vec3(-2,-2, 0), math::Vec3(4, 0, 0), math::Vec3(0, 4, 0), back_green));
-    world.Add(make_shared<Quad>(math::Vec3( 3,-2, 1), math::Vec3(0, 0, 4), math::Vec3(0, 4, 0), right_blue));
-    world.Add(make_shared<Quad>(math::Vec3(-2, 3, 1), math::Vec3(4, 0, 0), math::Vec3(0, 0, 4), upper_orange));
-    world.Add(make_shared<Quad>(math::Vec3(-2,-3, 5), math::Vec3(4, 0, 0), math::Vec3(0, 0,-4), lower_teal));
-
-  scene::CameraSettings settings;
-  settings.aspect_ratio = 16.0 / 16.0;
-  settings.image_width = 400;
-  settings.samples_per_pixel = 100;
-  settings.max_depth_ = 50;
-  settings.fov = 80.0;
-  settings.defocus_angle = 0.6;
-  settings.focus_dist = 1.0;
-
-  settings.output_format_ = image::FileFormat::PNG;
+  // Scenes load through a cache beside the file unless --no-cache is given
+  bool use_cache = true;
+  std::string resume_state;  // Accumulated samples to add to
+  std::string save_state;    // Where the samples are saved afterwards
+  // Replacements for the scene's render settings
+  std::optional<std::uint32_t> samples;
+  std::optional<double> exposure;
+  std::optional<image::ToneMapOperator> tone_operator;
+  std::optional<image::FileFormat> ldr_format;
+  for (; argc > 1 && std::string_view(argv[1]).starts_with("--");
+       --argc, ++argv) {
+    const std::string_view option = argv[1];
+    if (option == "--no-cache") {
+      use_cache = false;
+      continue;
+    }
+    if (argc < 3) {
+      std::cerr << kUsage;
+      return 1;
+    }
+    const std::string_view value = argv[2];
+    --argc;
+    ++argv;
+
+    bool ok = true;
+    if (option == "--resume") {
+      resume_state = value;
+    } else if (option == "--save-state") {
+      save_state = value;
+    } else if (option == "--samples") {
+      ok = ParseNumber(value, samples.emplace());
+    } else if (option == "--exposure") {
+      ok = ParseNumber(value, exposure.emplace());
+    } else if (option == "--tonemap") {
+      tone_operator = scene::ParseToneMapOperator(value);
+      ok = tone_operator.has_value();
+    } else if (option == "--ldr") {
+      ldr_format = scene::ParseFileFormat(value);
+      ok = ldr_format && !image::IsHighDynamicRange(*ldr_format);
+    } else {
+      ok = false;
+    }
+    if (!ok) {
+      std::cerr << "bad value for " << option << "\n" << kUsage;
+      return 1;
+    }
+  }
+  if (argc < 2) {
+    std::cerr << kUsage;
+    return 1;
+  }
+  const std::string scene_path = argv[1];
+  const std::string output = argc > 2 ? argv[2] : "out";
+
+  auto scene = use_cache
+                   ? scene::LoadSceneCached(scene_path, scene_path + ".cache")
+                   : scene::LoadScene(scene_path);
+  if (!scene) {
+    std::cerr << scene.error() << '\n';
+    return 1;
+  }
+  const auto& load_stats = scene->stats;
+  std::clog << "Scene: " << load_stats.primitive_count << " primitives ("
+            << load_stats.triangle_count << " triangles, "
+            << load_stats.instance_count << " instances), "
+            << load_stats.line_count << " lines (" << load_stats.bytes
+            << " bytes) " << (load_stats.from_cache ? "mapped" : "parsed")
+            << " in " << load_stats.parse_ms << " ms, peak "
+            << (util::PeakMemoryBytes() >> 20) << " MiB\n";
+  if (!load_stats.cache_skipped.empty()) {
+    std::clog << "Cache: not used, " << load_stats.cache_skipped << '\n';
+  }
+  if (!load_stats.textures.empty()) {
+    std::clog << "Images: " << load_stats.textures.size() << " loaded in "
+              << load_stats.texture_ms << " ms\n";
+    for (const auto& load : load_stats.textures) {
+      std::clog << "  " << load.path << ": ";
+      if (load.width > 0) {
+        std::clog << load.width << 'x' << load.height
+                  << (load.paged ? " paged" : " decoded");
+      } else {
+        std::clog << "not loaded";
+      }
+      std::clog << " in " << load.load_ms << " ms\n";
+    }
+  }
+  if (load_stats.primitive_count > 0) {
+    std::clog << "Primitives: " << load_stats.primitive_bytes << " bytes, "
+              << (load_stats.primitive_bytes / load_stats.primitive_count)
+              << " per primitive\n";
+  }
+
+  auto& settings = scene->settings;
+  if (samples) {
+    settings.samples_per_pixel = *samples;
+  }
+  if (exposure) {
+    settings.tone_map.exposure = *exposure;
+  }
+  if (tone_operator) {
+    settings.tone_map.tone_operator = *tone_operator;
+  }
+  if (ldr_format && !image::IsHighDynamicRange(settings.output_format_)) {
+    std::cerr << "--ldr needs a render format of hdr, pfm or exr\n";
+    return 1;
+  }
+  // Resuming without adding samples only writes the images again, which
+  // needs no BVH
+  const bool trace = resume_state.empty() || settings.samples_per_pixel > 0;
+
+  auto bvh = scene->prebuilt;
+  if (!bvh && trace) {
+    math::BVHBuildStats bvh_stats;
+    bvh = math::MakeAccelerator(scene->accelerator, scene->world, {},
+                                &bvh_stats);
+    std::clog << "BVH: " << bvh_stats.node_count << " nodes, depth "
+              << bvh_stats.max_depth << ", SAH cost " << bvh_stats.sah_cost
+              << ", built in " << bvh_stats.build_ms << " ms\n";
+    // The accelerator keeps its own copy of the primitives in leaf order
+    scene->world.Clear();
+  }
 
   scene::Camera cam(settings);
-  cam.SetTarget(math::Vec3(0, 0, 9), math::Vec3{0, 0, 0});
-  cam.Render(world);
-  cam.Write("out");
+  cam.SetTarget(scene->look_from, scene->look_at);
+
+  // Progressive renders write the image after every pass, so it can be
+  // watched while the samples come in
+  std::optional<std::uint32_t> written;  // Samples of the image on disk
+  scene::Camera::PassCallback on_pass;
+  if (settings.pass_samples > 0) {
+    on_pass = [&](std::uint32_t samples) {
+      cam.Write(output);
+      written = samples;
+      std::clog << "Pass: " << samples << " samples per pixel written\n";
+    };
+  }
+  if (resume_state.empty()) {
+    cam.Render(*bvh, scene->materials, on_pass);
+  } else {
+    if (!cam.LoadState(resume_state)) {
+      std::cerr << "cannot resume from " << resume_state
+                << ": unreadable, or saved for another image size, sampler "
+                   "or seed\n";
+      return 1;
+    }
+    std::clog << "Resumed: " << cam.AccumulatedSamples()
+              << " samples per pixel\n";
+    if (trace) {
+      cam.Refine(*bvh, scene->materials, settings.samples_per_pixel,
+                 on_pass);
+    }
+  }
+
+  if (trace) {
+    const auto& render_stats = cam.Stats();
+    std::clog << "Render: " << render_stats.ray_count << " rays ("
+              << (sizeof(math::Real) == sizeof(float) ? "float" : "double")
+              << ") in " << render_stats.render_ms << " ms, "
+              << (static_cast<double>(render_stats.ray_count) /
+                  (render_stats.render_ms * 1000.0))
+              << " Mrays/s\n";
+  }
+  if (scene->texture_cache_bytes > 0) {
+    const auto tiles = image::TileCache::Shared().Stats();
+    const auto lookups = tiles.hits + tiles.misses;
+    std::clog << "Textures: " << tiles.misses << " tiles read, "
+              << tiles.evictions << " evicted, hit rate "
+              << (lookups > 0 ? 100.0 * static_cast<double>(tiles.hits) /
+                                    static_cast<double>(lookups)
+                              : 0.0)
+              << "%, " << (tiles.resident_bytes >> 10) << " of "
+              << (tiles.budget_bytes >> 10) << " KiB resident, peak "
+              << (util::PeakMemoryBytes() >> 20) << " MiB\n";
+  }
+
+  if (written != cam.AccumulatedSamples()) {
+    cam.Write(output);
+  }
+  if (ldr_format) {
+    cam.WriteToneMapped(output, *ldr_format, settings.tone_map);
+  }
+  if (settings.adaptive_threshold > 0) {
+    cam.WriteSampleHeatmap(output + "_samples");
+  }
+  if (!save_state.empty() && !cam.SaveState(save_state)) {
+    std::cerr << "cannot save the render state to " << save_state << '\n';
+    return 1;
+  }
   return 0;
 }
-}
@@ -1,28 +1,36 @@
 #ifndef POLARIS_MATH_AABB_HPP
 #define POLARIS_MATH_AABB_HPP
 
+#include <algorithm>
+#include <concepts>
 #include <math/Interval.hpp>
 #include <math/Ray.hpp>
+#include <stdexcept>
 
 namespace polaris::math {
 
-class AABB {
+template <std::floating_point T>
+class BasicAABB {
  public:
-  AABB() = default;
+  using Interval = BasicInterval<T>;
+  using Ray = BasicRay<T>;
+  using Vec = Vector<T, 3>;
 
-  AABB(const Interval& x, const Interval& y, const Interval& z) noexcept
+  BasicAABB() = default;
+
+  BasicAABB(const Interval& x, const Interval& y, const Interval& z) noexcept
       : x_(x), y_(y), z_(z) {
         PadToMinimums();
       }
 
-  AABB(const Vec3& a, const Vec3& b) noexcept
+  BasicAABB(const Vec& a, const Vec& b) noexcept
       : x_(std::min(a.X(), b.X()), std::max(a.X(), b.X())),
         y_(std::min(a.Y(), b.Y()), std::max(a.Y(), b.Y())),
         z_(std::min(a.Z(), b.Z()), std::max(a.Z(), b.Z())) {
           PadToMinimums();
         }
 
-  AABB(const AABB& box0, const AABB& box1) noexcept
+  BasicAABB(const BasicAABB& box0, const BasicAABB& box1) noexcept
       : x_(std::min(box0.x_.Min(), box1.x_.Min()),
            std::max(box0.x_.Max(), box1.x_.Max())),
         y_(std::min(box0.y_.Min(), box1.y_.Min()),
@@ -34,6 +42,13 @@ class AABB {
   [[nodiscard]] const Interval& Y() const noexcept { return y_; }
   [[nodiscard]] const Interval& Z() const noexcept { return z_; }
 
+  [[nodiscard]] T SurfaceArea() const noexcept {
+    const auto dx = x_.Size();
+    const auto dy = y_.Size();
+    const auto dz = z_.Size();
+    return 2 * ((dx * dy) + (dy * dz) + (dz * dx));
+  }
+
   [[nodiscard]] const Interval& Axis(int axis) const {
     switch (axis) {
       case 0:
@@ -48,6 +63,14 @@ class AABB {
   }
 
   [[nodiscard]] bool Hit(const Ray& r, Interval t_interval) const {
+    T t_entry = 0;
+    return Hit(r, t_interval, t_entry);
+  }
+
+  // Slab test that also reports the distance at which the ray enters the box
+  // (clamped to the start of `t_interval`).
+  [[nodiscard]] bool Hit(const Ray& r, const Interval& t_interval,
+                         T& t_entry) const {
     const auto& origin = r.Origin();
     const auto& inv_direction = r.InverseDirection();
 
@@ -71,28 +94,29 @@ class AABB {
       }
     }
 
-    t_interval.SetMin(tmin);
-    t_interval.SetMax(tmax);
+    t_entry = tmin;
     return true;
   }
 
  private:
   void PadToMinimums() {
-    double delta = 0.0001;
+    constexpr T delta = 0.0001;
     if(x_.Size() < delta) {
-      x_.Expand(delta);
+      x_ = x_.Expand(delta);
     }
     if(y_.Size() < delta) {
-      y_.Expand(delta);
+      y_ = y_.Expand(delta);
     }
     if(z_.Size() < delta) {
-      z_.Expand(delta);
+      z_ = z_.Expand(delta);
     }
   }
 
   Interval x_, y_, z_;
 };
 
+using AABB = BasicAABB<Real>;
+
 }  // namespace polaris::math
 
 #endif
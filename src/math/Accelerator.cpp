@@ -0,0 +1,47 @@
+#include <chrono>
+#include <math/Accelerator.hpp>
+#include <math/BVH.hpp>
+#include <math/WideBVH.hpp>
+
+namespace polaris::math {
+
+std::shared_ptr<scene::Hittable> MakeAccelerator(
+    AcceleratorType type, const scene::HittableList& list,
+    const BVHBuildOptions& options, BVHBuildStats* stats) {
+  BVHBuildStats build_stats;
+  std::shared_ptr<scene::Hittable> accelerator;
+
+  switch (type) {
+    case AcceleratorType::Tree: {
+      const auto start = std::chrono::steady_clock::now();
+      auto tree = std::make_shared<BVHNode>(list);
+      build_stats.build_ms = std::chrono::duration<double, std::milli>(
+                                 std::chrono::steady_clock::now() - start)
+                                 .count();
+      build_stats.node_count = tree->NodeCount();
+      build_stats.max_depth = tree->MaxDepth();
+      accelerator = std::move(tree);
+      break;
+    }
+    case AcceleratorType::Flat: {
+      auto flat = std::make_shared<FlatBVH>(list, options);
+      build_stats = flat->BuildStats();
+      accelerator = std::move(flat);
+      break;
+    }
+    case AcceleratorType::Wide: {
+      auto wide = std::make_shared<WideBVH>(list, options);
+      build_stats = wide->BuildStats();
+      build_stats.node_count = wide->NodeCount();
+      accelerator = std::move(wide);
+      break;
+    }
+  }
+
+  if (stats != nullptr) {
+    *stats = build_stats;
+  }
+  return accelerator;
+}
+
+}  // namespace polaris::math
@@ -0,0 +1,26 @@
+#ifndef POLARIS_MATH_ACCELERATOR_HPP
+#define POLARIS_MATH_ACCELERATOR_HPP
+
+#include <cstdint>
+#include <math/FlatBVH.hpp>
+#include <memory>
+#include <scene/Hittable.hpp>
+#include <scene/HittableList.hpp>
+
+namespace polaris::math {
+
+enum class AcceleratorType : std::uint8_t {
+  Tree = 0,  // BVHNode, pointer-based binary tree with median splits
+  Flat,      // FlatBVH, flattened binary SAH tree; supports packet tracing
+  Wide,      // WideBVH, 4-wide SAH tree for incoherent single rays
+};
+
+// Builds the chosen acceleration structure over `list`. When `stats` is given
+// it receives the build statistics; BVHNode reports no SAH cost.
+[[nodiscard]] std::shared_ptr<scene::Hittable> MakeAccelerator(
+    AcceleratorType type, const scene::HittableList& list,
+    const BVHBuildOptions& options = {}, BVHBuildStats* stats = nullptr);
+
+}  // namespace polaris::math
+
+#endif
@@ -2,132 +2,138 @@
 #define POLARIS_MATH_BVH_HPP
 
 #include <algorithm>
+#include <cstdint>
 #include <math/AABB.hpp>
 #include <math/Common.hpp>
-#include <memory>
+#include <numeric>
 #include <scene/Hittable.hpp>
+#include <scene/HittableList.hpp>
+#include <scene/PrimitiveStore.hpp>
+#include <span>
+#include <util/Arena.hpp>
 #include <vector>
 
 namespace polaris::math {
 
+// Pointer-based binary tree with median splits. Nodes are linked by pointer
+// but bumped off an arena the tree owns, rather than allocated one by one;
+// leaves cover one or two primitives of the tree's store in leaf order.
 class BVHNode : public scene::Hittable {
  public:
-  // Take vector by rvalue reference to avoid copy
-  explicit BVHNode(std::vector<std::shared_ptr<scene::Hittable>>&& objects) {
-    Build(objects, 0, objects.size());
-  }
+  explicit BVHNode(const scene::PrimitiveStore& primitives) {
+    std::vector<math::AABB> bounds;
+    bounds.reserve(primitives.Size());
+    for (std::size_t i = 0; i < primitives.Size(); ++i) {
+      bounds.push_back(primitives.Bounds(i));
+    }
+    std::vector<std::uint32_t> order(bounds.size());
+    std::iota(order.begin(), order.end(), 0U);
 
-  explicit BVHNode(const scene::HittableList& list) {
-    auto objects = list.GetObjects();
-    Build(objects, 0, objects.size());
+    root_ = Build(bounds, order, 0, order.size(), 0);
+    primitives_ = primitives.Reordered(order);
   }
 
+  explicit BVHNode(const scene::HittableList& list)
+      : BVHNode(list.Primitives()) {}
+
   [[nodiscard]] bool Hit(const math::Ray& r, const math::Interval& t_interval,
                          scene::HitInfo& rec) const override {
-    if (!box_.Hit(r, t_interval)) return false;
-
-    bool hit_anything = false;
-    double closest_so_far = t_interval.Max();
-
-    if (left_) {
-      scene::HitInfo left_rec;
-      if (left_->Hit(r, math::Interval(t_interval.Min(), closest_so_far),
-                     left_rec)) {
-        hit_anything = true;
-        closest_so_far = left_rec.t_;
-        rec = left_rec;
-      }
-    }
-
-    if (right_) {
-      scene::HitInfo right_rec;
-      if (right_->Hit(r, math::Interval(t_interval.Min(), closest_so_far),
-                      right_rec)) {
-        hit_anything = true;
-        rec = right_rec;
-        closest_so_far = right_rec.t_;
-      }
-    }
-
-    return hit_anything;
+    return HitNode(*root_, r, t_interval, rec);
   }
 
-  [[nodiscard]] math::AABB GetBounds() const override { return box_; }
+  [[nodiscard]] math::AABB GetBounds() const override { return root_->box; }
+
+  [[nodiscard]] std::size_t NodeCount() const { return node_count_; }
+  [[nodiscard]] int MaxDepth() const { return max_depth_; }
 
  private:
-  void Build(std::vector<std::shared_ptr<scene::Hittable>>& objects,
-             size_t start, size_t end) {
+  struct Node {
+    math::AABB box;
+    const Node* left = nullptr;  // Null for leaves
+    const Node* right = nullptr;
+    std::uint32_t first = 0;  // Leaf range in primitives_
+    std::uint32_t count = 0;
+    int axis = 0;  // Split axis, left holds the lower half
+  };
+
+  // Builds the subtree over order[start, end), which it may permute. The
+  // store is filled in leaf order once the whole tree is built.
+  const Node* Build(std::span<const math::AABB> bounds,
+                    std::vector<std::uint32_t>& order, size_t start,
+                    size_t end, int depth) {
     const size_t span = end - start;
+    auto* node = arena_.Create<Node>();
+    ++node_count_;
+    max_depth_ = std::max(max_depth_, depth);
 
-    if (span == 1) {
-      left_ = right_ = objects[start];
-    } else if (span == 2) {
-      left_ = objects[start];
-      right_ = objects[start + 1];
-    } else {
-      // Choose axis with largest extent for better splits
-      math::AABB bounds;
-      for (size_t i = start; i < end; ++i) {
-        bounds = math::AABB(bounds, objects[i]->GetBounds());
-      }
-
-      int axis = 0;
-      auto extent = bounds.Axis(0).Size();
-      for (int a = 1; a < 3; ++a) {
-        auto e = bounds.Axis(a).Size();
-        if (e > extent) {
-          extent = e;
-          axis = a;
-        }
-      }
+    for (size_t i = start; i < end; ++i) {
+      node->box = math::AABB(node->box, bounds[order[i]]);
+    }
 
-      auto mid = start + (span / 2);
-      // NOLINTBEGIN(cppcoreguidelines-narrowing-conversions, bugprone-narrowing-conversions)
-      std::nth_element(objects.begin() + start, objects.begin() + mid,
-                       objects.begin() + end,
-                       [axis](const auto& a, const auto& b) {
-                         return a->GetBounds().Axis(axis).Min() <
-                                b->GetBounds().Axis(axis).Min();
-                       });
-
-      left_ = std::make_shared<BVHNode>(
-          std::vector<std::shared_ptr<scene::Hittable>>(objects.begin() + start,
-                                                        objects.begin() + mid));
-      right_ = std::make_shared<BVHNode>(
-          std::vector<std::shared_ptr<scene::Hittable>>(objects.begin() + mid,
-                                                        objects.begin() + end));
-      // NOLINTEND(cppcoreguidelines-narrowing-conversions, bugprone-narrowing-conversions)
+    if (span <= 2) {
+      node->first = static_cast<std::uint32_t>(start);
+      node->count = static_cast<std::uint32_t>(span);
+      return node;
     }
 
-    box_ = math::AABB(left_->GetBounds(),
-                      right_ ? right_->GetBounds() : left_->GetBounds());
-  }
+    // Choose axis with largest extent for better splits
+    int axis = 0;
+    auto extent = node->box.Axis(0).Size();
+    for (int a = 1; a < 3; ++a) {
+      auto e = node->box.Axis(a).Size();
+      if (e > extent) {
+        extent = e;
+        axis = a;
+      }
+    }
 
-  [[nodiscard]] static bool BoxCompare(const std::shared_ptr<Hittable>& a,
-    const std::shared_ptr<Hittable>& b, int axis_index) {
-    auto a_axis_interval = a->GetBounds().Axis(axis_index);
-    auto b_axis_interval = b->GetBounds().Axis(axis_index);
-    return a_axis_interval.Min() < b_axis_interval.Min();
+    node->axis = axis;
+    auto mid = start + (span / 2);
+    // NOLINTBEGIN(cppcoreguidelines-narrowing-conversions, bugprone-narrowing-conversions)
+    std::nth_element(order.begin() + start, order.begin() + mid,
+                     order.begin() + end,
+                     [&bounds, axis](std::uint32_t a, std::uint32_t b) {
+                       return bounds[a].Axis(axis).Min() <
+                              bounds[b].Axis(axis).Min();
+                     });
+    // NOLINTEND(cppcoreguidelines-narrowing-conversions, bugprone-narrowing-conversions)
+
+    node->left = Build(bounds, order, start, mid, depth + 1);
+    node->right = Build(bounds, order, mid, end, depth + 1);
+    return node;
   }
 
-  [[nodiscard]] static bool BoxXCompare(const std::shared_ptr<Hittable>& a,
-    const std::shared_ptr<Hittable>& b) {
-    return BoxCompare(a, b, 0);
-  }
+  [[nodiscard]] bool HitNode(const Node& node, const math::Ray& r,
+                             const math::Interval& t_interval,
+                             scene::HitInfo& rec) const {
+    if (!node.box.Hit(r, t_interval)) return false;
 
-  [[nodiscard]] static bool BoxYCompare(const std::shared_ptr<Hittable>& a,
-    const std::shared_ptr<Hittable>& b) {
-    return BoxCompare(a, b, 1);
-  }
+    if (node.left == nullptr) {
+      auto closest_so_far = t_interval.Max();
+      return primitives_.HitRange(node.first, node.count, r, t_interval.Min(),
+                                  closest_so_far, rec);
+    }
 
-  [[nodiscard]] static bool BoxZCompare(const std::shared_ptr<Hittable>& a,
-    const std::shared_ptr<Hittable>& b) {
-    return BoxCompare(a, b, 2);
+    // Visit the child on the near side of the split first, so the far child
+    // is tested against an interval already shortened by any hit found here.
+    const bool reversed = r.Direction()[node.axis] < 0;
+    const auto& near_child = reversed ? *node.right : *node.left;
+    const auto& far_child = reversed ? *node.left : *node.right;
+
+    // Children only write `rec` for a closer hit, so they can share it
+    const bool hit_near = HitNode(near_child, r, t_interval, rec);
+    const bool hit_far = HitNode(
+        far_child, r,
+        math::Interval(t_interval.Min(), hit_near ? rec.t_ : t_interval.Max()),
+        rec);
+    return hit_near || hit_far;
   }
 
-  std::shared_ptr<scene::Hittable> left_;
-  std::shared_ptr<scene::Hittable> right_;
-  math::AABB box_;
+  util::Arena arena_;  // Holds every node
+  const Node* root_ = nullptr;
+  scene::PrimitiveStore primitives_;
+  std::size_t node_count_ = 0;
+  int max_depth_ = 0;
 };
 
 }  // namespace polaris::math
@@ -4,6 +4,7 @@
 #include <cmath>
 #include <cstdlib>
 #include <limits>
+#include <math/Random.hpp>
 #include <numbers>
 #include <random>
 
@@ -11,6 +12,14 @@ namespace polaris::math {
 template<typename T>
 concept NumericType = std::is_arithmetic_v<T>;
 
+// Scalar type of the ray/geometry core. Building with POLARIS_SINGLE_PRECISION
+// traces in float, which halves the size of rays, bounds and BVH nodes.
+#ifdef POLARIS_SINGLE_PRECISION
+using Real = float;
+#else
+using Real = double;
+#endif
+
 constexpr auto kInfinity = std::numeric_limits<double>::infinity();
 
 inline double DegreesToRadians(double degrees) {
@@ -21,13 +30,15 @@ inline double RadiansToDegrees(double radians) {
   return radians * 180.0 / std::numbers::pi;
 }
 
+// General purpose randomness for scene setup. Every thread starts from the
+// same fixed state, so generated scenes are the same on every run; rendering
+// draws from scene::sampler::Sampler instead.
 template<NumericType T>
 inline T RandomValue(T min = 0.0, T max = 1.0) {
-  static thread_local std::mt19937 generator(std::random_device{}());
+  static thread_local Pcg32 generator;
 
   if constexpr (std::floating_point<T>) {
-    std::uniform_real_distribution<T> distribution(min, max);
-    return distribution(generator);
+    return min + ((max - min) * generator.Uniform<T>());
   } else if constexpr (std::integral<T>) {
     std::uniform_int_distribution<T> distribution(min, max);
     return distribution(generator);
@@ -0,0 +1,359 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <limits>
+#include <math/Common.hpp>
+#include <math/FlatBVH.hpp>
+#include <numeric>
+#include <util/ThreadPool.hpp>
+#include <utility>
+
+namespace polaris::math {
+
+namespace {
+// Past this depth SAH splits are replaced by median splits, which bounds the
+// depth of any tree by the traversal stack size.
+constexpr int kMaxSAHDepth = 96;
+constexpr int kMaxBinCount = 64;
+
+class FlatBVHBuilder {
+ public:
+  FlatBVHBuilder(std::span<const AABB> bounds, std::vector<std::uint32_t>& order,
+                 const BVHBuildOptions& options)
+      : bounds_(bounds), order_(order), options_(options) {
+    options_.bin_count = std::clamp(options_.bin_count, 2, kMaxBinCount);
+    options_.max_leaf_size = std::clamp<std::size_t>(
+        options_.max_leaf_size, 1, std::numeric_limits<std::uint16_t>::max());
+  }
+
+  void Build(std::vector<FlatBVHNode>& nodes) {
+    nodes.clear();
+    order_.resize(bounds_.size());
+    std::iota(order_.begin(), order_.end(), 0U);
+
+    if (bounds_.empty()) {
+      return;
+    }
+
+    centroids_.reserve(bounds_.size());
+    for (const auto& box : bounds_) {
+      centroids_.emplace_back(0.5 * (box.X().Min() + box.X().Max()),
+                              0.5 * (box.Y().Min() + box.Y().Max()),
+                              0.5 * (box.Z().Min() + box.Z().Max()));
+    }
+
+    // A binary tree never needs more than 2n - 1 nodes
+    nodes.reserve((2 * bounds_.size()) - 1);
+    BuildRange(nodes, 0, bounds_.size(), 0);
+  }
+
+ private:
+  struct Bin {
+    AABB bounds;
+    std::size_t count = 0;
+  };
+
+  // Appends the subtree for order_[start, end) to `out` in depth-first order.
+  // Child offsets are relative to the start of `out`.
+  void BuildRange(std::vector<FlatBVHNode>& out, std::size_t start,
+                  std::size_t end, int depth) {
+    const auto index = out.size();
+    out.emplace_back();
+
+    AABB bounds;
+    Vec3 centroid_min(kInfinity, kInfinity, kInfinity);
+    Vec3 centroid_max(-kInfinity, -kInfinity, -kInfinity);
+    for (std::size_t i = start; i < end; ++i) {
+      bounds = AABB(bounds, bounds_[order_[i]]);
+      const auto& c = centroids_[order_[i]];
+      for (std::size_t a = 0; a < 3; ++a) {
+        centroid_min[a] = std::min(centroid_min[a], c[a]);
+        centroid_max[a] = std::max(centroid_max[a], c[a]);
+      }
+    }
+    out[index].bounds_ = bounds;
+
+    int axis = 0;
+    const auto mid =
+        Partition(start, end, bounds, centroid_min, centroid_max, depth, axis);
+    if (mid == start) {
+      out[index].offset_ = static_cast<std::uint32_t>(start);
+      out[index].count_ = static_cast<std::uint16_t>(end - start);
+      return;
+    }
+
+    std::size_t second = 0;
+    if (end - start >= options_.parallel_threshold) {
+      std::vector<FlatBVHNode> left;
+      std::vector<FlatBVHNode> right;
+      util::TaskGroup group(util::ThreadPool::Default());
+      group.Run([&] { BuildRange(left, start, mid, depth + 1); });
+      BuildRange(right, mid, end, depth + 1);
+      group.Wait();
+
+      Append(out, left);
+      second = out.size();
+      Append(out, right);
+    } else {
+      BuildRange(out, start, mid, depth + 1);
+      second = out.size();
+      BuildRange(out, mid, end, depth + 1);
+    }
+
+    out[index].offset_ = static_cast<std::uint32_t>(second);
+    out[index].axis_ = static_cast<std::uint8_t>(axis);
+  }
+
+  // Reorders order_[start, end) around the chosen split and returns the first
+  // index of the second half, or `start` when the range should be a leaf.
+  std::size_t Partition(std::size_t start, std::size_t end, const AABB& bounds,
+                        const Vec3& centroid_min, const Vec3& centroid_max,
+                        int depth, int& axis) {
+    const std::size_t span = end - start;
+    if (span == 1) {
+      return start;
+    }
+
+    axis = 0;
+    for (int a = 1; a < 3; ++a) {
+      if (centroid_max[a] - centroid_min[a] >
+          centroid_max[axis] - centroid_min[axis]) {
+        axis = a;
+      }
+    }
+
+    if (centroid_max[axis] <= centroid_min[axis]) {
+      // All centroids coincide, so no plane can separate them
+      return span <= options_.max_leaf_size ? start : start + (span / 2);
+    }
+
+    if (options_.split_method == BVHSplitMethod::Median ||
+        depth >= kMaxSAHDepth) {
+      return span <= options_.max_leaf_size ? start
+                                            : SplitMedian(start, end, axis);
+    }
+
+    return SplitSAH(start, end, bounds, centroid_min, centroid_max, axis);
+  }
+
+  std::size_t SplitMedian(std::size_t start, std::size_t end, int axis) {
+    const auto mid = start + ((end - start) / 2);
+    // NOLINTBEGIN(cppcoreguidelines-narrowing-conversions, bugprone-narrowing-conversions)
+    std::nth_element(order_.begin() + start, order_.begin() + mid,
+                     order_.begin() + end,
+                     [this, axis](std::uint32_t a, std::uint32_t b) {
+                       return centroids_[a][axis] < centroids_[b][axis];
+                     });
+    // NOLINTEND(cppcoreguidelines-narrowing-conversions, bugprone-narrowing-conversions)
+    return mid;
+  }
+
+  std::size_t SplitSAH(std::size_t start, std::size_t end, const AABB& bounds,
+                       const Vec3& centroid_min, const Vec3& centroid_max,
+                       int& axis) {
+    const int bin_count = options_.bin_count;
+    const double inv_area = 1.0 / bounds.SurfaceArea();
+
+    double best_cost = kInfinity;
+    int best_axis = -1;
+    int best_split = 0;
+
+    for (int a = 0; a < 3; ++a) {
+      const double extent = centroid_max[a] - centroid_min[a];
+      if (extent <= 0) {
+        continue;
+      }
+
+      std::array<Bin, kMaxBinCount> bins{};
+      const double scale = bin_count / extent;
+      for (std::size_t i = start; i < end; ++i) {
+        auto& bin = bins[BinIndex(order_[i], a, centroid_min[a], scale)];
+        bin.bounds = AABB(bin.bounds, bounds_[order_[i]]);
+        ++bin.count;
+      }
+
+      // Sweep from the right to get the cost of everything above each plane
+      std::array<double, kMaxBinCount> right_cost{};
+      AABB right_bounds;
+      std::size_t right_count = 0;
+      for (int b = bin_count - 1; b > 0; --b) {
+        if (bins[b].count != 0) {
+          right_bounds = AABB(right_bounds, bins[b].bounds);
+          right_count += bins[b].count;
+        }
+        right_cost[b - 1] =
+            right_count == 0
+                ? kInfinity
+                : right_bounds.SurfaceArea() * static_cast<double>(right_count);
+      }
+
+      AABB left_bounds;
+      std::size_t left_count = 0;
+      for (int b = 0; b < bin_count - 1; ++b) {
+        if (bins[b].count != 0) {
+          left_bounds = AABB(left_bounds, bins[b].bounds);
+          left_count += bins[b].count;
+        }
+        if (left_count == 0) {
+          continue;
+        }
+
+        const double cost =
+            options_.traversal_cost +
+            (options_.intersection_cost * inv_area *
+             ((left_bounds.SurfaceArea() * static_cast<double>(left_count)) +
+              right_cost[b]));
+        if (cost < best_cost) {
+          best_cost = cost;
+          best_axis = a;
+          best_split = b;
+        }
+      }
+    }
+
+    const std::size_t span = end - start;
+    const double leaf_cost =
+        options_.intersection_cost * static_cast<double>(span);
+    if (span <= options_.max_leaf_size && leaf_cost <= best_cost) {
+      return start;
+    }
+
+    if (best_axis < 0) {
+      return SplitMedian(start, end, axis);
+    }
+
+    axis = best_axis;
+    const double scale =
+        bin_count / (centroid_max[best_axis] - centroid_min[best_axis]);
+    // NOLINTBEGIN(cppcoreguidelines-narrowing-conversions, bugprone-narrowing-conversions)
+    const auto it = std::partition(
+        order_.begin() + start, order_.begin() + end, [&](std::uint32_t i) {
+          return BinIndex(i, best_axis, centroid_min[best_axis], scale) <=
+                 best_split;
+        });
+    // NOLINTEND(cppcoreguidelines-narrowing-conversions, bugprone-narrowing-conversions)
+
+    const auto mid = static_cast<std::size_t>(it - order_.begin());
+    if (mid == start || mid == end) {
+      return SplitMedian(start, end, axis);
+    }
+    return mid;
+  }
+
+  [[nodiscard]] int BinIndex(std::uint32_t primitive, int axis, double min,
+                             double scale) const {
+    const auto b = static_cast<int>((centroids_[primitive][axis] - min) * scale);
+    return std::clamp(b, 0, options_.bin_count - 1);
+  }
+
+  static void Append(std::vector<FlatBVHNode>& out,
+                     const std::vector<FlatBVHNode>& subtree) {
+    const auto base = static_cast<std::uint32_t>(out.size());
+    for (auto node : subtree) {
+      if (!node.IsLeaf()) {
+        node.offset_ += base;
+      }
+      out.push_back(node);
+    }
+  }
+
+  std::span<const AABB> bounds_;
+  std::vector<std::uint32_t>& order_;
+  BVHBuildOptions options_;
+  std::vector<Vec3> centroids_;
+};
+
+void ComputeStats(std::span<const FlatBVHNode> nodes,
+                  const BVHBuildOptions& options, BVHBuildStats& stats) {
+  stats.node_count = nodes.size();
+  if (nodes.empty()) {
+    return;
+  }
+
+  struct Entry {
+    std::uint32_t node;
+    int depth;
+  };
+  std::vector<Entry> stack{{0, 0}};
+
+  const double inv_root_area = 1.0 / nodes[0].bounds_.SurfaceArea();
+  while (!stack.empty()) {
+    const auto [index, depth] = stack.back();
+    stack.pop_back();
+
+    const auto& node = nodes[index];
+    const double relative_area = node.bounds_.SurfaceArea() * inv_root_area;
+    stats.max_depth = std::max(stats.max_depth, depth);
+
+    if (node.IsLeaf()) {
+      ++stats.leaf_count;
+      stats.sah_cost +=
+          options.intersection_cost * node.count_ * relative_area;
+    } else {
+      stats.sah_cost += options.traversal_cost * relative_area;
+      stack.push_back({index + 1, depth + 1});
+      stack.push_back({node.offset_, depth + 1});
+    }
+  }
+}
+}  // namespace
+
+BVHBuildStats BuildFlatBVH(std::span<const AABB> bounds,
+                           std::vector<FlatBVHNode>& nodes,
+                           std::vector<std::uint32_t>& order,
+                           const BVHBuildOptions& options) {
+  const auto start_time = std::chrono::steady_clock::now();
+  FlatBVHBuilder(bounds, order, options).Build(nodes);
+  const auto end_time = std::chrono::steady_clock::now();
+
+  BVHBuildStats stats;
+  stats.build_ms =
+      std::chrono::duration<double, std::milli>(end_time - start_time).count();
+  ComputeStats(nodes, options, stats);
+  return stats;
+}
+
+FlatBVH::FlatBVH(const scene::PrimitiveStore& primitives,
+                 const BVHBuildOptions& options) {
+  std::vector<AABB> bounds;
+  bounds.reserve(primitives.Size());
+  for (std::size_t i = 0; i < primitives.Size(); ++i) {
+    bounds.push_back(primitives.Bounds(i));
+  }
+
+  std::vector<std::uint32_t> order;
+  stats_ = BuildFlatBVH(bounds, nodes_, order, options);
+  primitives_ = primitives.Reordered(order);
+}
+
+FlatBVH::FlatBVH(const scene::HittableList& list,
+                 const BVHBuildOptions& options)
+    : FlatBVH(list.Primitives(), options) {}
+
+bool FlatBVH::Hit(const math::Ray& r, const math::Interval& t_interval,
+                  scene::HitInfo& rec) const {
+  return TraverseFlatBVH(
+      nodes_, r, t_interval,
+      [&](std::uint32_t first, std::uint32_t count, Real t_min,
+          Real& closest_so_far) {
+        return primitives_.HitRange(first, count, r, t_min, closest_so_far,
+                                    rec);
+      });
+}
+
+int FlatBVH::HitPacket(const math::RayPacket& packet, int mask, double t_min,
+                       scene::PacketDistances& t_max,
+                       scene::PacketHitInfo& rec) const {
+  return TraverseFlatBVHPacket(
+      nodes_, packet, mask, t_min, t_max,
+      [&](std::uint32_t first, std::uint32_t count, int lanes) {
+        return primitives_.HitRangePacket(first, count, packet, lanes, t_min,
+                                          t_max, rec);
+      });
+}
+
+math::AABB FlatBVH::GetBounds() const {
+  return nodes_.empty() ? math::AABB() : nodes_.front().bounds_;
+}
+
+}  // namespace polaris::math
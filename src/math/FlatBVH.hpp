@@ -0,0 +1,256 @@
+#ifndef POLARIS_MATH_FLAT_BVH_HPP
+#define POLARIS_MATH_FLAT_BVH_HPP
+
+#include <bit>
+#include <cstdint>
+#include <math/AABB.hpp>
+#include <math/Interval.hpp>
+#include <math/Ray.hpp>
+#include <math/RayPacket.hpp>
+#include <math/simd/PacketKernels.hpp>
+#include <memory>
+#include <scene/Hittable.hpp>
+#include <scene/HittableList.hpp>
+#include <scene/PrimitiveStore.hpp>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace polaris::math {
+
+// Node of a flattened BVH. Nodes are stored in depth-first order, so the
+// first child of an interior node is always the node right after it and only
+// the second child needs an explicit offset.
+struct alignas(32) FlatBVHNode {
+  AABB bounds_;
+  std::uint32_t offset_ = 0;  // Leaf: first primitive, interior: second child
+  std::uint16_t count_ = 0;   // Primitives in the leaf, 0 for interior nodes
+  std::uint8_t axis_ = 0;     // Split axis of interior nodes
+
+  [[nodiscard]] bool IsLeaf() const noexcept { return count_ != 0; }
+};
+
+// Entries of the traversal stacks. Every tree the builder makes is shallower,
+// and trees read from elsewhere must be checked against it.
+inline constexpr int kFlatBVHStackSize = 128;
+
+enum class BVHSplitMethod : std::uint8_t {
+  Median = 0,  // Median centroid along the longest axis
+  SAH,         // Binned surface area heuristic
+};
+
+struct BVHBuildOptions {
+  BVHSplitMethod split_method = BVHSplitMethod::SAH;
+  int bin_count = 16;              // SAH bins per axis
+  std::size_t max_leaf_size = 4;   // Larger ranges are always split
+  double traversal_cost = 1.0;     // SAH cost of visiting an interior node
+  double intersection_cost = 1.0;  // SAH cost of testing one primitive
+
+  // Ranges at least this large build their two subtrees as separate tasks on
+  // the default thread pool; smaller ones are built serially.
+  std::size_t parallel_threshold = 4096;
+};
+
+struct BVHBuildStats {
+  double build_ms = 0.0;  // Wall time of the build
+  double sah_cost = 0.0;  // SAH cost of the finished tree
+  std::size_t node_count = 0;
+  std::size_t leaf_count = 0;
+  int max_depth = 0;
+};
+
+// Builds a flattened BVH over primitives described by their bounds. On return
+// `nodes` holds the tree with the root at index 0 and `order` maps each leaf
+// slot back to the index of the primitive in `bounds`.
+BVHBuildStats BuildFlatBVH(std::span<const AABB> bounds,
+                           std::vector<FlatBVHNode>& nodes,
+                           std::vector<std::uint32_t>& order,
+                           const BVHBuildOptions& options = {});
+
+// Walks a flattened BVH front to back with a small fixed stack, calling
+// `leaf(first, count, t_min, closest_so_far)` for every leaf the ray reaches.
+// The callback returns true when it found a hit, in which case it has also
+// lowered `closest_so_far` to the new hit distance.
+template <typename LeafFn>
+[[nodiscard]] bool TraverseFlatBVH(std::span<const FlatBVHNode> nodes,
+                                   const Ray& r, const Interval& t_interval,
+                                   LeafFn&& leaf) {
+  struct Entry {
+    std::uint32_t node;
+    Real t_entry;  // Where the ray enters the node's bounds
+  };
+
+  Real t_entry = 0;
+  if (nodes.empty() || !nodes[0].bounds_.Hit(r, t_interval, t_entry)) {
+    return false;
+  }
+
+  Entry stack[kFlatBVHStackSize];
+  int stack_size = 0;
+  std::uint32_t current = 0;
+
+  bool hit_anything = false;
+  Real closest_so_far = t_interval.Max();
+
+  while (true) {
+    const auto& node = nodes[current];
+
+    if (node.IsLeaf()) {
+      if (leaf(node.offset_, node.count_, t_interval.Min(), closest_so_far)) {
+        hit_anything = true;
+      }
+    } else {
+      // The first child holds the lower half along the split axis, so it is
+      // the near one unless the ray travels in the negative direction.
+      auto near_index = current + 1;
+      auto far_index = node.offset_;
+      if (r.Direction()[node.axis_] < 0) {
+        std::swap(near_index, far_index);
+      }
+
+      const Interval ray_t(t_interval.Min(), closest_so_far);
+      Real near_entry = 0;
+      Real far_entry = 0;
+      const bool hit_near = nodes[near_index].bounds_.Hit(r, ray_t, near_entry);
+      const bool hit_far = nodes[far_index].bounds_.Hit(r, ray_t, far_entry);
+
+      if (hit_near) {
+        if (hit_far) {
+          stack[stack_size++] = {far_index, far_entry};
+        }
+        current = near_index;
+        continue;
+      }
+      if (hit_far) {
+        current = far_index;
+        continue;
+      }
+    }
+
+    // Pop the next deferred node, skipping any the ray only enters beyond the
+    // closest hit found since it was pushed.
+    bool found = false;
+    while (stack_size > 0) {
+      const auto& entry = stack[--stack_size];
+      if (entry.t_entry <= closest_so_far) {
+        current = entry.node;
+        found = true;
+        break;
+      }
+    }
+    if (!found) {
+      break;
+    }
+  }
+
+  return hit_anything;
+}
+
+// Packet counterpart of TraverseFlatBVH for the lanes set in `mask`. Calls
+// `leaf(first, count, lanes)` for every leaf with the lanes that reach it;
+// the callback returns the lanes that hit and lowers their `t_max`.
+template <typename LeafFn>
+[[nodiscard]] int TraverseFlatBVHPacket(std::span<const FlatBVHNode> nodes,
+                                        const RayPacket& packet, int mask,
+                                        double t_min,
+                                        const scene::PacketDistances& t_max,
+                                        LeafFn&& leaf) {
+  if (nodes.empty() || mask == 0) {
+    return 0;
+  }
+
+  const auto& kernels = simd::GetPacketKernels();
+  const auto box_mask = [&](const FlatBVHNode& node, int lanes) {
+    const auto& b = node.bounds_;
+    const double bounds[6] = {b.X().Min(), b.X().Max(), b.Y().Min(),
+                              b.Y().Max(), b.Z().Min(), b.Z().Max()};
+    return kernels.box(packet.Lanes(), bounds, t_min, t_max.data(), lanes);
+  };
+
+  // Children are ordered by the first active ray; rays in a packet are
+  // coherent enough that the other lanes almost always agree.
+  const auto& lead = packet[std::countr_zero(static_cast<unsigned>(mask))];
+
+  struct Entry {
+    std::uint32_t node;
+    int mask;
+  };
+  Entry stack[kFlatBVHStackSize];
+  int stack_size = 0;
+
+  std::uint32_t current = 0;
+  int node_mask = box_mask(nodes[0], mask);
+  int hits = 0;
+
+  while (true) {
+    if (node_mask != 0) {
+      const auto& node = nodes[current];
+
+      if (node.IsLeaf()) {
+        hits |= leaf(node.offset_, node.count_, node_mask);
+      } else {
+        auto near_index = current + 1;
+        auto far_index = node.offset_;
+        if (lead.Direction()[node.axis_] < 0) {
+          std::swap(near_index, far_index);
+        }
+
+        const int near_mask = box_mask(nodes[near_index], node_mask);
+        const int far_mask = box_mask(nodes[far_index], node_mask);
+        if (far_mask != 0) {
+          stack[stack_size++] = {far_index, far_mask};
+        }
+        if (near_mask != 0) {
+          current = near_index;
+          node_mask = near_mask;
+          continue;
+        }
+      }
+    }
+
+    if (stack_size == 0) {
+      break;
+    }
+
+    // Re-test on the way out: lanes may have found closer hits since the
+    // node was pushed.
+    const auto entry = stack[--stack_size];
+    current = entry.node;
+    node_mask = box_mask(nodes[current], entry.mask);
+  }
+
+  return hits;
+}
+
+// Cache-friendly replacement for BVHNode. The tree lives in one contiguous
+// array and leaves cover runs of a primitive store kept in leaf order, so
+// traversal is a loop over nodes and arrays rather than a chain of virtual
+// calls through shared pointers.
+class FlatBVH : public scene::Hittable {
+ public:
+  explicit FlatBVH(const scene::PrimitiveStore& primitives,
+                   const BVHBuildOptions& options = {});
+  explicit FlatBVH(const scene::HittableList& list,
+                   const BVHBuildOptions& options = {});
+
+  [[nodiscard]] bool Hit(const math::Ray& r, const math::Interval& t_interval,
+                         scene::HitInfo& rec) const override;
+
+  [[nodiscard]] int HitPacket(const math::RayPacket& packet, int mask,
+                              double t_min, scene::PacketDistances& t_max,
+                              scene::PacketHitInfo& rec) const override;
+
+  [[nodiscard]] math::AABB GetBounds() const override;
+
+  [[nodiscard]] std::size_t NodeCount() const { return nodes_.size(); }
+  [[nodiscard]] const BVHBuildStats& BuildStats() const { return stats_; }
+
+ private:
+  BVHBuildStats stats_;
+  std::vector<FlatBVHNode> nodes_;
+  scene::PrimitiveStore primitives_;  // Leaf order
+};
+
+}  // namespace polaris::math
+
+#endif
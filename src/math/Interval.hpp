@@ -1,59 +1,65 @@
 #ifndef POLARIS_MATH_INTERVAL_HPP
 #define POLARIS_MATH_INTERVAL_HPP
 
+#include <concepts>
 #include <limits>
+#include <math/Common.hpp>
 
 namespace polaris::math {
 
-class Interval {
+template <std::floating_point T>
+class BasicInterval {
  public:
-  constexpr Interval() noexcept
-      : min_(std::numeric_limits<double>::max()),
-        max_(std::numeric_limits<double>::lowest()) {}
+  constexpr BasicInterval() noexcept
+      : min_(std::numeric_limits<T>::max()),
+        max_(std::numeric_limits<T>::lowest()) {}
 
-  constexpr Interval(double min_val, double max_val) noexcept
+  constexpr BasicInterval(T min_val, T max_val) noexcept
       : min_(min_val), max_(max_val) {}
 
-  [[nodiscard]] constexpr double Min() const { return min_; }
-  [[nodiscard]] constexpr double Max() const { return max_; }
+  [[nodiscard]] constexpr T Min() const { return min_; }
+  [[nodiscard]] constexpr T Max() const { return max_; }
 
-  void SetMin(double min_val) { min_ = min_val; }
-  void SetMax(double max_val) { max_ = max_val; }
+  void SetMin(T min_val) { min_ = min_val; }
+  void SetMax(T max_val) { max_ = max_val; }
 
-  [[nodiscard]] constexpr double Size() const noexcept { return max_ - min_; }
+  [[nodiscard]] constexpr T Size() const noexcept { return max_ - min_; }
 
-  constexpr Interval Expand(double delta) const noexcept {
+  constexpr BasicInterval Expand(T delta) const noexcept {
     auto padding = delta / 2;
     return {min_ - padding, max_ + padding};
   }
 
-  [[nodiscard]] constexpr bool Surrounds(double X) const noexcept {
+  [[nodiscard]] constexpr bool Surrounds(T X) const noexcept {
     return min_ < X && X < max_;
   }
 
-  [[nodiscard]] constexpr double Clamp(double X) const noexcept {
+  [[nodiscard]] constexpr T Clamp(T X) const noexcept {
     if (X < min_) return min_;
     if (X > max_) return max_;
     return X;
   }
 
-  [[nodiscard]] constexpr bool Contains(double X) const noexcept {
+  [[nodiscard]] constexpr bool Contains(T X) const noexcept {
     return min_ <= X && X <= max_;
   }
 
-  [[nodiscard]] constexpr bool Overlaps(const Interval& other) const noexcept {
+  [[nodiscard]] constexpr bool Overlaps(
+      const BasicInterval& other) const noexcept {
     return min_ <= other.max_ && other.min_ <= max_;
   }
 
-  [[nodiscard]] static constexpr Interval Infinite() noexcept {
-    return Interval{-std::numeric_limits<double>::infinity(),
-                    std::numeric_limits<double>::infinity()};
+  [[nodiscard]] static constexpr BasicInterval Infinite() noexcept {
+    return BasicInterval{-std::numeric_limits<T>::infinity(),
+                         std::numeric_limits<T>::infinity()};
   }
 
  private:
-  double min_, max_;
+  T min_, max_;
 };
 
+using Interval = BasicInterval<Real>;
+
 }  // namespace polaris::math
 
 #endif
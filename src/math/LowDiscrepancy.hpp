@@ -0,0 +1,94 @@
+#ifndef POLARIS_MATH_LOW_DISCREPANCY_HPP
+#define POLARIS_MATH_LOW_DISCREPANCY_HPP
+
+#include <array>
+#include <cstdint>
+
+namespace polaris::math {
+
+[[nodiscard]] constexpr std::uint32_t ReverseBits32(std::uint32_t v) noexcept {
+  v = ((v >> 1U) & 0x55555555U) | ((v & 0x55555555U) << 1U);
+  v = ((v >> 2U) & 0x33333333U) | ((v & 0x33333333U) << 2U);
+  v = ((v >> 4U) & 0x0f0f0f0fU) | ((v & 0x0f0f0f0fU) << 4U);
+  v = ((v >> 8U) & 0x00ff00ffU) | ((v & 0x00ff00ffU) << 8U);
+  return (v >> 16U) | (v << 16U);
+}
+
+namespace detail {
+// Generator matrix columns of the first two Sobol dimensions, bit reversed so
+// that bit i of a point depends on bit i of the index. Dimension 0 is the van
+// der Corput sequence and dimension 1 follows from the primitive polynomial
+// x + 1, whose direction numbers satisfy v[i] = v[i - 1] ^ (v[i - 1] >> 1).
+constexpr std::array<std::array<std::uint32_t, 32>, 2>
+MakeReversedSobolMatrices() {
+  std::array<std::array<std::uint32_t, 32>, 2> matrices{};
+  std::uint32_t v = 1U << 31U;
+  for (std::uint32_t i = 0; i < 32; ++i) {
+    matrices[0][i] = 1U << i;
+    matrices[1][i] = ReverseBits32(v);
+    v ^= v >> 1U;
+  }
+  return matrices;
+}
+
+inline constexpr auto kReversedSobolMatrices = MakeReversedSobolMatrices();
+
+// Hash-based Owen scrambling in the bit-reversed domain (Laine and Karras, as
+// refined by Burley): each bit is flipped depending on a hash of the bits
+// below it, i.e. the more significant bits of the unreversed value.
+[[nodiscard]] constexpr std::uint32_t LaineKarrasPermutation(
+    std::uint32_t v, std::uint32_t seed) noexcept {
+  v ^= v * 0x3d20adeaU;
+  v += seed;
+  v *= (seed >> 16U) | 1U;
+  v ^= v * 0x05526c56U;
+  v ^= v * 0x53a22864U;
+  return v;
+}
+}  // namespace detail
+
+// Point `index` of Sobol dimension 0 or 1 as 32 fixed-point bits
+[[nodiscard]] constexpr std::uint32_t SobolBits(std::uint32_t index,
+                                                int dimension) noexcept {
+  // Branch-free, since sample indices arrive in no predictable order
+  std::uint32_t v = 0;
+  for (std::size_t i = 0; index != 0; index >>= 1U, ++i) {
+    v ^= detail::kReversedSobolMatrices[dimension][i] & (0U - (index & 1U));
+  }
+  return ReverseBits32(v);
+}
+
+// Owen scrambling keeps the stratification of the sequence while
+// decorrelating pixels and dimensions that use different seeds. Applied to a
+// sample index it shuffles the order of the points such that every
+// power-of-two prefix is still an aligned block of the sequence, so any such
+// number of samples stays well stratified.
+[[nodiscard]] constexpr std::uint32_t OwenScramble(
+    std::uint32_t v, std::uint32_t seed) noexcept {
+  return ReverseBits32(
+      detail::LaineKarrasPermutation(ReverseBits32(v), seed));
+}
+
+// OwenScramble() that maps every range [0, 2^k) onto itself. The bits above
+// an index's highest set bit are scrambled the same way as those of 0, so
+// cancelling them against the scramble of 0 leaves them clear. A shuffled
+// sample index then keeps its point however many samples follow it.
+[[nodiscard]] constexpr std::uint32_t NestedOwenScramble(
+    std::uint32_t v, std::uint32_t seed) noexcept {
+  return OwenScramble(v, seed) ^ OwenScramble(0, seed);
+}
+
+// Owen-scrambled SobolBits(). Scrambling in the reversed domain saves the two
+// bit reversals OwenScramble(SobolBits()) would cancel out.
+[[nodiscard]] constexpr std::uint32_t ScrambledSobolBits(
+    std::uint32_t index, int dimension, std::uint32_t seed) noexcept {
+  std::uint32_t v = 0;
+  for (std::size_t i = 0; index != 0; index >>= 1U, ++i) {
+    v ^= detail::kReversedSobolMatrices[dimension][i] & (0U - (index & 1U));
+  }
+  return ReverseBits32(detail::LaineKarrasPermutation(v, seed));
+}
+
+}  // namespace polaris::math
+
+#endif
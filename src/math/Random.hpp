@@ -0,0 +1,116 @@
+#ifndef POLARIS_MATH_RANDOM_HPP
+#define POLARIS_MATH_RANDOM_HPP
+
+#include <concepts>
+#include <cstdint>
+#include <limits>
+
+namespace polaris::math {
+
+// 64-bit finaliser (Stafford's "Mix13" variant of the MurmurHash3 mix), good
+// enough to turn consecutive integers into independent looking bits.
+[[nodiscard]] constexpr std::uint64_t MixBits(std::uint64_t v) noexcept {
+  v ^= v >> 31;
+  v *= 0x7fb5d329728ea185ULL;
+  v ^= v >> 27;
+  v *= 0x81dadef4bc2dd44dULL;
+  v ^= v >> 33;
+  return v;
+}
+
+[[nodiscard]] constexpr std::uint64_t HashCombine(std::uint64_t seed,
+                                                  std::uint64_t v) noexcept {
+  return MixBits(seed ^ (v + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2)));
+}
+
+// Hashes a tuple of integers, e.g. (seed, x, y, sample, dimension)
+template <std::integral... Args>
+[[nodiscard]] constexpr std::uint64_t Hash(Args... args) noexcept {
+  std::uint64_t h = 0;
+  ((h = HashCombine(h, static_cast<std::uint64_t>(args))), ...);
+  return h;
+}
+
+// Maps 32 random bits to [0, 1)
+template <std::floating_point T>
+[[nodiscard]] constexpr T BitsToUnit(std::uint32_t bits) noexcept {
+  constexpr T kOneMinusEpsilon = T(1) - std::numeric_limits<T>::epsilon() / 2;
+  const T value = static_cast<T>(bits) * T(0x1p-32);
+  return value < kOneMinusEpsilon ? value : kOneMinusEpsilon;
+}
+
+// PCG32 generator (O'Neill, "PCG: A Family of Simple Fast Space-Efficient
+// Statistically Good Algorithms for Random Number Generation"). Small, fast,
+// and able to jump to any point of a stream, which lets samplers derive the
+// state for a given pixel sample without touching the ones before it.
+class Pcg32 {
+ public:
+  using result_type = std::uint32_t;
+
+  constexpr Pcg32() noexcept = default;
+  constexpr explicit Pcg32(std::uint64_t sequence,
+                           std::uint64_t seed = 0) noexcept {
+    SetSequence(sequence, seed);
+  }
+
+  // Selects one of 2^63 independent streams and a starting point within it
+  constexpr void SetSequence(std::uint64_t sequence,
+                             std::uint64_t seed = 0) noexcept {
+    state_ = 0;
+    inc_ = (sequence << 1U) | 1U;
+    Next();
+    state_ += kDefaultState + seed;
+    Next();
+  }
+
+  constexpr std::uint32_t Next() noexcept {
+    const auto old = state_;
+    state_ = (old * kMultiplier) + inc_;
+    const auto xorshifted =
+        static_cast<std::uint32_t>(((old >> 18U) ^ old) >> 27U);
+    const auto rot = static_cast<std::uint32_t>(old >> 59U);
+    return (xorshifted >> rot) | (xorshifted << ((~rot + 1U) & 31U));
+  }
+
+  // Skips `delta` outputs in O(log delta) steps
+  constexpr void Advance(std::uint64_t delta) noexcept {
+    std::uint64_t cur_mult = kMultiplier;
+    std::uint64_t cur_plus = inc_;
+    std::uint64_t acc_mult = 1;
+    std::uint64_t acc_plus = 0;
+    while (delta > 0) {
+      if ((delta & 1U) != 0) {
+        acc_mult *= cur_mult;
+        acc_plus = (acc_plus * cur_mult) + cur_plus;
+      }
+      cur_plus = (cur_mult + 1) * cur_plus;
+      cur_mult *= cur_mult;
+      delta /= 2;
+    }
+    state_ = (acc_mult * state_) + acc_plus;
+  }
+
+  template <std::floating_point T>
+  [[nodiscard]] constexpr T Uniform() noexcept {
+    return BitsToUnit<T>(Next());
+  }
+
+  // UniformRandomBitGenerator interface for the std distributions
+  static constexpr result_type min() { return 0; }
+  static constexpr result_type max() {
+    return std::numeric_limits<result_type>::max();
+  }
+  constexpr result_type operator()() noexcept { return Next(); }
+
+ private:
+  static constexpr std::uint64_t kDefaultState = 0x853c49e6748fea9bULL;
+  static constexpr std::uint64_t kDefaultStream = 0xda3e39cb94b95bdbULL;
+  static constexpr std::uint64_t kMultiplier = 0x5851f42d4c957f2dULL;
+
+  std::uint64_t state_ = kDefaultState;
+  std::uint64_t inc_ = kDefaultStream;
+};
+
+}  // namespace polaris::math
+
+#endif
@@ -1,35 +1,77 @@
 #ifndef POLARIS_MATH_RAY_HPP
 #define POLARIS_MATH_RAY_HPP
 
+#include <bit>
+#include <cmath>
+#include <concepts>
+#include <cstdint>
 #include <math/Vec.hpp>
+#include <type_traits>
 
 namespace polaris::math {
 
-class Ray {
+template <std::floating_point T>
+class BasicRay {
  public:
-  Ray() = default;
-  Ray(const Vec3& origin, const Vec3&direction, double time)
+  using Vec = Vector<T, 3>;
+
+  BasicRay() = default;
+  BasicRay(const Vec& origin, const Vec& direction, T time)
       : origin_(origin),
         direction_(direction),
-        inv_direction_(1.0 / direction.X(), 1.0 / direction.Y(),
-                       1.0 / direction.Z()),
+        inv_direction_(T(1) / direction.X(), T(1) / direction.Y(),
+                       T(1) / direction.Z()),
         tm_(time) {}
-  Ray(const Vec3& origin, const Vec3& direction)
-      : Ray(origin, direction, 0) {}
+  BasicRay(const Vec& origin, const Vec& direction)
+      : BasicRay(origin, direction, 0) {}
 
-  [[nodiscard]] const Vec3& Origin() const { return origin_; }
-  [[nodiscard]] const Vec3& Direction() const { return direction_; }
-  [[nodiscard]] double Time() const { return tm_; }
-  [[nodiscard]] const Vec3& InverseDirection() const { return inv_direction_; }
+  [[nodiscard]] const Vec& Origin() const { return origin_; }
+  [[nodiscard]] const Vec& Direction() const { return direction_; }
+  [[nodiscard]] T Time() const { return tm_; }
+  [[nodiscard]] const Vec& InverseDirection() const { return inv_direction_; }
 
-  [[nodiscard]] Vec3 at(double t) const { return origin_ + t * direction_; }
+  [[nodiscard]] Vec at(T t) const { return origin_ + t * direction_; }
 
  private:
-  Vec3 origin_;
-  Vec3 direction_;
-  Vec3 inv_direction_;
-  double tm_;
+  Vec origin_;
+  Vec direction_;
+  Vec inv_direction_;
+  T tm_;
 };
+
+using Ray = BasicRay<Real>;
+
+// Nudges a hit point off its surface towards the side `n` points to, so rays
+// spawned there do not hit the surface again. The offset is a fixed number of
+// ULPs of each coordinate rather than a fixed distance, which keeps it above
+// the rounding error of the hit point at any scale and in either precision
+// (Wächter and Binder, "A Fast and Robust Method for Avoiding
+// Self-Intersection").
+template <std::floating_point T>
+[[nodiscard]] Vector<T, 3> OffsetRayOrigin(const Vector<T, 3>& p,
+                                           const Vector<T, 3>& n) {
+  using Bits =
+      std::conditional_t<sizeof(T) == 4, std::int32_t, std::int64_t>;
+
+  // Below kOrigin the ULP gets too small, so use a plain distance instead
+  constexpr T kOrigin = T(1) / 32;
+  constexpr T kFloatScale = sizeof(T) == 4 ? T(1) / 65536 : T(1) / 0x1p45;
+  constexpr T kIntScale = 256;
+
+  Vector<T, 3> result;
+  for (std::size_t i = 0; i < 3; ++i) {
+    if (std::fabs(p[i]) < kOrigin) {
+      result[i] = p[i] + (kFloatScale * n[i]);
+      continue;
+    }
+
+    const auto offset = static_cast<Bits>(kIntScale * n[i]);
+    const auto bits = std::bit_cast<Bits>(p[i]);
+    result[i] = std::bit_cast<T>(p[i] < 0 ? bits - offset : bits + offset);
+  }
+  return result;
+}
+
 }  // namespace polaris::math
 
 #endif
@@ -0,0 +1,43 @@
+#ifndef POLARIS_MATH_RAY_PACKET_HPP
+#define POLARIS_MATH_RAY_PACKET_HPP
+
+#include <array>
+#include <math/Ray.hpp>
+#include <math/simd/PacketTypes.hpp>
+
+namespace polaris::math {
+
+// A small bundle of rays traced together. Each ray is kept both as a regular
+// Ray for scalar code and in structure-of-arrays form for the SIMD kernels.
+class RayPacket {
+ public:
+  static constexpr int kWidth = simd::kPacketWidth;
+  static constexpr int kFullMask = (1 << kWidth) - 1;
+
+  RayPacket() = default;
+
+  // Stores `r` in `lane` and marks the lane active.
+  void Set(int lane, const Ray& r) {
+    rays_[lane] = r;
+    for (int a = 0; a < 3; ++a) {
+      lanes_.origin[a][lane] = r.Origin()[a];
+      lanes_.direction[a][lane] = r.Direction()[a];
+      lanes_.inv_direction[a][lane] = r.InverseDirection()[a];
+    }
+    lanes_.time[lane] = r.Time();
+    active_ |= 1 << lane;
+  }
+
+  [[nodiscard]] const Ray& operator[](int lane) const { return rays_[lane]; }
+  [[nodiscard]] int ActiveMask() const { return active_; }
+  [[nodiscard]] const simd::PacketRays& Lanes() const { return lanes_; }
+
+ private:
+  simd::PacketRays lanes_{};
+  std::array<Ray, kWidth> rays_;
+  int active_ = 0;
+};
+
+}  // namespace polaris::math
+
+#endif
@@ -0,0 +1,156 @@
+#ifndef POLARIS_MATH_TRANSFORM_HPP
+#define POLARIS_MATH_TRANSFORM_HPP
+
+#include <array>
+#include <cmath>
+#include <concepts>
+#include <math/AABB.hpp>
+#include <math/Common.hpp>
+#include <math/Ray.hpp>
+#include <math/Vec.hpp>
+
+namespace polaris::math {
+
+// Affine map x -> A x + b kept together with its inverse. Transforms are only
+// made from translations, rotations and non-zero scales and combined with
+// operator*, so the inverse is always known without inverting a matrix.
+template <std::floating_point T>
+class BasicTransform {
+ public:
+  using Vec = Vector<T, 3>;
+  using Ray = BasicRay<T>;
+  using AABB = BasicAABB<T>;
+  using Matrix = std::array<std::array<T, 4>, 3>;  // Rows of [A | b]
+
+  BasicTransform() = default;
+
+  BasicTransform(const Matrix& forward, const Matrix& inverse)
+      : forward_(forward), inverse_(inverse) {}
+
+  [[nodiscard]] static BasicTransform Translate(const Vec& offset) {
+    BasicTransform result;
+    for (std::size_t i = 0; i < 3; ++i) {
+      result.forward_[i][3] = offset[i];
+      result.inverse_[i][3] = -offset[i];
+    }
+    return result;
+  }
+
+  // Every factor must be non-zero
+  [[nodiscard]] static BasicTransform Scale(const Vec& factors) {
+    BasicTransform result;
+    for (std::size_t i = 0; i < 3; ++i) {
+      result.forward_[i][i] = factors[i];
+      result.inverse_[i][i] = T(1) / factors[i];
+    }
+    return result;
+  }
+
+  // Counter-clockwise about `axis` when looking down it towards the origin
+  [[nodiscard]] static BasicTransform Rotate(const Vec& axis, T degrees) {
+    const auto a = axis.Normalized();
+    const auto radians = static_cast<T>(DegreesToRadians(degrees));
+    const T s = std::sin(radians);
+    const T c = std::cos(radians);
+
+    BasicTransform result;
+    for (std::size_t i = 0; i < 3; ++i) {
+      for (std::size_t j = 0; j < 3; ++j) {
+        T entry = a[i] * a[j] * (1 - c);
+        if (i == j) {
+          entry += c;
+        } else {
+          // Cross product term; k is the remaining axis
+          const std::size_t k = 3 - i - j;
+          const T sign = (j == (i + 1) % 3) ? -1 : 1;
+          entry += sign * a[k] * s;
+        }
+        result.forward_[i][j] = entry;
+        result.inverse_[j][i] = entry;  // Rotations are orthogonal
+      }
+    }
+    return result;
+  }
+
+  // The map that applies `rhs` first and then this one
+  [[nodiscard]] BasicTransform operator*(const BasicTransform& rhs) const {
+    return {Multiply(forward_, rhs.forward_),
+            Multiply(rhs.inverse_, inverse_)};
+  }
+
+  [[nodiscard]] BasicTransform Inverse() const { return {inverse_, forward_}; }
+
+  [[nodiscard]] Vec Point(const Vec& p) const { return Apply(forward_, p, 1); }
+  [[nodiscard]] Vec Direction(const Vec& v) const {
+    return Apply(forward_, v, 0);
+  }
+
+  // Normals map by the inverse transpose, which keeps them perpendicular to
+  // the transformed surface. The result is not normalised.
+  [[nodiscard]] Vec Normal(const Vec& n) const {
+    Vec result;
+    for (std::size_t i = 0; i < 3; ++i) {
+      result[i] = (inverse_[0][i] * n[0]) + (inverse_[1][i] * n[1]) +
+                  (inverse_[2][i] * n[2]);
+    }
+    return result;
+  }
+
+  // Maps the ray without normalising its direction, so a distance t along
+  // the result is the same distance t along `r`
+  [[nodiscard]] Ray operator()(const Ray& r) const {
+    return {Point(r.Origin()), Direction(r.Direction()), r.Time()};
+  }
+
+  // Box around the eight transformed corners of `box`
+  [[nodiscard]] AABB Bounds(const AABB& box) const {
+    AABB result;
+    for (int corner = 0; corner < 8; ++corner) {
+      const Vec p((corner & 1) != 0 ? box.X().Max() : box.X().Min(),
+                  (corner & 2) != 0 ? box.Y().Max() : box.Y().Min(),
+                  (corner & 4) != 0 ? box.Z().Max() : box.Z().Min());
+      const auto q = Point(p);
+      result = corner == 0 ? AABB(q, q) : AABB(result, AABB(q, q));
+    }
+    return result;
+  }
+
+  [[nodiscard]] const Matrix& Forward() const { return forward_; }
+  [[nodiscard]] const Matrix& InverseMatrix() const { return inverse_; }
+
+ private:
+  static constexpr Matrix kIdentity{{{1, 0, 0, 0}, {0, 1, 0, 0}, {0, 0, 1, 0}}};
+
+  static Vec Apply(const Matrix& m, const Vec& v, T w) {
+    Vec result;
+    for (std::size_t i = 0; i < 3; ++i) {
+      result[i] = (m[i][0] * v[0]) + (m[i][1] * v[1]) + (m[i][2] * v[2]) +
+                  (m[i][3] * w);
+    }
+    return result;
+  }
+
+  // Affine product a * b, reading both as 4x4 with a last row of 0 0 0 1
+  static Matrix Multiply(const Matrix& a, const Matrix& b) {
+    Matrix result{};
+    for (std::size_t i = 0; i < 3; ++i) {
+      for (std::size_t j = 0; j < 4; ++j) {
+        T sum = j == 3 ? a[i][3] : 0;
+        for (std::size_t k = 0; k < 3; ++k) {
+          sum += a[i][k] * b[k][j];
+        }
+        result[i][j] = sum;
+      }
+    }
+    return result;
+  }
+
+  Matrix forward_ = kIdentity;
+  Matrix inverse_ = kIdentity;
+};
+
+using Transform = BasicTransform<Real>;
+
+}  // namespace polaris::math
+
+#endif
@@ -153,12 +153,50 @@ class Vector {
 
   // Thanks GPT
   static Vector RandomUnitVector() requires (std::is_floating_point_v<T> && N == 3)  {
-    auto Z = RandomValue<T>(-1, 1);
-    auto a = RandomValue<T>(0, 2 * std::numbers::pi);
-    auto r = std::sqrt(1 - (Z * Z));
+    return UnitVectorFromSample(RandomValue<T>(), RandomValue<T>());
+  }
+
+  // Overloads drawing from a renderer sampler (anything with Get2D())
+  template <typename SamplerT>
+  static Vector RandomUnitVector(SamplerT& sampler) requires (std::is_floating_point_v<T> && N == 3) {
+    const auto u = sampler.Get2D();
+    return UnitVectorFromSample(T(u[0]), T(u[1]));
+  }
+
+  template <typename SamplerT>
+  static Vector RandomInUnitDisk(SamplerT& sampler) requires (std::is_floating_point_v<T> && N == 3) {
+    const auto u = sampler.Get2D();
+    return InUnitDiskFromSample(T(u[0]), T(u[1]));
+  }
+
+  // Maps a uniform sample in [0, 1)^2 to a uniform direction
+  static Vector UnitVectorFromSample(T u1, T u2) requires (std::is_floating_point_v<T> && N == 3) {
+    auto Z = 1 - (2 * u1);
+    auto a = 2 * std::numbers::pi_v<T> * u2;
+    auto r = std::sqrt(std::fmax(T(0), 1 - (Z * Z)));
     return Vector(r * std::cos(a), r * std::sin(a), Z);
   }
 
+  // Concentric mapping (Shirley and Chiu) of a sample in [0, 1)^2 onto the
+  // unit disk in the XY plane. Unlike rejection it uses exactly two values.
+  static Vector InUnitDiskFromSample(T u1, T u2) requires (std::is_floating_point_v<T> && N == 3) {
+    const T ox = (2 * u1) - 1;
+    const T oy = (2 * u2) - 1;
+    if (ox == 0 && oy == 0) { return Vector(0, 0, 0); }
+
+    constexpr T kQuarterPi = std::numbers::pi_v<T> / 4;
+    T r;
+    T theta;
+    if (std::fabs(ox) > std::fabs(oy)) {
+      r = ox;
+      theta = kQuarterPi * (oy / ox);
+    } else {
+      r = oy;
+      theta = (2 * kQuarterPi) - (kQuarterPi * (ox / oy));
+    }
+    return Vector(r * std::cos(theta), r * std::sin(theta), 0);
+  }
+
   static Vector RandomOnHemisphere(const Vector& normal) requires (std::is_floating_point_v<T> && N == 3) {
     const auto on_unit_sphere = RandomUnitVector();
     if (on_unit_sphere.Dot(normal) > 0.0) {
@@ -174,9 +212,9 @@ class Vector {
 
   Vector Refract(const Vector& n, T etai_over_etat) const requires (std::is_floating_point_v<T> && N == 3) {
     const auto& uv = *this;
-    auto cos_theta = std::fmin((-uv).Dot(n), 1.0);
+    auto cos_theta = std::fmin((-uv).Dot(n), T(1));
     Vector r_out_perp = etai_over_etat * (uv + cos_theta * n);
-    Vector r_out_parallel = -std::sqrt(std::fabs(1.0 - r_out_perp.LengthSquared())) * n;
+    Vector r_out_parallel = -std::sqrt(std::fabs(T(1) - r_out_perp.LengthSquared())) * n;
     return r_out_perp + r_out_parallel;
   }
 
@@ -192,8 +230,8 @@ class Vector {
   }
 };
 
-// old class compatibility
-using Vec3 = Vector<double, 3>;
+// old class compatibility, follows the precision of the geometry core
+using Vec3 = Vector<Real, 3>;
 // GLSL aliases
 using vec2 = Vector<float, 2>;
 using vec3 = Vector<float, 3>;
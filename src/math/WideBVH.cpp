@@ -0,0 +1,223 @@
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <limits>
+#include <math/WideBVH.hpp>
+#include <math/simd/PacketKernels.hpp>
+#include <utility>
+
+namespace polaris::math {
+
+namespace {
+// Child bounds are rounded outwards to float, so they hold the primitives
+// exactly. The ray is not: its origin is off by up to 2^-24 of its size, and
+// each slab distance is off by about 3 * 2^-24 of the distance from the
+// origin to the slab, which is at most the sum of the sizes of the origin and
+// the scene. Each traversal pads every box by this fraction of that sum,
+// which keeps every slab test conservative with room to spare, and widens
+// the far end of the ray interval likewise.
+constexpr double kRelativeSlack = 0x1p-21;
+
+// Top bit of a stack entry marks a leaf child, stored as (node << 2 | slot)
+constexpr std::uint32_t kLeafFlag = 0x80000000U;
+
+float RoundDown(double v) {
+  auto f = static_cast<float>(v);
+  if (static_cast<double>(f) > v) {
+    f = std::nextafter(f, -std::numeric_limits<float>::infinity());
+  }
+  return f;
+}
+
+float RoundUp(double v) {
+  auto f = static_cast<float>(v);
+  if (static_cast<double>(f) < v) {
+    f = std::nextafter(f, std::numeric_limits<float>::infinity());
+  }
+  return f;
+}
+}  // namespace
+
+WideBVH::WideBVH(const scene::PrimitiveStore& primitives,
+                 const BVHBuildOptions& options) {
+  std::vector<AABB> bounds;
+  bounds.reserve(primitives.Size());
+  for (std::size_t i = 0; i < primitives.Size(); ++i) {
+    bounds.push_back(primitives.Bounds(i));
+  }
+
+  std::vector<FlatBVHNode> binary;
+  std::vector<std::uint32_t> order;
+  stats_ = BuildFlatBVH(bounds, binary, order, options);
+  primitives_ = primitives.Reordered(order);
+
+  if (binary.empty()) {
+    return;
+  }
+
+  bounds_ = binary.front().bounds_;
+  for (int a = 0; a < 3; ++a) {
+    extent_ = std::max(
+        {extent_, std::fabs(static_cast<double>(bounds_.Axis(a).Min())),
+         std::fabs(static_cast<double>(bounds_.Axis(a).Max()))});
+  }
+
+  nodes_.reserve((binary.size() / 2) + 1);
+  Collapse(binary, 0);
+}
+
+WideBVH::WideBVH(const scene::HittableList& list,
+                 const BVHBuildOptions& options)
+    : WideBVH(list.Primitives(), options) {}
+
+std::uint32_t WideBVH::Collapse(std::span<const FlatBVHNode> binary,
+                                std::uint32_t index) {
+  constexpr int kWidth = WideBVHNode::kWidth;
+
+  const auto wide_index = static_cast<std::uint32_t>(nodes_.size());
+  nodes_.emplace_back();
+
+  // Open up the largest interior children until all slots are used
+  std::uint32_t children[kWidth];
+  int child_count = 0;
+  if (binary[index].IsLeaf()) {
+    children[child_count++] = index;
+  } else {
+    children[child_count++] = index + 1;
+    children[child_count++] = binary[index].offset_;
+  }
+
+  while (child_count < kWidth) {
+    int best = -1;
+    double best_area = -1.0;
+    for (int i = 0; i < child_count; ++i) {
+      const auto& child = binary[children[i]];
+      if (!child.IsLeaf() && child.bounds_.SurfaceArea() > best_area) {
+        best = i;
+        best_area = child.bounds_.SurfaceArea();
+      }
+    }
+    if (best < 0) {
+      break;
+    }
+
+    const auto opened = children[best];
+    children[best] = opened + 1;
+    children[child_count++] = binary[opened].offset_;
+  }
+
+  WideBVHNode wide;
+  for (int i = 0; i < kWidth; ++i) {
+    for (int a = 0; a < 3; ++a) {
+      wide.bounds_.min[a][i] = std::numeric_limits<float>::infinity();
+      wide.bounds_.max[a][i] = -std::numeric_limits<float>::infinity();
+    }
+  }
+
+  for (int i = 0; i < child_count; ++i) {
+    const auto& child = binary[children[i]];
+    for (int a = 0; a < 3; ++a) {
+      wide.bounds_.min[a][i] = RoundDown(child.bounds_.Axis(a).Min());
+      wide.bounds_.max[a][i] = RoundUp(child.bounds_.Axis(a).Max());
+    }
+
+    if (child.IsLeaf()) {
+      wide.child_[i] = child.offset_;
+      wide.count_[i] = child.count_;
+    } else {
+      wide.child_[i] = Collapse(binary, children[i]);
+    }
+    wide.valid_mask_ |= static_cast<std::uint8_t>(1U << i);
+  }
+
+  nodes_[wide_index] = wide;
+  return wide_index;
+}
+
+bool WideBVH::Hit(const math::Ray& r, const math::Interval& t_interval,
+                  scene::HitInfo& rec) const {
+  // Every level defers at most three children, and the collapsed tree is no
+  // deeper than the binary one.
+  constexpr int kStackSize = (3 * 128) + 1;
+  constexpr int kWidth = WideBVHNode::kWidth;
+
+  if (nodes_.empty()) {
+    return false;
+  }
+
+  const auto& kernels = simd::GetPacketKernels();
+
+  simd::WideRay ray{};
+  double reach = extent_;
+  for (int a = 0; a < 3; ++a) {
+    ray.origin[a] = static_cast<float>(r.Origin()[a]);
+    ray.inv_direction[a] = static_cast<float>(r.InverseDirection()[a]);
+    reach = std::max(reach,
+                     extent_ + std::fabs(static_cast<double>(r.Origin()[a])));
+  }
+  ray.slack = RoundUp(reach * kRelativeSlack);
+  const float t_min = RoundDown(t_interval.Min());
+
+  struct Entry {
+    std::uint32_t ref;  // Node index, or a leaf child when kLeafFlag is set
+    float t_entry;
+  };
+  Entry stack[kStackSize];
+  int stack_size = 0;
+  stack[stack_size++] = {0, t_min};
+
+  bool hit_anything = false;
+  Real closest_so_far = t_interval.Max();
+  float t_far = RoundUp(closest_so_far * (1.0 + kRelativeSlack));
+
+  while (stack_size > 0) {
+    const auto entry = stack[--stack_size];
+    if (entry.t_entry > t_far) {
+      continue;
+    }
+
+    if ((entry.ref & kLeafFlag) != 0) {
+      const auto& node = nodes_[(entry.ref & ~kLeafFlag) >> 2];
+      const auto slot = entry.ref & 3U;
+      if (primitives_.HitRange(node.child_[slot], node.count_[slot], r,
+                               t_interval.Min(), closest_so_far, rec)) {
+        hit_anything = true;
+      }
+      t_far = RoundUp(closest_so_far * (1.0 + kRelativeSlack));
+      continue;
+    }
+
+    const auto& node = nodes_[entry.ref];
+    alignas(16) float t_entry[kWidth];
+    int mask = kernels.wide_box(node.bounds_, ray, t_min, t_far, t_entry) &
+               node.valid_mask_;
+
+    // Push far to near so the nearest child is popped first
+    int order[kWidth];
+    int hit_count = 0;
+    while (mask != 0) {
+      const int child = std::countr_zero(static_cast<unsigned>(mask));
+      mask &= mask - 1;
+
+      int pos = hit_count++;
+      while (pos > 0 && t_entry[order[pos - 1]] < t_entry[child]) {
+        order[pos] = order[pos - 1];
+        --pos;
+      }
+      order[pos] = child;
+    }
+
+    for (int k = 0; k < hit_count; ++k) {
+      const int child = order[k];
+      const auto ref = node.IsLeaf(child)
+                           ? kLeafFlag | (entry.ref << 2) |
+                                 static_cast<std::uint32_t>(child)
+                           : node.child_[child];
+      stack[stack_size++] = {ref, t_entry[child]};
+    }
+  }
+
+  return hit_anything;
+}
+
+}  // namespace polaris::math
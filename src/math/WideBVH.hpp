@@ -0,0 +1,65 @@
+#ifndef POLARIS_MATH_WIDE_BVH_HPP
+#define POLARIS_MATH_WIDE_BVH_HPP
+
+#include <cstdint>
+#include <math/AABB.hpp>
+#include <math/FlatBVH.hpp>
+#include <math/Interval.hpp>
+#include <math/Ray.hpp>
+#include <math/simd/PacketTypes.hpp>
+#include <memory>
+#include <scene/Hittable.hpp>
+#include <scene/HittableList.hpp>
+#include <scene/PrimitiveStore.hpp>
+#include <span>
+#include <vector>
+
+namespace polaris::math {
+
+// Node of a 4-wide BVH. The bounds of all children sit side by side in float
+// SoA layout so a single SIMD slab test covers every child at once.
+struct alignas(64) WideBVHNode {
+  static constexpr int kWidth = simd::kWideWidth;
+
+  simd::WideBounds bounds_;
+  std::uint32_t child_[kWidth] = {};  // Node index, or first primitive
+  std::uint16_t count_[kWidth] = {};  // Primitives in a leaf child, else 0
+  std::uint8_t valid_mask_ = 0;       // Children that are in use
+
+  [[nodiscard]] bool IsLeaf(int child) const noexcept {
+    return count_[child] != 0;
+  }
+};
+
+// BVH4 built by collapsing the binary SAH tree of FlatBVH. Aimed at single
+// rays such as incoherent secondary bounces, where it visits far fewer nodes
+// than the binary tree and tests them four at a time.
+class WideBVH : public scene::Hittable {
+ public:
+  explicit WideBVH(const scene::PrimitiveStore& primitives,
+                   const BVHBuildOptions& options = {});
+  explicit WideBVH(const scene::HittableList& list,
+                   const BVHBuildOptions& options = {});
+
+  [[nodiscard]] bool Hit(const math::Ray& r, const math::Interval& t_interval,
+                         scene::HitInfo& rec) const override;
+
+  [[nodiscard]] math::AABB GetBounds() const override { return bounds_; }
+
+  [[nodiscard]] std::size_t NodeCount() const { return nodes_.size(); }
+  [[nodiscard]] const BVHBuildStats& BuildStats() const { return stats_; }
+
+ private:
+  std::uint32_t Collapse(std::span<const FlatBVHNode> binary,
+                         std::uint32_t index);
+
+  BVHBuildStats stats_;  // Of the binary tree that was collapsed
+  math::AABB bounds_;
+  double extent_ = 0.0;  // Largest coordinate size of the scene bounds
+  std::vector<WideBVHNode> nodes_;
+  scene::PrimitiveStore primitives_;  // Leaf order
+};
+
+}  // namespace polaris::math
+
+#endif
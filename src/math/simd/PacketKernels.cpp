@@ -0,0 +1,208 @@
+#include <algorithm>
+#include <cmath>
+#include <math/simd/PacketKernels.hpp>
+#include <math/simd/PacketKernelsImpl.hpp>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <immintrin.h>
+#include <intrin.h>
+#endif
+
+namespace polaris::math::simd {
+
+namespace {
+// Plain C++ fallback, one lane at a time.
+struct ScalarOps {
+  struct Vec {
+    double v[kPacketWidth];
+  };
+
+  template <typename Fn>
+  static Vec Apply(const Vec& a, const Vec& b, Fn fn) {
+    Vec r{};
+    for (int i = 0; i < kPacketWidth; ++i) {
+      r.v[i] = fn(a.v[i], b.v[i]);
+    }
+    return r;
+  }
+
+  // Comparisons produce 1.0 for true and 0.0 for false
+  static double Bool(bool b) { return b ? 1.0 : 0.0; }
+
+  static Vec Load(const double* p) {
+    Vec r{};
+    std::copy_n(p, kPacketWidth, r.v);
+    return r;
+  }
+  static void Store(double* p, const Vec& v) { std::copy_n(v.v, kPacketWidth, p); }
+  static Vec Set1(double x) { return {{x, x, x, x}}; }
+
+  static Vec Add(const Vec& a, const Vec& b) {
+    return Apply(a, b, [](double x, double y) { return x + y; });
+  }
+  static Vec Sub(const Vec& a, const Vec& b) {
+    return Apply(a, b, [](double x, double y) { return x - y; });
+  }
+  static Vec Mul(const Vec& a, const Vec& b) {
+    return Apply(a, b, [](double x, double y) { return x * y; });
+  }
+  static Vec Div(const Vec& a, const Vec& b) {
+    return Apply(a, b, [](double x, double y) { return x / y; });
+  }
+  static Vec Min(const Vec& a, const Vec& b) {
+    return Apply(a, b, [](double x, double y) { return x < y ? x : y; });
+  }
+  static Vec Max(const Vec& a, const Vec& b) {
+    return Apply(a, b, [](double x, double y) { return x > y ? x : y; });
+  }
+  static Vec Sqrt(const Vec& a) {
+    return Apply(a, a, [](double x, double) { return std::sqrt(x); });
+  }
+  static Vec Abs(const Vec& a) {
+    return Apply(a, a, [](double x, double) { return std::fabs(x); });
+  }
+
+  static Vec Lt(const Vec& a, const Vec& b) {
+    return Apply(a, b, [](double x, double y) { return Bool(x < y); });
+  }
+  static Vec Le(const Vec& a, const Vec& b) {
+    return Apply(a, b, [](double x, double y) { return Bool(x <= y); });
+  }
+  static Vec Ge(const Vec& a, const Vec& b) {
+    return Apply(a, b, [](double x, double y) { return Bool(x >= y); });
+  }
+  static Vec And(const Vec& a, const Vec& b) {
+    return Apply(a, b, [](double x, double y) { return Bool(x != 0 && y != 0); });
+  }
+  static Vec Or(const Vec& a, const Vec& b) {
+    return Apply(a, b, [](double x, double y) { return Bool(x != 0 || y != 0); });
+  }
+
+  static Vec Select(const Vec& mask, const Vec& a, const Vec& b) {
+    Vec r{};
+    for (int i = 0; i < kPacketWidth; ++i) {
+      r.v[i] = mask.v[i] != 0 ? a.v[i] : b.v[i];
+    }
+    return r;
+  }
+  static int MoveMask(const Vec& mask) {
+    int bits = 0;
+    for (int i = 0; i < kPacketWidth; ++i) {
+      bits |= (mask.v[i] != 0 ? 1 : 0) << i;
+    }
+    return bits;
+  }
+};
+
+struct ScalarWideOps {
+  struct Vec {
+    float v[kWideWidth];
+  };
+
+  template <typename Fn>
+  static Vec Apply(const Vec& a, const Vec& b, Fn fn) {
+    Vec r{};
+    for (int i = 0; i < kWideWidth; ++i) {
+      r.v[i] = fn(a.v[i], b.v[i]);
+    }
+    return r;
+  }
+
+  static Vec Load(const float* p) {
+    Vec r{};
+    std::copy_n(p, kWideWidth, r.v);
+    return r;
+  }
+  static void Store(float* p, const Vec& v) { std::copy_n(v.v, kWideWidth, p); }
+  static Vec Set1(float x) { return {{x, x, x, x}}; }
+
+  static Vec Add(const Vec& a, const Vec& b) {
+    return Apply(a, b, [](float x, float y) { return x + y; });
+  }
+  static Vec Sub(const Vec& a, const Vec& b) {
+    return Apply(a, b, [](float x, float y) { return x - y; });
+  }
+  static Vec Mul(const Vec& a, const Vec& b) {
+    return Apply(a, b, [](float x, float y) { return x * y; });
+  }
+  static Vec Min(const Vec& a, const Vec& b) {
+    return Apply(a, b, [](float x, float y) { return x < y ? x : y; });
+  }
+  static Vec Max(const Vec& a, const Vec& b) {
+    return Apply(a, b, [](float x, float y) { return x > y ? x : y; });
+  }
+  static Vec Le(const Vec& a, const Vec& b) {
+    return Apply(a, b, [](float x, float y) { return x <= y ? 1.0F : 0.0F; });
+  }
+  static int MoveMask(const Vec& mask) {
+    int bits = 0;
+    for (int i = 0; i < kWideWidth; ++i) {
+      bits |= (mask.v[i] != 0 ? 1 : 0) << i;
+    }
+    return bits;
+  }
+};
+
+bool CpuHasAvx2() {
+#if (defined(__GNUC__) || defined(__clang__)) && \
+    (defined(__x86_64__) || defined(__i386__))
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2");
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+  int info[4];
+  __cpuid(info, 0);
+  if (info[0] < 7) {
+    return false;
+  }
+
+  // The OS must also save the YMM registers on context switches
+  __cpuid(info, 1);
+  const bool osxsave = (info[2] & (1 << 27)) != 0;
+  const bool avx = (info[2] & (1 << 28)) != 0;
+  if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) {
+    return false;
+  }
+
+  __cpuidex(info, 7, 0);
+  return (info[1] & (1 << 5)) != 0;
+#else
+  return false;
+#endif
+}
+}  // namespace
+
+const PacketKernels& ScalarPacketKernels() {
+  static const PacketKernels kernels = MakePacketKernels<ScalarOps, ScalarWideOps>();
+  return kernels;
+}
+
+SimdLevel DetectSimdLevel() {
+  static const SimdLevel level = [] {
+    if (Avx2PacketKernels() != nullptr && CpuHasAvx2()) {
+      return SimdLevel::AVX2;
+    }
+    if (Sse2PacketKernels() != nullptr) {
+      return SimdLevel::SSE2;
+    }
+    return SimdLevel::Scalar;
+  }();
+  return level;
+}
+
+const PacketKernels& GetPacketKernels() {
+  static const PacketKernels& kernels = GetPacketKernels(DetectSimdLevel());
+  return kernels;
+}
+
+const PacketKernels& GetPacketKernels(SimdLevel level) {
+  level = std::min(level, DetectSimdLevel());
+  if (level == SimdLevel::AVX2) {
+    return *Avx2PacketKernels();
+  }
+  if (level == SimdLevel::SSE2) {
+    return *Sse2PacketKernels();
+  }
+  return ScalarPacketKernels();
+}
+
+}  // namespace polaris::math::simd
@@ -0,0 +1,19 @@
+#ifndef POLARIS_MATH_SIMD_PACKET_KERNELS_HPP
+#define POLARIS_MATH_SIMD_PACKET_KERNELS_HPP
+
+#include <math/simd/PacketTypes.hpp>
+
+namespace polaris::math::simd {
+
+// Widest instruction set supported by both this build and the running CPU.
+[[nodiscard]] SimdLevel DetectSimdLevel();
+
+// Kernels for the detected instruction set, chosen once per process.
+[[nodiscard]] const PacketKernels& GetPacketKernels();
+
+// Kernels for `level`, or the best available level below it.
+[[nodiscard]] const PacketKernels& GetPacketKernels(SimdLevel level);
+
+}  // namespace polaris::math::simd
+
+#endif
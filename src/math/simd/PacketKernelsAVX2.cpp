@@ -0,0 +1,68 @@
+// Built with AVX2 code generation enabled (see CMakeLists.txt). Nothing in
+// here may be called before GetPacketKernels() has checked the CPU.
+
+#include <math/simd/PacketKernelsImpl.hpp>
+#include <math/simd/PacketTypes.hpp>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+namespace polaris::math::simd {
+
+#ifdef __AVX2__
+namespace {
+struct Avx2Ops {
+  using Vec = __m256d;
+
+  static Vec Load(const double* p) { return _mm256_loadu_pd(p); }
+  static void Store(double* p, Vec v) { _mm256_storeu_pd(p, v); }
+  static Vec Set1(double x) { return _mm256_set1_pd(x); }
+
+  static Vec Add(Vec a, Vec b) { return _mm256_add_pd(a, b); }
+  static Vec Sub(Vec a, Vec b) { return _mm256_sub_pd(a, b); }
+  static Vec Mul(Vec a, Vec b) { return _mm256_mul_pd(a, b); }
+  static Vec Div(Vec a, Vec b) { return _mm256_div_pd(a, b); }
+  static Vec Min(Vec a, Vec b) { return _mm256_min_pd(a, b); }
+  static Vec Max(Vec a, Vec b) { return _mm256_max_pd(a, b); }
+  static Vec Sqrt(Vec a) { return _mm256_sqrt_pd(a); }
+  static Vec Abs(Vec a) { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a); }
+
+  static Vec Lt(Vec a, Vec b) { return _mm256_cmp_pd(a, b, _CMP_LT_OQ); }
+  static Vec Le(Vec a, Vec b) { return _mm256_cmp_pd(a, b, _CMP_LE_OQ); }
+  static Vec Ge(Vec a, Vec b) { return _mm256_cmp_pd(a, b, _CMP_GE_OQ); }
+  static Vec And(Vec a, Vec b) { return _mm256_and_pd(a, b); }
+  static Vec Or(Vec a, Vec b) { return _mm256_or_pd(a, b); }
+
+  static Vec Select(Vec mask, Vec a, Vec b) {
+    return _mm256_blendv_pd(b, a, mask);
+  }
+  static int MoveMask(Vec mask) { return _mm256_movemask_pd(mask); }
+};
+
+// Wide BVH nodes have four children, which fit a 128-bit register.
+struct Avx2WideOps {
+  using Vec = __m128;
+
+  static Vec Load(const float* p) { return _mm_load_ps(p); }
+  static void Store(float* p, Vec v) { _mm_storeu_ps(p, v); }
+  static Vec Set1(float x) { return _mm_set1_ps(x); }
+  static Vec Add(Vec a, Vec b) { return _mm_add_ps(a, b); }
+  static Vec Sub(Vec a, Vec b) { return _mm_sub_ps(a, b); }
+  static Vec Mul(Vec a, Vec b) { return _mm_mul_ps(a, b); }
+  static Vec Min(Vec a, Vec b) { return _mm_min_ps(a, b); }
+  static Vec Max(Vec a, Vec b) { return _mm_max_ps(a, b); }
+  static Vec Le(Vec a, Vec b) { return _mm_cmp_ps(a, b, _CMP_LE_OQ); }
+  static int MoveMask(Vec mask) { return _mm_movemask_ps(mask); }
+};
+}  // namespace
+
+const PacketKernels* Avx2PacketKernels() {
+  static const PacketKernels kernels = MakePacketKernels<Avx2Ops, Avx2WideOps>();
+  return &kernels;
+}
+#else
+const PacketKernels* Avx2PacketKernels() { return nullptr; }
+#endif
+
+}  // namespace polaris::math::simd
@@ -0,0 +1,177 @@
+#ifndef POLARIS_MATH_SIMD_PACKET_KERNELS_IMPL_HPP
+#define POLARIS_MATH_SIMD_PACKET_KERNELS_IMPL_HPP
+
+// Packet intersection kernels written once against an `Ops` wrapper around a
+// 4-wide double vector (and a `WideOps` wrapper around 4 floats for the wide
+// BVH). Every kernel TU instantiates them with its own Ops
+// type from an anonymous namespace, so each instantiation stays local to the
+// instruction set it was compiled for.
+//
+// The arithmetic mirrors the scalar Hit() implementations operation for
+// operation so every instruction set produces the same hits.
+
+#include <math/simd/PacketTypes.hpp>
+
+namespace polaris::math::simd {
+
+template <typename Ops>
+int BoxKernel(const PacketRays& rays, const double* bounds, double t_min,
+              const double* t_max, int mask) {
+  using V = typename Ops::Vec;
+
+  V tmin = Ops::Set1(t_min);
+  V tmax = Ops::Load(t_max);
+  for (int a = 0; a < 3; ++a) {
+    const V origin = Ops::Load(rays.origin[a]);
+    const V inv_direction = Ops::Load(rays.inv_direction[a]);
+    const V t0 =
+        Ops::Mul(Ops::Sub(Ops::Set1(bounds[2 * a]), origin), inv_direction);
+    const V t1 = Ops::Mul(Ops::Sub(Ops::Set1(bounds[(2 * a) + 1]), origin),
+                          inv_direction);
+    tmin = Ops::Max(Ops::Min(t0, t1), tmin);
+    tmax = Ops::Min(Ops::Max(t0, t1), tmax);
+  }
+
+  return Ops::MoveMask(Ops::Lt(tmin, tmax)) & mask;
+}
+
+template <typename Ops>
+int SphereKernel(const PacketRays& rays, const SphereParams& sphere,
+                 double t_min, const double* t_max, int mask, double* t_out) {
+  using V = typename Ops::Vec;
+
+  const V time = Ops::Load(rays.time);
+  V oc[3];
+  for (int a = 0; a < 3; ++a) {
+    const V center = Ops::Add(
+        Ops::Set1(sphere.center[a]),
+        Ops::Mul(Ops::Set1(sphere.velocity[a]), time));
+    oc[a] = Ops::Sub(center, Ops::Load(rays.origin[a]));
+  }
+
+  const V dx = Ops::Load(rays.direction[0]);
+  const V dy = Ops::Load(rays.direction[1]);
+  const V dz = Ops::Load(rays.direction[2]);
+
+  const V a = Ops::Add(Ops::Add(Ops::Mul(dx, dx), Ops::Mul(dy, dy)),
+                       Ops::Mul(dz, dz));
+  const V h = Ops::Add(Ops::Add(Ops::Mul(dx, oc[0]), Ops::Mul(dy, oc[1])),
+                       Ops::Mul(dz, oc[2]));
+  const V oc_length_squared =
+      Ops::Add(Ops::Add(Ops::Mul(oc[0], oc[0]), Ops::Mul(oc[1], oc[1])),
+               Ops::Mul(oc[2], oc[2]));
+  const V c = Ops::Sub(oc_length_squared,
+                       Ops::Set1(sphere.radius * sphere.radius));
+
+  const V discriminant = Ops::Sub(Ops::Mul(h, h), Ops::Mul(a, c));
+  const auto valid = Ops::Ge(discriminant, Ops::Set1(0.0));
+  const V sqrtd = Ops::Sqrt(Ops::Max(discriminant, Ops::Set1(0.0)));
+
+  const V tmin = Ops::Set1(t_min);
+  const V tmax = Ops::Load(t_max);
+
+  // Near root must lie strictly inside the interval, the far one may touch it
+  const V t_near = Ops::Div(Ops::Sub(h, sqrtd), a);
+  const auto near_ok = Ops::And(Ops::Lt(tmin, t_near), Ops::Lt(t_near, tmax));
+  const V t_far = Ops::Div(Ops::Add(h, sqrtd), a);
+  const auto far_ok = Ops::And(Ops::Le(tmin, t_far), Ops::Le(t_far, tmax));
+
+  Ops::Store(t_out, Ops::Select(near_ok, t_near, t_far));
+  return Ops::MoveMask(Ops::And(valid, Ops::Or(near_ok, far_ok))) & mask;
+}
+
+template <typename Ops>
+int QuadKernel(const PacketRays& rays, const QuadParams& quad, double t_min,
+               const double* t_max, int mask, double* t_out, double* alpha,
+               double* beta) {
+  using V = typename Ops::Vec;
+
+  V origin[3];
+  V direction[3];
+  for (int a = 0; a < 3; ++a) {
+    origin[a] = Ops::Load(rays.origin[a]);
+    direction[a] = Ops::Load(rays.direction[a]);
+  }
+
+  const auto dot = [](const V* v, const double* s) {
+    return Ops::Add(
+        Ops::Add(Ops::Mul(Ops::Set1(s[0]), v[0]), Ops::Mul(Ops::Set1(s[1]), v[1])),
+        Ops::Mul(Ops::Set1(s[2]), v[2]));
+  };
+
+  const V denom = dot(direction, quad.normal);
+  const auto facing = Ops::Ge(Ops::Abs(denom), Ops::Set1(1e-8));
+
+  const V t = Ops::Div(Ops::Sub(Ops::Set1(quad.d), dot(origin, quad.normal)),
+                       denom);
+  const auto in_range = Ops::And(Ops::Le(Ops::Set1(t_min), t),
+                                 Ops::Le(t, Ops::Load(t_max)));
+
+  V p[3];
+  for (int a = 0; a < 3; ++a) {
+    p[a] = Ops::Sub(Ops::Add(origin[a], Ops::Mul(t, direction[a])),
+                    Ops::Set1(quad.q[a]));
+  }
+
+  // alpha = w . (p x v), beta = w . (u x p)
+  const V v[3] = {Ops::Set1(quad.v[0]), Ops::Set1(quad.v[1]),
+                  Ops::Set1(quad.v[2])};
+  const V u[3] = {Ops::Set1(quad.u[0]), Ops::Set1(quad.u[1]),
+                  Ops::Set1(quad.u[2])};
+  const V p_cross_v[3] = {
+      Ops::Sub(Ops::Mul(p[1], v[2]), Ops::Mul(p[2], v[1])),
+      Ops::Sub(Ops::Mul(p[2], v[0]), Ops::Mul(p[0], v[2])),
+      Ops::Sub(Ops::Mul(p[0], v[1]), Ops::Mul(p[1], v[0])),
+  };
+  const V u_cross_p[3] = {
+      Ops::Sub(Ops::Mul(u[1], p[2]), Ops::Mul(u[2], p[1])),
+      Ops::Sub(Ops::Mul(u[2], p[0]), Ops::Mul(u[0], p[2])),
+      Ops::Sub(Ops::Mul(u[0], p[1]), Ops::Mul(u[1], p[0])),
+  };
+  const V a = dot(p_cross_v, quad.w);
+  const V b = dot(u_cross_p, quad.w);
+
+  const V zero = Ops::Set1(0.0);
+  const V one = Ops::Set1(1.0);
+  const auto interior =
+      Ops::And(Ops::And(Ops::Le(zero, a), Ops::Le(a, one)),
+               Ops::And(Ops::Le(zero, b), Ops::Le(b, one)));
+
+  Ops::Store(t_out, t);
+  Ops::Store(alpha, a);
+  Ops::Store(beta, b);
+  return Ops::MoveMask(Ops::And(Ops::And(facing, in_range), interior)) & mask;
+}
+
+template <typename WideOps>
+int WideBoxKernel(const WideBounds& bounds, const WideRay& ray, float t_min,
+                  float t_max, float* t_entry) {
+  using V = typename WideOps::Vec;
+
+  V tmin = WideOps::Set1(t_min);
+  V tmax = WideOps::Set1(t_max);
+  const V slack = WideOps::Set1(ray.slack);
+  for (int a = 0; a < 3; ++a) {
+    const V origin = WideOps::Set1(ray.origin[a]);
+    const V inv_direction = WideOps::Set1(ray.inv_direction[a]);
+    const V lo = WideOps::Sub(WideOps::Load(bounds.min[a]), slack);
+    const V hi = WideOps::Add(WideOps::Load(bounds.max[a]), slack);
+    const V t0 = WideOps::Mul(WideOps::Sub(lo, origin), inv_direction);
+    const V t1 = WideOps::Mul(WideOps::Sub(hi, origin), inv_direction);
+    tmin = WideOps::Max(WideOps::Min(t0, t1), tmin);
+    tmax = WideOps::Min(WideOps::Max(t0, t1), tmax);
+  }
+
+  WideOps::Store(t_entry, tmin);
+  return WideOps::MoveMask(WideOps::Le(tmin, tmax));
+}
+
+template <typename Ops, typename WideOps>
+PacketKernels MakePacketKernels() {
+  return {&BoxKernel<Ops>, &SphereKernel<Ops>, &QuadKernel<Ops>,
+          &WideBoxKernel<WideOps>};
+}
+
+}  // namespace polaris::math::simd
+
+#endif
@@ -0,0 +1,86 @@
+#include <math/simd/PacketKernelsImpl.hpp>
+#include <math/simd/PacketTypes.hpp>
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define POLARIS_HAS_SSE2_KERNELS 1
+#include <emmintrin.h>
+#include <xmmintrin.h>
+#endif
+
+namespace polaris::math::simd {
+
+#ifdef POLARIS_HAS_SSE2_KERNELS
+namespace {
+// Four doubles held in two SSE2 registers.
+struct Sse2Ops {
+  struct Vec {
+    __m128d lo, hi;
+  };
+
+  template <typename Fn>
+  static Vec Apply(Vec a, Vec b, Fn fn) {
+    return {fn(a.lo, b.lo), fn(a.hi, b.hi)};
+  }
+
+  static Vec Load(const double* p) {
+    return {_mm_loadu_pd(p), _mm_loadu_pd(p + 2)};
+  }
+  static void Store(double* p, Vec v) {
+    _mm_storeu_pd(p, v.lo);
+    _mm_storeu_pd(p + 2, v.hi);
+  }
+  static Vec Set1(double x) { return {_mm_set1_pd(x), _mm_set1_pd(x)}; }
+
+  static Vec Add(Vec a, Vec b) { return Apply(a, b, _mm_add_pd); }
+  static Vec Sub(Vec a, Vec b) { return Apply(a, b, _mm_sub_pd); }
+  static Vec Mul(Vec a, Vec b) { return Apply(a, b, _mm_mul_pd); }
+  static Vec Div(Vec a, Vec b) { return Apply(a, b, _mm_div_pd); }
+  static Vec Min(Vec a, Vec b) { return Apply(a, b, _mm_min_pd); }
+  static Vec Max(Vec a, Vec b) { return Apply(a, b, _mm_max_pd); }
+  static Vec Sqrt(Vec a) { return {_mm_sqrt_pd(a.lo), _mm_sqrt_pd(a.hi)}; }
+  static Vec Abs(Vec a) {
+    const __m128d sign = _mm_set1_pd(-0.0);
+    return {_mm_andnot_pd(sign, a.lo), _mm_andnot_pd(sign, a.hi)};
+  }
+
+  static Vec Lt(Vec a, Vec b) { return Apply(a, b, _mm_cmplt_pd); }
+  static Vec Le(Vec a, Vec b) { return Apply(a, b, _mm_cmple_pd); }
+  static Vec Ge(Vec a, Vec b) { return Apply(a, b, _mm_cmpge_pd); }
+  static Vec And(Vec a, Vec b) { return Apply(a, b, _mm_and_pd); }
+  static Vec Or(Vec a, Vec b) { return Apply(a, b, _mm_or_pd); }
+
+  static Vec Select(Vec mask, Vec a, Vec b) {
+    return {_mm_or_pd(_mm_and_pd(mask.lo, a.lo), _mm_andnot_pd(mask.lo, b.lo)),
+            _mm_or_pd(_mm_and_pd(mask.hi, a.hi), _mm_andnot_pd(mask.hi, b.hi))};
+  }
+  static int MoveMask(Vec mask) {
+    return _mm_movemask_pd(mask.lo) | (_mm_movemask_pd(mask.hi) << 2);
+  }
+};
+
+struct Sse2WideOps {
+  using Vec = __m128;
+
+  static Vec Load(const float* p) { return _mm_load_ps(p); }
+  static void Store(float* p, Vec v) { _mm_storeu_ps(p, v); }
+  static Vec Set1(float x) { return _mm_set1_ps(x); }
+  static Vec Add(Vec a, Vec b) { return _mm_add_ps(a, b); }
+  static Vec Sub(Vec a, Vec b) { return _mm_sub_ps(a, b); }
+  static Vec Mul(Vec a, Vec b) { return _mm_mul_ps(a, b); }
+  static Vec Min(Vec a, Vec b) { return _mm_min_ps(a, b); }
+  static Vec Max(Vec a, Vec b) { return _mm_max_ps(a, b); }
+  static Vec Le(Vec a, Vec b) { return _mm_cmple_ps(a, b); }
+  static int MoveMask(Vec mask) { return _mm_movemask_ps(mask); }
+};
+}  // namespace
+
+const PacketKernels* Sse2PacketKernels() {
+  static const PacketKernels kernels = MakePacketKernels<Sse2Ops, Sse2WideOps>();
+  return &kernels;
+}
+#else
+const PacketKernels* Sse2PacketKernels() { return nullptr; }
+#endif
+
+}  // namespace polaris::math::simd
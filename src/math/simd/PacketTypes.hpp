@@ -0,0 +1,86 @@
+#ifndef POLARIS_MATH_SIMD_PACKET_TYPES_HPP
+#define POLARIS_MATH_SIMD_PACKET_TYPES_HPP
+
+// Plain data shared with the packet kernels. This header must stay free of
+// inline functions: it is included by translation units built for wider
+// instruction sets, and any inline definition emitted there could be picked
+// by the linker for callers running on CPUs without those instructions.
+
+#include <cstdint>
+
+namespace polaris::math::simd {
+
+inline constexpr int kPacketWidth = 4;
+
+// Structure-of-arrays view of a ray packet, laid out for vector loads.
+struct alignas(32) PacketRays {
+  double origin[3][kPacketWidth];
+  double direction[3][kPacketWidth];
+  double inv_direction[3][kPacketWidth];
+  double time[kPacketWidth];
+};
+
+struct SphereParams {
+  double center[3];    // Center at time 0
+  double velocity[3];  // Movement of the center per unit of time
+  double radius;
+};
+
+struct QuadParams {
+  double q[3];  // Corner
+  double u[3];  // First edge
+  double v[3];  // Second edge
+  double w[3];  // n / (n . n), used to find planar coordinates
+  double normal[3];
+  double d;     // Plane offset along the normal
+};
+
+inline constexpr int kWideWidth = 4;
+
+// Child bounds of a wide BVH node in structure-of-arrays form, one lane per
+// child.
+struct alignas(16) WideBounds {
+  float min[3][kWideWidth];
+  float max[3][kWideWidth];
+};
+
+struct WideRay {
+  float origin[3];
+  float inv_direction[3];
+  float slack;  // Added around every child box before the slab test
+};
+
+// Intersection kernels for one packet. Each returns the mask of lanes in
+// `mask` that hit within [t_min, t_max[lane]], writing per-lane results only
+// for those lanes.
+struct PacketKernels {
+  // `bounds` is {x_min, x_max, y_min, y_max, z_min, z_max}
+  int (*box)(const PacketRays& rays, const double* bounds, double t_min,
+             const double* t_max, int mask);
+  int (*sphere)(const PacketRays& rays, const SphereParams& sphere,
+                double t_min, const double* t_max, int mask, double* t_out);
+  int (*quad)(const PacketRays& rays, const QuadParams& quad, double t_min,
+              const double* t_max, int mask, double* t_out, double* alpha,
+              double* beta);
+
+  // One ray against the children of a wide BVH node. Returns the mask of
+  // children hit within [t_min, t_max] and writes their entry distances.
+  int (*wide_box)(const WideBounds& bounds, const WideRay& ray, float t_min,
+                  float t_max, float* t_entry);
+};
+
+enum class SimdLevel : std::uint8_t {
+  Scalar = 0,
+  SSE2,
+  AVX2,
+};
+
+// Kernel tables per instruction set. The SSE2 and AVX2 tables are null when
+// the target cannot provide them.
+const PacketKernels& ScalarPacketKernels();
+const PacketKernels* Sse2PacketKernels();
+const PacketKernels* Avx2PacketKernels();
+
+}  // namespace polaris::math::simd
+
+#endif
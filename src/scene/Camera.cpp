@@ -1,19 +1,63 @@
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
 #include <execution>
 #include <filesystem>
+#include <fstream>
 #include <math/Common.hpp>
 #include <scene/Camera.hpp>
-#include <scene/material/Material.hpp>
 #include <thread>
+#include <util/Arena.hpp>
+#include <utility>
 #include <vector>
 
 namespace polaris::scene {
+namespace {
+// Rays traced by the current render thread, summed into the stats at the end
+thread_local std::uint64_t tls_ray_count = 0;
+
+// Distance of cell (x, y) along the Hilbert curve filling an n x n grid,
+// where n is a power of two
+std::uint64_t HilbertIndex(std::uint32_t n, std::uint32_t x, std::uint32_t y) {
+  std::uint64_t d = 0;
+  for (std::uint32_t s = n / 2; s > 0; s /= 2) {
+    const std::uint32_t rx = (x & s) != 0 ? 1 : 0;
+    const std::uint32_t ry = (y & s) != 0 ? 1 : 0;
+    d += static_cast<std::uint64_t>(s) * s * ((3 * rx) ^ ry);
+
+    // Rotate the quadrant so the curve continues where the last one ended
+    if (ry == 0) {
+      if (rx == 1) {
+        x = s - 1 - x;
+        y = s - 1 - y;
+      }
+      std::swap(x, y);
+    }
+  }
+  return d;
+}
+}  // namespace
 
-Camera::Camera(const CameraSettings& settings) : settings_(settings), pixel_samples_scale_(1.0 / settings_.samples_per_pixel) {
+Camera::Camera(const CameraSettings& settings)
+    : settings_(settings),
+      sampler_(sampler::MakeSampler(settings.sampler, settings.seed)) {
   const auto image_width = settings_.image_width;
   image_height_ = static_cast<int>(image_width / settings_.aspect_ratio);
   image_height_ = std::max(image_height_, 1);
   frame_buffer_.Assign(settings_.output_format_, image_width, image_height_);
+  if (settings_.thread_count != 0 || settings_.pin_threads) {
+    const std::uint32_t threads = settings_.thread_count != 0
+                                      ? settings_.thread_count
+                                      : std::thread::hardware_concurrency();
+    // The thread calling Render() works through tiles too
+    pool_ = std::make_unique<util::ThreadPool>(std::max(threads, 1U) - 1,
+                                               settings_.pin_threads);
+  }
+  accumulation_.resize(static_cast<std::size_t>(image_width) * image_height_);
 
   SetTarget(polaris::math::Vec3(0, 0, 0), math::Vec3{0, 0, -1});
 }
@@ -47,78 +91,527 @@ void Camera::SetTarget(const math::Vec3& pos,
       center_ - (settings_.focus_dist * w) - viewport_u / 2 - viewport_v / 2;
 
   pixel00_loc_ = viewport_upper_left + 0.5 * (pixel_delta_u_ + pixel_delta_v_);
+  pixel_spread_ = pixel_delta_u_.Length() / settings_.focus_dist;
 
   auto defocus_radius = settings_.focus_dist * std::tan(math::DegreesToRadians(settings_.defocus_angle / 2));
   defocus_disk_u_ = u * defocus_radius;
   defocus_disk_v_ = v * defocus_radius;
 }
 
-void Camera::Render(const Hittable& world) {
+void Camera::Render(const Hittable& world,
+                    const material::MaterialTable& materials,
+                    const PassCallback& on_pass) {
+  std::ranges::fill(accumulation_, PixelEstimate{});
+  accumulated_samples_ = 0;
+  Refine(world, materials, settings_.samples_per_pixel, on_pass);
+}
+
+void Camera::Refine(const Hittable& world,
+                    const material::MaterialTable& materials,
+                    std::uint32_t samples, const PassCallback& on_pass) {
+  const auto start_time = std::chrono::steady_clock::now();
+  stats_.ray_count = 0;
+
+  const auto pass_samples =
+      settings_.pass_samples != 0 ? settings_.pass_samples : samples;
+  for (std::uint32_t done = 0; done < samples;) {
+    const auto count = std::min(pass_samples, samples - done);
+    RenderPass(world, materials, count);
+    done += count;
+    accumulated_samples_ += count;
+    if (on_pass) {
+      on_pass(accumulated_samples_);
+    }
+  }
+
+  stats_.render_ms = std::chrono::duration<double, std::milli>(
+                         std::chrono::steady_clock::now() - start_time)
+                         .count();
+}
+
+void Camera::RenderPass(const Hittable& world,
+                        const material::MaterialTable& materials,
+                        std::uint32_t samples) {
   const int tile = std::max(1, settings_.tile_size);
   const int width = settings_.image_width;
   const int height = image_height_;
 
   struct Tile {
     int x0, y0, x1, y1;
+    std::uint64_t key;  // Position in the render order
   };
 
+  const int tiles_x = (width + tile - 1) / tile;
+  const int tiles_y = (height + tile - 1) / tile;
+  const auto grid = std::bit_ceil(
+      static_cast<std::uint32_t>(std::max(tiles_x, tiles_y)));
+
   std::vector<Tile> tiles;
-  for (int y = 0; y < height; y += tile) {
-    for (int x = 0; x < width; x += tile) {
-      tiles.push_back(
-          {x, y, std::min(x + tile, width), std::min(y + tile, height)});
+  tiles.reserve(static_cast<std::size_t>(tiles_x) * tiles_y);
+  for (int ty = 0; ty < tiles_y; ++ty) {
+    for (int tx = 0; tx < tiles_x; ++tx) {
+      const int x = tx * tile;
+      const int y = ty * tile;
+      Tile t{x, y, std::min(x + tile, width), std::min(y + tile, height), 0};
+
+      switch (settings_.tile_order) {
+        case TileOrder::RowMajor:
+          t.key = tiles.size();
+          break;
+        case TileOrder::Hilbert:
+          t.key = HilbertIndex(grid, tx, ty);
+          break;
+        case TileOrder::CenterOut: {
+          // Twice the distance of the tile centre from the image centre
+          const std::int64_t dx = t.x0 + t.x1 - width;
+          const std::int64_t dy = t.y0 + t.y1 - height;
+          t.key = static_cast<std::uint64_t>((dx * dx) + (dy * dy));
+          break;
+        }
+      }
+      tiles.push_back(t);
     }
   }
+  std::ranges::stable_sort(tiles, {}, &Tile::key);
+
+  // Tiles are dealt round robin to the workers in the render order, so early
+  // tiles tend to start first and the tiles in flight at any time lie close
+  // together. Stealing may still start a later tile ahead of its turn.
+  auto& pool = pool_ ? *pool_ : util::ThreadPool::Default();
+  std::atomic<std::uint64_t> ray_count{0};
+  util::TaskGroup group(pool);
+  for (const auto& t : tiles) {
+    group.Run([&, t] {
+      const auto sampler = sampler_->Clone();
+      tls_ray_count = 0;
+      RenderTile(t.x0, t.y0, t.x1, t.y1, world, materials, *sampler, samples);
+      ray_count.fetch_add(tls_ray_count, std::memory_order_relaxed);
+    });
+  }
+  group.Wait();
+
+  stats_.ray_count += ray_count.load();
+}
 
-  std::atomic<size_t> next_tile{0};
+void Camera::RenderTile(int x0, int y0, int x1, int y1, const Hittable& world,
+                        const material::MaterialTable& materials,
+                        sampler::Sampler& sampler, std::uint32_t samples) {
+  const bool packets = settings_.trace_mode == TraceMode::Packet;
+  const int step = packets ? 2 : 1;
+  const auto pixel_count = static_cast<std::size_t>(x1 - x0) *
+                           static_cast<std::size_t>(y1 - y0);
+
+  const auto estimate_at = [&](int x, int y) -> PixelEstimate& {
+    return accumulation_[(static_cast<std::size_t>(y) * settings_.image_width) +
+                         x];
+  };
 
-  std::vector<std::jthread> threads;
-  threads.reserve(std::jthread::hardware_concurrency());
-  for (size_t t = 0; t < std::jthread::hardware_concurrency(); ++t) {
-    threads.emplace_back([&, seed = std::random_device{}() + t] {
-      static thread_local std::mt19937 rng(seed);
+  // A unit is a pixel, or a 2x2 block in packet mode. Lanes of a block only
+  // ever drop out within a pass.
+  struct Unit {
+    int x, y;
+    int lanes;
+    std::uint32_t samples;  // Most samples any of the lanes has
+    double error;           // Largest error of the lanes
+  };
 
-      size_t idx;
-      while ((idx = next_tile.fetch_add(1)) < tiles.size()) {
-        const auto& [x0, y0, x1, y1] = tiles[idx];
-        RenderTile(x0, y0, x1, y1, world, rng);
+  const auto lane_estimate = [&](const Unit& unit, int lane) -> PixelEstimate& {
+    return estimate_at(unit.x + (lane & 1), unit.y + (lane >> 1));
+  };
+
+  // Work lists are taken from the thread's scratch arena, which every tile
+  // the thread renders reuses
+  auto& scratch = util::ThreadScratch();
+  const util::ArenaScope scratch_scope(scratch);
+  const auto units = scratch.CreateArray<Unit>(
+      static_cast<std::size_t>((x1 - x0 + step - 1) / step) *
+      static_cast<std::size_t>((y1 - y0 + step - 1) / step));
+  std::size_t unit_count = 0;
+  for (int y = y0; y < y1; y += step) {
+    for (int x = x0; x < x1; x += step) {
+      Unit unit{x, y, 1, 0, 0.0};
+      if (packets) {
+        unit.lanes = 0;
+        for (int lane = 0; lane < math::RayPacket::kWidth; ++lane) {
+          if (x + (lane & 1) < x1 && y + (lane >> 1) < y1) {
+            unit.lanes |= 1 << lane;
+          }
+        }
       }
-    });
+      units[unit_count++] = unit;
+    }
   }
+
+  // Adds `count` samples to each of the `lanes`, as one packet per sample in
+  // packet mode
+  const auto trace = [&](Unit& unit, int lanes, std::uint32_t count) {
+    std::array<PixelEstimate*, math::RayPacket::kWidth> estimates{};
+    for (int lane = 0; lane < math::RayPacket::kWidth; ++lane) {
+      if ((lanes & (1 << lane)) != 0) {
+        estimates[lane] = &lane_estimate(unit, lane);
+      }
+    }
+
+    if (packets) {
+      SampleBlock(unit.x, unit.y, lanes, count, world, materials, sampler,
+                  estimates);
+      return;
+    }
+    for (int lane = 0; lane < math::RayPacket::kWidth; ++lane) {
+      if (auto* estimate = estimates[lane]; estimate != nullptr) {
+        SamplePixel(unit.x + (lane & 1), unit.y + (lane >> 1),
+                    estimate->samples, estimate->samples + count, world,
+                    materials, sampler, *estimate);
+      }
+    }
+  };
+
+  const double threshold = settings_.adaptive_threshold;
+  if (threshold <= 0) {
+    for (auto& unit : units) {
+      trace(unit, unit.lanes, samples);
+    }
+  } else {
+    const auto max_samples = std::max(settings_.adaptive_max_samples, 1U);
+    const auto initial_samples =
+        std::clamp(settings_.adaptive_min_samples, 2U, max_samples);
+
+    // After the pass the tile may have taken accumulated_samples_ + samples
+    // samples per pixel on average, so a pass that overspends leaves less to
+    // the next. Pixels that converge early leave their share to noisy ones.
+    auto budget = static_cast<std::int64_t>(accumulated_samples_ + samples) *
+                  static_cast<std::int64_t>(pixel_count);
+    for (int y = y0; y < y1; ++y) {
+      for (int x = x0; x < x1; ++x) {
+        budget -= estimate_at(x, y).samples;
+      }
+    }
+
+    // Every pixel first takes enough samples for a usable error estimate.
+    // Lanes are grouped by their count, which sets how many they still need.
+    for (auto& unit : units) {
+      int remaining = unit.lanes;
+      while (remaining != 0) {
+        const auto samples_of = [&](int lane) {
+          return lane_estimate(unit, lane).samples;
+        };
+        const auto first = samples_of(std::countr_zero(
+            static_cast<unsigned>(remaining)));
+        int lanes = 0;
+        for (int lane = 0; lane < math::RayPacket::kWidth; ++lane) {
+          if ((remaining & (1 << lane)) != 0 && samples_of(lane) == first) {
+            lanes |= 1 << lane;
+          }
+        }
+        remaining &= ~lanes;
+        if (first < initial_samples) {
+          const auto count = initial_samples - first;
+          trace(unit, lanes, count);
+          budget -= static_cast<std::int64_t>(count) *
+                    std::popcount(static_cast<unsigned>(lanes));
+        }
+      }
+    }
+
+    const auto active_slots = scratch.CreateArray<Unit*>(units.size());
+    while (budget > 0) {
+      std::size_t active_count = 0;
+      for (auto& unit : units) {
+        unit.samples = 0;
+        unit.error = 0.0;
+        for (int lane = 0; lane < math::RayPacket::kWidth; ++lane) {
+          if ((unit.lanes & (1 << lane)) == 0) {
+            continue;
+          }
+          const auto& estimate = lane_estimate(unit, lane);
+          const auto error = estimate.Error();
+          if (error <= threshold || estimate.samples >= max_samples) {
+            unit.lanes &= ~(1 << lane);
+            continue;
+          }
+          unit.samples = std::max(unit.samples, estimate.samples);
+          unit.error = std::max(unit.error, error);
+        }
+        if (unit.lanes != 0) {
+          active_slots[active_count++] = &unit;
+        }
+      }
+      if (active_count == 0) {
+        break;
+      }
+      const auto active = active_slots.first(active_count);
+
+      // Noisiest first, so they get the budget if it runs out this round
+      std::ranges::sort(active, std::ranges::greater{}, &Unit::error);
+
+      for (auto* unit : active) {
+        const std::int64_t lane_count =
+            std::popcount(static_cast<unsigned>(unit->lanes));
+        // Doubling keeps Sobol sample counts at powers of two
+        auto count = std::min(unit->samples, max_samples - unit->samples);
+        count = static_cast<std::uint32_t>(std::min<std::int64_t>(
+            count, (budget + lane_count - 1) / lane_count));
+        trace(*unit, unit->lanes, count);
+        budget -= count * lane_count;
+        if (budget <= 0) {
+          break;
+        }
+      }
+    }
+  }
+
+  Resolve(x0, y0, x1, y1);
 }
 
-void Camera::RenderTile(int x0, int y0, int x1, int y1, const Hittable& world,
-                        std::mt19937& rng) {
-  std::uniform_real_distribution<> dist(0.0, 1.0);
-  const int sqrt_spp = static_cast<int>(std::sqrt(settings_.samples_per_pixel));
-  const double inv_sqrt_spp = 1.0 / sqrt_spp;
+void Camera::Resolve(int x0, int y0, int x1, int y1) {
+  const bool hdr = frame_buffer_.IsHighDynamicRange();
+  for (int y = y0; y < y1; ++y) {
+    for (int x = x0; x < x1; ++x) {
+      const auto& estimate =
+          accumulation_[(static_cast<std::size_t>(y) * settings_.image_width) +
+                        x];
+      if (estimate.samples == 0) {
+        continue;
+      }
+      const auto mean = estimate.sum * (1.0 / estimate.samples);
+      if (hdr) {
+        frame_buffer_.Set(x, y, image::PixelF32(mean));
+      } else {
+        frame_buffer_.Set(x, y, image::ToneMap(mean, settings_.tone_map));
+      }
+    }
+  }
+}
+
+void Camera::SamplePixel(int x, int y, std::uint32_t first, std::uint32_t last,
+                         const Hittable& world,
+                         const material::MaterialTable& materials,
+                         sampler::Sampler& sampler, PixelEstimate& estimate) {
   const double inv_width = 1.0 / (settings_.image_width - 1);
   const double inv_height = 1.0 / (image_height_ - 1);
 
-  for (int y = y0; y < y1; ++y) {
-    for (int x = x0; x < x1; ++x) {
-      image::PixelF64 color{};
-
-      // Stratified sampling
-      for (int sy = 0; sy < sqrt_spp; ++sy) {
-        for (int sx = 0; sx < sqrt_spp; ++sx) {
-          auto u_l = (x + (sx + dist(rng)) * inv_sqrt_spp) * inv_width;
-          auto v_l = (y + (sy + dist(rng)) * inv_sqrt_spp) * inv_height;
-          color += RayColour(GetRayFor(u_l, v_l), settings_.max_depth_, world);
+  // The sampler stratifies the jitter across the pixel's samples
+  for (auto s = first; s < last; ++s) {
+    sampler.StartPixelSample(x, y, s);
+    const auto jitter = sampler.Get2D();
+    auto u_l = (x + jitter[0]) * inv_width;
+    auto v_l = (y + jitter[1]) * inv_height;
+    estimate.Add(RayColour(GetRayFor(u_l, v_l, sampler), nullptr, world,
+                           materials, sampler));
+  }
+}
+
+void Camera::SampleBlock(
+    int x, int y, int lanes, std::uint32_t count, const Hittable& world,
+    const material::MaterialTable& materials, sampler::Sampler& sampler,
+    const std::array<PixelEstimate*, math::RayPacket::kWidth>& estimates) {
+  static_assert(math::RayPacket::kWidth == 4, "Packets cover 2x2 pixels");
+
+  const double inv_width = 1.0 / (settings_.image_width - 1);
+  const double inv_height = 1.0 / (image_height_ - 1);
+
+  // Lanes may have taken different counts in earlier adaptive passes, so
+  // each continues its own pixel's sample sequence
+  std::array<std::uint32_t, math::RayPacket::kWidth> first{};
+  for (int lane = 0; lane < math::RayPacket::kWidth; ++lane) {
+    if ((lanes & (1 << lane)) != 0) {
+      first[lane] = estimates[lane]->samples;
+    }
+  }
+
+  // One sample of each pixel in the block per packet
+  for (std::uint32_t i = 0; i < count; ++i) {
+    math::RayPacket packet;
+    for (int lane = 0; lane < math::RayPacket::kWidth; ++lane) {
+      if ((lanes & (1 << lane)) != 0) {
+        const int px = x + (lane & 1);
+        const int py = y + (lane >> 1);
+        sampler.StartPixelSample(px, py, first[lane] + i);
+        const auto jitter = sampler.Get2D();
+        auto u_l = (px + jitter[0]) * inv_width;
+        auto v_l = (py + jitter[1]) * inv_height;
+        packet.Set(lane, GetRayFor(u_l, v_l, sampler));
+      }
+    }
+
+    if (settings_.max_depth_ == 0) {
+      for (int lane = 0; lane < math::RayPacket::kWidth; ++lane) {
+        if ((lanes & (1 << lane)) != 0) {
+          estimates[lane]->Add({0, 0, 0});
         }
       }
+      continue;
+    }
+
+    PacketDistances t_max;
+    t_max.fill(math::kInfinity);
+    PacketHitInfo rec;
+    const int active = packet.ActiveMask();
+    tls_ray_count += std::popcount(static_cast<unsigned>(active));
+    const int hits = world.HitPacket(packet, active, 0.001, t_max, rec);
+
+    for (int lane = 0; lane < math::RayPacket::kWidth; ++lane) {
+      const int bit = 1 << lane;
+      if ((active & bit) == 0) {
+        continue;
+      }
+      if ((hits & bit) == 0) {
+        estimates[lane]->Add(Background(packet[lane]));
+        continue;
+      }
 
-      frame_buffer_.Set(
-          x, y, static_cast<image::PixelU8>(color * pixel_samples_scale_));
+      // Resume this lane's path where its camera ray left off
+      sampler.StartPixelSample(x + (lane & 1), y + (lane >> 1),
+                               first[lane] + i, kCameraDimensions);
+      estimates[lane]->Add(
+          RayColour(packet[lane], &rec[lane], world, materials, sampler));
     }
   }
 }
 
 void Camera::Write(const std::string& filename) {
+  WriteImage(frame_buffer_, settings_.output_format_, filename);
+}
+
+void Camera::WriteToneMapped(const std::string& filename,
+                             image::FileFormat format,
+                             const image::ToneMapSettings& tone_map) const {
+  auto ldr = image::ToneMap(frame_buffer_, format, tone_map);
+  WriteImage(ldr, format, filename);
+}
+
+void Camera::WriteSampleHeatmap(const std::string& filename) const {
+  const auto [min_it, max_it] =
+      std::ranges::minmax_element(accumulation_, {}, &PixelEstimate::samples);
+  if (min_it == accumulation_.end()) {
+    return;
+  }
+  const auto min_count = min_it->samples;
+  const double range =
+      std::max(1.0, static_cast<double>(max_it->samples - min_count));
+
+  // Counts are not radiance, so HDR outputs get a PNG heatmap
+  const auto format = image::IsHighDynamicRange(settings_.output_format_)
+                          ? image::FileFormat::PNG
+                          : settings_.output_format_;
+  image::FrameBuffer heatmap;
+  heatmap.Assign(format, settings_.image_width, image_height_);
+  for (int y = 0; y < image_height_; ++y) {
+    for (int x = 0; x < settings_.image_width; ++x) {
+      const auto count =
+          accumulation_[(static_cast<std::size_t>(y) * settings_.image_width) +
+                        x]
+              .samples;
+      // Black through red and yellow to white
+      const double t = (count - min_count) / range;
+      const auto channel = [t](double offset) {
+        return static_cast<int>(255.0 *
+                                std::clamp((3.0 * t) - offset, 0.0, 1.0));
+      };
+      heatmap.Set(x, y, image::PixelU8(channel(0), channel(1), channel(2)));
+    }
+  }
+
+  WriteImage(heatmap, format, filename);
+}
+
+namespace {
+// Accumulation state files start with this tag, then a format version
+constexpr std::array<char, 4> kStateMagic = {'P', 'L', 'A', 'S'};
+constexpr std::uint32_t kStateVersion = 1;
+
+// Plain values in native byte order; the state is meant to be resumed on the
+// machine that saved it
+template <typename T>
+void WriteValue(std::ofstream& out, const T& value) {
+  out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+bool ReadValue(std::ifstream& in, T& value) {
+  return static_cast<bool>(
+      in.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+}  // namespace
+
+bool Camera::SaveState(const std::string& filename) const {
+  std::ofstream f(filename, std::ios::out | std::ios::binary);
+  if (!f.is_open()) {
+    return false;
+  }
+
+  WriteValue(f, kStateMagic);
+  WriteValue(f, kStateVersion);
+  WriteValue(f, settings_.image_width);
+  WriteValue(f, image_height_);
+  WriteValue(f, settings_.sampler);
+  WriteValue(f, settings_.seed);
+  WriteValue(f, accumulated_samples_);
+
+  for (const auto& estimate : accumulation_) {
+    WriteValue(f, estimate.sum.R());
+    WriteValue(f, estimate.sum.G());
+    WriteValue(f, estimate.sum.B());
+    WriteValue(f, estimate.mean);
+    WriteValue(f, estimate.m2);
+    WriteValue(f, estimate.samples);
+  }
+
+  return static_cast<bool>(f);
+}
+
+bool Camera::LoadState(const std::string& filename) {
+  std::ifstream f(filename, std::ios::in | std::ios::binary);
+  if (!f.is_open()) {
+    return false;
+  }
+
+  std::array<char, 4> magic{};
+  std::uint32_t version = 0;
+  int width = 0;
+  int height = 0;
+  sampler::SamplerType sampler_type{};
+  std::uint64_t seed = 0;
+  std::uint32_t accumulated_samples = 0;
+  if (!ReadValue(f, magic) || !ReadValue(f, version) ||
+      !ReadValue(f, width) || !ReadValue(f, height) ||
+      !ReadValue(f, sampler_type) || !ReadValue(f, seed) ||
+      !ReadValue(f, accumulated_samples)) {
+    return false;
+  }
+
+  // Other samples would not continue the same sequences
+  if (magic != kStateMagic || version != kStateVersion ||
+      width != settings_.image_width || height != image_height_ ||
+      sampler_type != settings_.sampler || seed != settings_.seed) {
+    return false;
+  }
+
+  std::vector<PixelEstimate> accumulation(accumulation_.size());
+  for (auto& estimate : accumulation) {
+    double r = 0.0;
+    double g = 0.0;
+    double b = 0.0;
+    if (!ReadValue(f, r) || !ReadValue(f, g) || !ReadValue(f, b) ||
+        !ReadValue(f, estimate.mean) || !ReadValue(f, estimate.m2) ||
+        !ReadValue(f, estimate.samples)) {
+      return false;
+    }
+    estimate.sum = image::PixelF64(r, g, b);
+  }
+
+  accumulation_ = std::move(accumulation);
+  accumulated_samples_ = accumulated_samples;
+  Resolve(0, 0, settings_.image_width, image_height_);
+  return true;
+}
+
+void Camera::WriteImage(image::FrameBuffer& buffer, image::FileFormat format,
+                        const std::string& filename) {
   std::filesystem::path file_path(filename);
   std::ios_base::openmode file_mode = std::ios::out;
 
-  switch (settings_.output_format_) {
+  switch (format) {
     case image::FileFormat::BMP:
       file_path.replace_extension(".bmp");
       file_mode |= std::ios::binary;
@@ -131,19 +624,62 @@ void Camera::Write(const std::string& filename) {
       file_path.replace_extension(".jpg");
       file_mode |= std::ios::binary;
       break;
+    case image::FileFormat::HDR:
+      file_path.replace_extension(".hdr");
+      file_mode |= std::ios::binary;
+      break;
+    case image::FileFormat::PFM:
+      file_path.replace_extension(".pfm");
+      file_mode |= std::ios::binary;
+      break;
+    case image::FileFormat::EXR:
+      file_path.replace_extension(".exr");
+      file_mode |= std::ios::binary;
+      break;
     default:
       return;  // Unsupported format
   }
 
-  std::ofstream f(file_path, file_mode);
+  // Encoders emit many small pieces, which a large stream buffer turns into
+  // a few big writes
+  constexpr std::size_t kStreamBufferSize = std::size_t{1} << 20;
+  std::vector<char> stream_buffer(kStreamBufferSize);
+  std::ofstream f;
+  f.rdbuf()->pubsetbuf(stream_buffer.data(),
+                       static_cast<std::streamsize>(stream_buffer.size()));
+  f.open(file_path, file_mode);
   if (!f.is_open()) {
     return;
   }
 
-  frame_buffer_.Write(f);
+  buffer.Write(f);
 }
 
-math::Ray Camera::GetRayFor(double u_norm, double v_norm) const {
+void Camera::PixelEstimate::Add(const image::PixelF64& colour) {
+  sum += colour;
+
+  const double luminance =
+      (0.2126 * colour.R()) + (0.7152 * colour.G()) + (0.0722 * colour.B());
+  ++samples;
+  const double delta = luminance - mean;
+  mean += delta / samples;
+  m2 += delta * (luminance - mean);
+}
+
+double Camera::PixelEstimate::Error() const {
+  if (samples < 2) {
+    return math::kInfinity;
+  }
+
+  // The display value is roughly sqrt(mean), whose error is the error of the
+  // mean scaled by the derivative 1 / (2 sqrt(mean)).
+  constexpr double kMinLuminance = 1e-4;
+  const double standard_error = std::sqrt(m2 / ((samples - 1.0) * samples));
+  return standard_error / (2.0 * std::sqrt(std::max(mean, kMinLuminance)));
+}
+
+math::Ray Camera::GetRayFor(double u_norm, double v_norm,
+                            sampler::Sampler& sampler) const {
   const double px = u_norm * (settings_.image_width - 1);
   const double py = v_norm * (image_height_ - 1);
 
@@ -152,36 +688,85 @@ math::Ray Camera::GetRayFor(double u_norm, double v_norm) const {
 
   const auto pixel_sample = pixel00_loc_ + pixel_offset_u + pixel_offset_v;
 
-  const auto ray_origin = (settings_.defocus_angle <= 0) ? center_ : DefocusDiskSample();
+  // Draw the lens sample even without defocus to keep dimensions aligned
+  const auto lens_sample = DefocusDiskSample(sampler);
+  const auto ray_origin =
+      (settings_.defocus_angle <= 0) ? center_ : lens_sample;
   const auto ray_direction = pixel_sample - center_;
-  const auto ray_time = math::RandomDouble();
+  const auto ray_time = static_cast<math::Real>(sampler.Get1D());
 
   return {ray_origin, ray_direction, ray_time};
 }
 
-math::Vec3 Camera::DefocusDiskSample() const {
+math::Vec3 Camera::DefocusDiskSample(sampler::Sampler& sampler) const {
   // return a random point in the camera defocus disk.
-  auto p = math::Vec3::RandomInUnitDisk();
+  auto p = math::Vec3::RandomInUnitDisk(sampler);
   return center_ + (p[0] * defocus_disk_u_) + (p[1] * defocus_disk_v_);
 }
 
-image::PixelF64 Camera::RayColour(const math::Ray& r, std::uint32_t depth,
-                                  const scene::Hittable& world) {
-  if (depth == 0) {
-    return {0, 0, 0};
-  }
+image::PixelF64 Camera::RayColour(const math::Ray& r,
+                                  const HitInfo* first_hit,
+                                  const Hittable& world,
+                                  const material::MaterialTable& materials,
+                                  sampler::Sampler& sampler) {
+  image::PixelF64 radiance(0, 0, 0);
+  image::PixelF64 throughput(1, 1, 1);
+  math::Ray ray = r;
+  HitInfo rec;
+  double path_length = 0;
+
+  for (std::uint32_t depth = 0; depth < settings_.max_depth_; ++depth) {
+    if (depth == 0 && first_hit != nullptr) {
+      rec = *first_hit;
+    } else {
+      ++tls_ray_count;
+      if (!world.Hit(ray, math::Interval(0.001, math::kInfinity), rec)) {
+        radiance += throughput * Background(ray);
+        break;
+      }
+    }
+
+    // The pixel's ray cone is followed along the whole path, ignoring the
+    // spread bounces add. On a slanted surface its footprint is an ellipse;
+    // filters are isotropic, so they get the mean of its axes, which blurs
+    // less than the long one would. The width is then put in uv units.
+    const auto direction_length = ray.Direction().Length();
+    path_length += rec.t_ * direction_length;
+    const double cosine =
+        std::fabs(rec.normal_.Dot(ray.Direction())) / direction_length;
+    rec.footprint_ = static_cast<float>(pixel_spread_ * path_length *
+                                        rec.uv_density_ /
+                                        std::sqrt(std::max(cosine, 0.05)));
 
-  scene::HitInfo rec;
-  if (world.Hit(r, math::Interval(0.001, math::kInfinity), rec)) {
     math::Ray scattered;
     image::PixelF64 attenuation;
-    if (rec.material_->Scatter(r, rec, attenuation, scattered)) {
-      return attenuation * RayColour(scattered, depth - 1, world);
+    if (!materials.Scatter(rec.material_, ray, rec, attenuation, scattered,
+                           sampler)) {
+      break;
+    }
+    throughput *= attenuation;
+
+    // Russian roulette: continue with probability p and divide the survivors
+    // by p, which keeps the estimate unbiased while ending dim paths early.
+    const double p = std::min(
+        0.95, std::max({throughput.R(), throughput.G(), throughput.B()}));
+    if (p <= 0.0) {
+      break;
+    }
+    if (depth + 1 >= settings_.roulette_depth) {
+      if (sampler.Get1D() >= p) {
+        break;
+      }
+      throughput /= p;
     }
 
-    return {0, 0, 0};
+    ray = scattered;
   }
 
+  return radiance;
+}
+
+image::PixelF64 Camera::Background(const math::Ray& r) {
   math::Vec3 unit_direction = r.Direction().Normalized();
   auto a = 0.5 * (unit_direction.Y() + 1.0);
   // Blue-ish sky gradient from white at the horizon to light blue at the top
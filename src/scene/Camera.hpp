@@ -1,13 +1,35 @@
 #ifndef POLARIS_CAMERA_CAMERA_HPP
 #define POLARIS_CAMERA_CAMERA_HPP
 
+#include <array>
+#include <cstdint>
+#include <functional>
 #include <image/FrameBuffer.hpp>
+#include <image/ToneMap.hpp>
 #include <math/Common.hpp>
 #include <optional>
+#include <memory>
 #include <scene/Hittable.hpp>
+#include <scene/material/MaterialTable.hpp>
+#include <scene/sampler/Sampler.hpp>
+#include <string>
+#include <util/ThreadPool.hpp>
+#include <vector>
 
 namespace polaris::scene {
 
+enum class TraceMode : std::uint8_t {
+  Scalar = 0,  // One ray at a time
+  Packet,      // Primary rays of 2x2 pixel blocks traced as SIMD packets
+};
+
+// Order in which tiles are handed to the render threads
+enum class TileOrder : std::uint8_t {
+  RowMajor = 0,  // Left to right, top to bottom
+  Hilbert,       // Along a Hilbert curve, keeping nearby tiles together
+  CenterOut,     // Nearest to the image centre first, for previews
+};
+
 struct CameraSettings {
   // Camera
   double aspect_ratio = 16.0 / 9.0;
@@ -20,42 +42,163 @@ struct CameraSettings {
   std::uint32_t samples_per_pixel =
       10;                         // Random samples per pixel (anti-aliasing)
   std::uint32_t max_depth_ = 10;  // Maximum ray bounces into the scene
+  // Bounces before Russian roulette may end a path; from then on paths go on
+  // with a probability given by their remaining throughput.
+  std::uint32_t roulette_depth = 5;
   image::FileFormat output_format_ =
       image::FileFormat::BMP;  // Output image format
+  // Display mapping of 8-bit output formats; HDR formats stay linear
+  image::ToneMapSettings tone_map;
+
+  // Sampling. The same seed reproduces the same image exactly.
+  sampler::SamplerType sampler = sampler::SamplerType::Sobol;
+  std::uint64_t seed = 0;
+
+  // Adaptive sampling, enabled by a positive threshold. Every pixel takes
+  // adaptive_min_samples, then pixels keep doubling their count until the
+  // standard error of their displayed (gamma 2) value is below the threshold
+  // or they reach adaptive_max_samples. samples_per_pixel becomes the
+  // average budget of each tile, which goes to the noisiest pixels first.
+  double adaptive_threshold = 0.0;
+  std::uint32_t adaptive_min_samples = 16;
+  std::uint32_t adaptive_max_samples = 1024;
+
+  // Progressive rendering. Render() takes its samples in passes of this many
+  // samples per pixel, or all at once when 0, and updates the image after
+  // each pass.
+  std::uint32_t pass_samples = 0;
 
   // Parallel rendering
   int tile_size = 64;  // Square tile size in pixels
+  TileOrder tile_order = TileOrder::Hilbert;
+  TraceMode trace_mode = TraceMode::Scalar;
+  // Threads rendering tiles, counting the one that calls Render(). 0 shares
+  // the default pool of one worker per hardware thread between cameras.
+  std::uint32_t thread_count = 0;
+  bool pin_threads = false;  // Bind each worker to one CPU (Linux only)
+};
+
+struct RenderStats {
+  double render_ms = 0.0;       // Wall time of the last Render() call
+  std::uint64_t ray_count = 0;  // Camera and scattered rays traced
 };
 
 class Camera {
  public:
   explicit Camera(const CameraSettings& settings);
 
-  void Render(const Hittable& world);
+  // Called after each pass with the samples per pixel taken so far, once the
+  // image holds all of them, e.g. to write a preview
+  using PassCallback = std::function<void(std::uint32_t samples)>;
+
+  // Renders samples_per_pixel samples per pixel from scratch. `materials`
+  // holds the materials hits on `world` name.
+  void Render(const Hittable& world, const material::MaterialTable& materials,
+              const PassCallback& on_pass = {});
+
+  // Adds `samples` samples per pixel to the current image, continuing each
+  // pixel's sample sequence where the last pass left it
+  void Refine(const Hittable& world, const material::MaterialTable& materials,
+              std::uint32_t samples, const PassCallback& on_pass = {});
+
   void Write(const std::string& filename);
 
+  // Writes a high dynamic range image tone mapped into an 8-bit `format`
+  void WriteToneMapped(const std::string& filename, image::FileFormat format,
+                       const image::ToneMapSettings& tone_map) const;
+
+  // Writes the number of samples each pixel has taken so far, black
+  // for the fewest and white for the most.
+  void WriteSampleHeatmap(const std::string& filename) const;
+
   void SetTarget(const math::Vec3& pos, std::optional<math::Vec3> opt_lookat);
 
+  [[nodiscard]] const RenderStats& Stats() const { return stats_; }
+
+  // Samples per pixel accumulated so far (the average in adaptive mode)
+  [[nodiscard]] std::uint32_t AccumulatedSamples() const {
+    return accumulated_samples_;
+  }
+
+  // Saves the accumulated samples so a later run can Refine() the image.
+  // Loading fails unless the image size, sampler and seed match.
+  bool SaveState(const std::string& filename) const;
+  bool LoadState(const std::string& filename);
+
  private:
-  math::Ray GetRayFor(double u_norm, double v_norm) const;
+  // Values every camera sample draws: pixel jitter (2), lens (2) and time (1)
+  static constexpr std::uint32_t kCameraDimensions = 5;
+
+  math::Ray GetRayFor(double u_norm, double v_norm,
+                      sampler::Sampler& sampler) const;
+
+  math::Vec3 DefocusDiskSample(sampler::Sampler& sampler) const;
+
+  // Colour sum of one pixel and Welford statistics of its luminance
+  struct PixelEstimate {
+    image::PixelF64 sum;
+    double mean = 0.0;
+    double m2 = 0.0;
+    std::uint32_t samples = 0;
+
+    void Add(const image::PixelF64& colour);
+
+    // Standard error of the displayed value, infinite below two samples
+    [[nodiscard]] double Error() const;
+  };
+
+  // Radiance arriving along `r`, traced iteratively up to max_depth_
+  // bounces. Packet tracing passes the hit it already found as `first_hit`.
+  image::PixelF64 RayColour(const math::Ray& r, const HitInfo* first_hit,
+                            const Hittable& world,
+                            const material::MaterialTable& materials,
+                            sampler::Sampler& sampler);
+
+  static image::PixelF64 Background(const math::Ray& r);
 
-  math::Vec3 DefocusDiskSample() const;
+  static void WriteImage(image::FrameBuffer& buffer, image::FileFormat format,
+                         const std::string& filename);
 
-  image::PixelF64 RayColour(const math::Ray& r, std::uint32_t depth,
-                            const Hittable& world);
+  // Adds `samples` samples per pixel on average and updates the image
+  void RenderPass(const Hittable& world,
+                  const material::MaterialTable& materials,
+                  std::uint32_t samples);
 
   void RenderTile(int x0, int y0, int x1, int y1, const Hittable& world,
-                  std::mt19937& rng);
+                  const material::MaterialTable& materials,
+                  sampler::Sampler& sampler, std::uint32_t samples);
+
+  // Writes the mean of each accumulated pixel in the region to the image
+  void Resolve(int x0, int y0, int x1, int y1);
+
+  // Adds samples [first, last) of one pixel to its estimate
+  void SamplePixel(int x, int y, std::uint32_t first, std::uint32_t last,
+                   const Hittable& world,
+                   const material::MaterialTable& materials,
+                   sampler::Sampler& sampler, PixelEstimate& estimate);
+
+  // Packet version for the `lanes` of the 2x2 block at (x, y): adds `count`
+  // samples to each lane's estimate, from the sample that estimate has
+  // reached
+  void SampleBlock(
+      int x, int y, int lanes, std::uint32_t count, const Hittable& world,
+      const material::MaterialTable& materials, sampler::Sampler& sampler,
+      const std::array<PixelEstimate*, math::RayPacket::kWidth>& estimates);
 
   CameraSettings settings_;
+  std::unique_ptr<sampler::Sampler> sampler_;  // Cloned by each tile
+  std::unique_ptr<util::ThreadPool> pool_;  // Unless the default pool is used
+  RenderStats stats_;
 
-  double pixel_samples_scale_ = 0.0;   // Color scale factor for sampled pixels
   int image_height_ = 0;               // Rendered image height
   math::Vec3 center_;                // Camera center
   math::Vec3 pixel00_loc_;           // Location of pixel 0, 0
   math::Vec3 pixel_delta_u_;         // Offset to pixel to the right
   math::Vec3 pixel_delta_v_;         // Offset to pixel below
+  double pixel_spread_ = 0;  // Angle a pixel subtends, widening ray cones
   image::FrameBuffer frame_buffer_;  // Destination image
+  std::vector<PixelEstimate> accumulation_;  // Per pixel, all passes
+  std::uint32_t accumulated_samples_ = 0;
 
   math::Vec3 position_;
   math::Vec3 lookat_{0, 0, -1};
@@ -1,25 +1,37 @@
 #ifndef POLARIS_SCENE_HITTABLE_HPP
 #define POLARIS_SCENE_HITTABLE_HPP
 
+#include <array>
+#include <concepts>
+#include <cstdint>
 #include <math/AABB.hpp>
+#include <math/Common.hpp>
 #include <math/Interval.hpp>
 #include <math/Ray.hpp>
+#include <math/RayPacket.hpp>
 #include <math/Vec.hpp>
 #include <memory>
-#include <scene/material/Material.hpp>
 
 namespace polaris::scene {
 
-struct HitInfo {
-  math::Vec3 point_;
-  math::Vec3 normal_;
-  double t_ = 0.0;
-  double u_ = 0.0;
-  double v_ = 0.0;
-  bool front_face_ = false;
-  std::shared_ptr<material::Material> material_;
+template <std::floating_point T>
+struct BasicHitInfo {
+  using Vec = math::Vector<T, 3>;
 
-  void SetNormal(const math::Ray& r, const math::Vec3& outward_normal) {
+  Vec point_;
+  Vec normal_;
+  T t_ = 0;
+  T u_ = 0;
+  T v_ = 0;
+  bool front_face_ = false;
+  std::uint32_t material_ = 0;  // Index into the scene's MaterialTable
+  // Change of (u, v) per unit of distance along the surface, set by the
+  // primitive hit; the camera scales it to the width of the ray's footprint
+  // in uv units, which texture filtering reads.
+  float uv_density_ = 0;
+  float footprint_ = 0;
+
+  void SetNormal(const math::BasicRay<T>& r, const Vec& outward_normal) {
     if (r.Direction().Dot(outward_normal) < 0) {
       front_face_ = true;
       normal_ = outward_normal;
@@ -28,59 +40,50 @@ struct HitInfo {
       normal_ = -outward_normal;
     }
   }
+
+  // Origin for a ray leaving the hit point along `direction`, pushed off the
+  // surface on the side the ray heads to.
+  [[nodiscard]] Vec SpawnOrigin(const Vec& direction) const {
+    return math::OffsetRayOrigin(
+        point_, direction.Dot(normal_) > 0 ? normal_ : -normal_);
+  }
 };
 
+using HitInfo = BasicHitInfo<math::Real>;
+
+// Per-lane hit distances and records for packet tracing.
+using PacketDistances = std::array<double, math::RayPacket::kWidth>;
+using PacketHitInfo = std::array<HitInfo, math::RayPacket::kWidth>;
+
 class Hittable {
  public:
   virtual ~Hittable() = default;
 
+  // Implementations must leave `rec` untouched unless they return true, which
+  // lets containers pass the caller's record straight down to their children.
   [[nodiscard]] virtual bool Hit(const math::Ray& r,
                                  const math::Interval& t_interval,
                                  HitInfo& rec) const = 0;
 
-  [[nodiscard]] virtual math::AABB GetBounds() const = 0;
-};
-
-class HittableList : public Hittable {
- public:
-  HittableList() = default;
-  explicit HittableList(const std::shared_ptr<Hittable>& object) { Add(object); };
-
-  void Clear() { objects.clear(); }
-
-  void Add(const std::shared_ptr<Hittable>& object) {
-    objects.push_back(object);
-    bb_ = math::AABB(bb_, object->GetBounds());
-  }
-
-  [[nodiscard]] bool Hit(const math::Ray& r, const math::Interval& t_interval,
-                         HitInfo& rec) const override {
-    bool hit_anything = false;
-    auto closest_so_far = t_interval.Max();
-
-    HitInfo temp_rec;
-    for (const auto& object : objects) {
-      if (object->Hit(r, math::Interval(t_interval.Min(), closest_so_far),
-                      temp_rec)) {
-        hit_anything = true;
-        closest_so_far = temp_rec.t_;
-        rec = temp_rec;
+  // Packet counterpart of Hit() for the lanes set in `mask`. A lane that
+  // finds a hit closer than t_max[lane] updates t_max and rec for that lane
+  // only; the returned mask holds the lanes that hit. The default traces each
+  // lane on its own.
+  [[nodiscard]] virtual int HitPacket(const math::RayPacket& packet, int mask,
+                                      double t_min, PacketDistances& t_max,
+                                      PacketHitInfo& rec) const {
+    int hits = 0;
+    for (int lane = 0; lane < math::RayPacket::kWidth; ++lane) {
+      if ((mask & (1 << lane)) != 0 &&
+          Hit(packet[lane], math::Interval(t_min, t_max[lane]), rec[lane])) {
+        t_max[lane] = rec[lane].t_;
+        hits |= 1 << lane;
       }
     }
-
-    return hit_anything;
+    return hits;
   }
 
-  [[nodiscard]] math::AABB GetBounds() const override { return bb_; }
-
-  [[nodiscard]] const std::vector<std::shared_ptr<Hittable>>& GetObjects()
-      const {
-    return objects;
-  }
-
- private:
-  std::vector<std::shared_ptr<Hittable>> objects;
-  math::AABB bb_;
+  [[nodiscard]] virtual math::AABB GetBounds() const = 0;
 };
 
 }  // namespace polaris::scene
@@ -0,0 +1,58 @@
+#ifndef POLARIS_SCENE_HITTABLE_LIST_HPP
+#define POLARIS_SCENE_HITTABLE_LIST_HPP
+
+#include <math/AABB.hpp>
+#include <math/Interval.hpp>
+#include <math/Ray.hpp>
+#include <math/RayPacket.hpp>
+#include <memory>
+#include <scene/Hittable.hpp>
+#include <scene/PrimitiveStore.hpp>
+
+namespace polaris::scene {
+
+// Primitives tested one after another. Spheres and quads go straight into
+// the list's PrimitiveStore; accelerators build over the same store.
+class HittableList : public Hittable {
+ public:
+  HittableList() = default;
+  explicit HittableList(const std::shared_ptr<Hittable>& object) {
+    Add(object);
+  }
+
+  void Clear() { primitives_.Clear(); }
+
+  void Add(const std::shared_ptr<Hittable>& object) {
+    primitives_.AddObject(object);
+  }
+
+  [[nodiscard]] bool Hit(const math::Ray& r, const math::Interval& t_interval,
+                         HitInfo& rec) const override {
+    auto closest_so_far = t_interval.Max();
+    return primitives_.HitRange(0, primitives_.Size(), r, t_interval.Min(),
+                                closest_so_far, rec);
+  }
+
+  [[nodiscard]] int HitPacket(const math::RayPacket& packet, int mask,
+                              double t_min, PacketDistances& t_max,
+                              PacketHitInfo& rec) const override {
+    return primitives_.HitRangePacket(0, primitives_.Size(), packet, mask,
+                                      t_min, t_max, rec);
+  }
+
+  [[nodiscard]] math::AABB GetBounds() const override {
+    return primitives_.GetBounds();
+  }
+
+  [[nodiscard]] PrimitiveStore& Primitives() { return primitives_; }
+  [[nodiscard]] const PrimitiveStore& Primitives() const {
+    return primitives_;
+  }
+
+ private:
+  PrimitiveStore primitives_;
+};
+
+}  // namespace polaris::scene
+
+#endif
@@ -0,0 +1,638 @@
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cctype>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <scene/MeshLoader.hpp>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <util/MappedFile.hpp>
+#include <util/ThreadPool.hpp>
+#include <utility>
+#include <vector>
+
+namespace polaris::scene {
+namespace {
+using objects::MeshTriangle;
+
+// OBJ text is cut into pieces of about this many bytes, ending on a line
+// break, which are parsed in parallel
+constexpr std::size_t kChunkBytes = std::size_t{1} << 20;
+
+struct MeshData {
+  std::vector<math::Vec3> vertices;
+  std::vector<MeshTriangle> triangles;
+};
+
+bool IsBlank(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+// Cursor over one line of text
+class LineReader {
+ public:
+  explicit LineReader(std::string_view line) : rest_(line) {}
+
+  // Next blank separated word, or an empty view at the end of the line
+  std::string_view Next() {
+    std::size_t begin = 0;
+    while (begin < rest_.size() && IsBlank(rest_[begin])) {
+      ++begin;
+    }
+    std::size_t end = begin;
+    while (end < rest_.size() && !IsBlank(rest_[end])) {
+      ++end;
+    }
+    const auto word = rest_.substr(begin, end - begin);
+    rest_.remove_prefix(end);
+    return word;
+  }
+
+ private:
+  std::string_view rest_;
+};
+
+template <typename T>
+bool ParseWord(std::string_view word, T& value) {
+  const auto* end = word.data() + word.size();
+  auto [ptr, ec] = std::from_chars(word.data(), end, value);
+  return ec == std::errc() && ptr == end;
+}
+
+// Splits a polygon with corners `first`, ..., `previous`, `current` into a
+// fan around its first corner
+class FanBuilder {
+ public:
+  explicit FanBuilder(std::vector<MeshTriangle>& out) : out_(out) {}
+
+  void Add(std::uint32_t index) {
+    if (corners_ == 0) {
+      first_ = index;
+    } else if (corners_ >= 2) {
+      out_.push_back({first_, previous_, index});
+    }
+    previous_ = index;
+    ++corners_;
+  }
+
+  [[nodiscard]] std::size_t Corners() const { return corners_; }
+
+ private:
+  std::vector<MeshTriangle>& out_;
+  std::uint32_t first_ = 0;
+  std::uint32_t previous_ = 0;
+  std::size_t corners_ = 0;
+};
+
+struct ObjChunk {
+  std::string_view text;
+  std::size_t first_line = 0;    // 1-based line number of the first line
+  std::size_t first_vertex = 0;  // Vertices declared before the chunk
+  std::size_t line_count = 0;
+  std::size_t vertex_count = 0;
+  std::vector<MeshTriangle> triangles;
+  std::string error;
+};
+
+bool IsVertexLine(std::string_view line) {
+  std::size_t i = 0;
+  while (i < line.size() && IsBlank(line[i])) {
+    ++i;
+  }
+  return i + 1 < line.size() && line[i] == 'v' && IsBlank(line[i + 1]);
+}
+
+template <typename Fn>
+void ForEachLine(std::string_view text, Fn&& fn) {
+  std::size_t pos = 0;
+  while (pos < text.size()) {
+    auto end = text.find('\n', pos);
+    if (end == std::string_view::npos) {
+      end = text.size();
+    }
+    fn(text.substr(pos, end - pos));
+    pos = end + 1;
+  }
+}
+
+// First pass: only lines and vertices are counted, which fixes where each
+// chunk's vertices go and what relative indices refer to
+void CountObjChunk(ObjChunk& chunk) {
+  ForEachLine(chunk.text, [&](std::string_view line) {
+    ++chunk.line_count;
+    if (IsVertexLine(line)) {
+      ++chunk.vertex_count;
+    }
+  });
+}
+
+void ParseObjChunk(ObjChunk& chunk, std::span<math::Vec3> vertices) {
+  const auto total = static_cast<std::int64_t>(vertices.size());
+  auto next_vertex = static_cast<std::int64_t>(chunk.first_vertex);
+  auto line_number = chunk.first_line;
+
+  const auto fail = [&](std::string_view what) {
+    chunk.error =
+        "line " + std::to_string(line_number) + ": " + std::string(what);
+  };
+
+  std::size_t pos = 0;
+  while (pos < chunk.text.size() && chunk.error.empty()) {
+    auto end = chunk.text.find('\n', pos);
+    if (end == std::string_view::npos) {
+      end = chunk.text.size();
+    }
+    LineReader reader(chunk.text.substr(pos, end - pos));
+    pos = end + 1;
+
+    const auto keyword = reader.Next();
+    if (keyword == "v") {
+      double x = 0.0;
+      double y = 0.0;
+      double z = 0.0;
+      if (!ParseWord(reader.Next(), x) || !ParseWord(reader.Next(), y) ||
+          !ParseWord(reader.Next(), z)) {
+        fail("bad vertex");
+        break;
+      }
+      vertices[next_vertex++] = math::Vec3(static_cast<math::Real>(x),
+                                           static_cast<math::Real>(y),
+                                           static_cast<math::Real>(z));
+    } else if (keyword == "f") {
+      FanBuilder fan(chunk.triangles);
+      for (auto word = reader.Next(); !word.empty(); word = reader.Next()) {
+        // Texture and normal indices after a slash are not used
+        word = word.substr(0, word.find('/'));
+        std::int64_t index = 0;
+        if (!ParseWord(word, index) || index == 0) {
+          fail("bad face");
+          break;
+        }
+        index = index > 0 ? index - 1 : next_vertex + index;
+        if (index < 0 || index >= total) {
+          fail("face index out of range");
+          break;
+        }
+        fan.Add(static_cast<std::uint32_t>(index));
+      }
+      if (chunk.error.empty() && fan.Corners() < 3) {
+        fail("face with fewer than three corners");
+      }
+    }
+    ++line_number;
+  }
+}
+
+std::expected<MeshData, std::string> ReadObj(std::string_view text) {
+  std::vector<ObjChunk> chunks;
+  for (std::size_t pos = 0; pos < text.size();) {
+    auto end = std::min(pos + kChunkBytes, text.size());
+    end = std::min(text.find('\n', end), text.size());
+    chunks.emplace_back().text = text.substr(pos, end - pos);
+    pos = end + 1;
+  }
+
+  auto& pool = util::ThreadPool::Default();
+  {
+    util::TaskGroup tasks(pool);
+    for (auto& chunk : chunks) {
+      tasks.Run([&chunk] { CountObjChunk(chunk); });
+    }
+    tasks.Wait();
+  }
+
+  std::size_t line = 1;
+  std::size_t vertex_count = 0;
+  for (auto& chunk : chunks) {
+    chunk.first_line = line;
+    chunk.first_vertex = vertex_count;
+    line += chunk.line_count;
+    vertex_count += chunk.vertex_count;
+  }
+  if (vertex_count > std::numeric_limits<std::uint32_t>::max()) {
+    return std::unexpected("too many vertices");
+  }
+
+  MeshData mesh;
+  mesh.vertices.resize(vertex_count);
+  {
+    util::TaskGroup tasks(pool);
+    for (auto& chunk : chunks) {
+      tasks.Run([&chunk, &mesh] { ParseObjChunk(chunk, mesh.vertices); });
+    }
+    tasks.Wait();
+  }
+
+  std::size_t triangle_count = 0;
+  for (const auto& chunk : chunks) {
+    if (!chunk.error.empty()) {
+      return std::unexpected(chunk.error);
+    }
+    triangle_count += chunk.triangles.size();
+  }
+  mesh.triangles.reserve(triangle_count);
+  for (auto& chunk : chunks) {
+    mesh.triangles.insert(mesh.triangles.end(), chunk.triangles.begin(),
+                          chunk.triangles.end());
+    chunk.triangles = {};
+  }
+  return mesh;
+}
+
+enum class PlyFormat : std::uint8_t { Ascii, LittleEndian, BigEndian };
+
+enum class PlyType : std::uint8_t {
+  Int8,
+  UInt8,
+  Int16,
+  UInt16,
+  Int32,
+  UInt32,
+  Float32,
+  Float64
+};
+
+constexpr std::array<std::pair<std::string_view, PlyType>, 16> kPlyTypeNames{
+    {{"char", PlyType::Int8},       {"int8", PlyType::Int8},
+     {"uchar", PlyType::UInt8},     {"uint8", PlyType::UInt8},
+     {"short", PlyType::Int16},     {"int16", PlyType::Int16},
+     {"ushort", PlyType::UInt16},   {"uint16", PlyType::UInt16},
+     {"int", PlyType::Int32},       {"int32", PlyType::Int32},
+     {"uint", PlyType::UInt32},     {"uint32", PlyType::UInt32},
+     {"float", PlyType::Float32},   {"float32", PlyType::Float32},
+     {"double", PlyType::Float64},  {"float64", PlyType::Float64}}};
+
+bool ParsePlyType(std::string_view name, PlyType& type) {
+  for (const auto& [entry, value] : kPlyTypeNames) {
+    if (entry == name) {
+      type = value;
+      return true;
+    }
+  }
+  return false;
+}
+
+// Bytes one value of `type` takes in a binary body
+constexpr std::size_t PlyTypeSize(PlyType type) {
+  switch (type) {
+    case PlyType::Int8:
+    case PlyType::UInt8:
+      return 1;
+    case PlyType::Int16:
+    case PlyType::UInt16:
+      return 2;
+    case PlyType::Int32:
+    case PlyType::UInt32:
+    case PlyType::Float32:
+      return 4;
+    case PlyType::Float64:
+      break;
+  }
+  return 8;
+}
+
+struct PlyProperty {
+  std::string_view name;
+  PlyType type = PlyType::Float32;
+  bool is_list = false;
+  PlyType count_type = PlyType::UInt8;  // Lists only
+};
+
+struct PlyElement {
+  std::string_view name;
+  std::size_t count = 0;
+  std::vector<PlyProperty> properties;
+};
+
+// Reads the values of the body one at a time, in any of the three formats
+class PlyReader {
+ public:
+  PlyReader(std::span<const std::byte> body, PlyFormat format)
+      : data_(body.data()), end_(body.data() + body.size()), format_(format) {}
+
+  bool Read(PlyType type, double& value) {
+    if (format_ == PlyFormat::Ascii) {
+      return ReadText(value);
+    }
+    switch (type) {
+      case PlyType::Int8:
+        return ReadBinary<std::int8_t>(value);
+      case PlyType::UInt8:
+        return ReadBinary<std::uint8_t>(value);
+      case PlyType::Int16:
+        return ReadBinary<std::int16_t>(value);
+      case PlyType::UInt16:
+        return ReadBinary<std::uint16_t>(value);
+      case PlyType::Int32:
+        return ReadBinary<std::int32_t>(value);
+      case PlyType::UInt32:
+        return ReadBinary<std::uint32_t>(value);
+      case PlyType::Float32:
+        return ReadBinary<float>(value);
+      case PlyType::Float64:
+        return ReadBinary<double>(value);
+    }
+    return false;
+  }
+
+  // Reads a list count or vertex index, which must be a whole number no
+  // larger than a 32-bit index
+  bool ReadIndex(PlyType type, std::uint32_t& index) {
+    double value = 0.0;
+    if (!Read(type, value) || !(value >= 0) ||
+        value > std::numeric_limits<std::uint32_t>::max() ||
+        value != std::floor(value)) {
+      return false;
+    }
+    index = static_cast<std::uint32_t>(value);
+    return true;
+  }
+
+  // Reads a property and drops it
+  bool Skip(const PlyProperty& property) {
+    double value = 0.0;
+    if (!property.is_list) {
+      return Read(property.type, value);
+    }
+    std::uint32_t count = 0;
+    if (!ReadIndex(property.count_type, count)) {
+      return false;
+    }
+    for (; count > 0; --count) {
+      if (!Read(property.type, value)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // Whether the rest of the body can hold `count` records of `element`.
+  // Binary values take their type's size, text ones a digit and a blank
+  // each, and lists at least their count.
+  [[nodiscard]] bool Holds(const PlyElement& element,
+                           std::size_t count) const {
+    std::size_t record = 0;
+    for (const auto& property : element.properties) {
+      const auto type = property.is_list ? property.count_type : property.type;
+      record += format_ == PlyFormat::Ascii ? 2 : PlyTypeSize(type);
+    }
+    // The text's last value may end the file without a blank
+    const auto remaining = static_cast<std::size_t>(end_ - data_) +
+                           (format_ == PlyFormat::Ascii ? 1 : 0);
+    return record == 0 ? count == 0 : count <= remaining / record;
+  }
+
+ private:
+  template <typename T>
+  bool ReadBinary(double& value) {
+    if (static_cast<std::size_t>(end_ - data_) < sizeof(T)) {
+      return false;
+    }
+    using Bits = std::conditional_t<
+        sizeof(T) == 1, std::uint8_t,
+        std::conditional_t<sizeof(T) == 2, std::uint16_t,
+                           std::conditional_t<sizeof(T) == 4, std::uint32_t,
+                                              std::uint64_t>>>;
+    Bits bits = 0;
+    std::memcpy(&bits, data_, sizeof(T));
+    data_ += sizeof(T);
+    if ((format_ == PlyFormat::BigEndian) !=
+        (std::endian::native == std::endian::big)) {
+      bits = std::byteswap(bits);
+    }
+    value = static_cast<double>(std::bit_cast<T>(bits));
+    return true;
+  }
+
+  bool ReadText(double& value) {
+    const auto* text = reinterpret_cast<const char*>(data_);
+    const auto* end = reinterpret_cast<const char*>(end_);
+    while (text < end && (IsBlank(*text) || *text == '\n')) {
+      ++text;
+    }
+    auto [ptr, ec] = std::from_chars(text, end, value);
+    data_ = reinterpret_cast<const std::byte*>(ptr);
+    return ec == std::errc();
+  }
+
+  const std::byte* data_;
+  const std::byte* end_;
+  PlyFormat format_;
+};
+
+std::expected<MeshData, std::string> ReadPly(std::span<const std::byte> bytes) {
+  const std::string_view text(reinterpret_cast<const char*>(bytes.data()),
+                              bytes.size());
+  constexpr std::string_view kEndHeader = "end_header";
+  if (!text.starts_with("ply")) {
+    return std::unexpected("not a PLY file");
+  }
+
+  std::vector<PlyElement> elements;
+  PlyFormat format = PlyFormat::Ascii;
+  bool has_format = false;
+  std::size_t body = 0;
+
+  std::size_t pos = 0;
+  while (body == 0) {
+    const auto end = text.find('\n', pos);
+    if (end == std::string_view::npos) {
+      return std::unexpected("PLY header has no end_header");
+    }
+    LineReader reader(text.substr(pos, end - pos));
+    pos = end + 1;
+
+    const auto keyword = reader.Next();
+    if (keyword == "format") {
+      const auto name = reader.Next();
+      if (name == "ascii") {
+        format = PlyFormat::Ascii;
+      } else if (name == "binary_little_endian") {
+        format = PlyFormat::LittleEndian;
+      } else if (name == "binary_big_endian") {
+        format = PlyFormat::BigEndian;
+      } else {
+        return std::unexpected("unknown PLY format '" + std::string(name) +
+                               "'");
+      }
+      has_format = true;
+    } else if (keyword == "element") {
+      auto& element = elements.emplace_back();
+      element.name = reader.Next();
+      if (!ParseWord(reader.Next(), element.count)) {
+        return std::unexpected("bad PLY element");
+      }
+    } else if (keyword == "property") {
+      if (elements.empty()) {
+        return std::unexpected("PLY property outside an element");
+      }
+      PlyProperty property;
+      auto type = reader.Next();
+      if (type == "list") {
+        property.is_list = true;
+        if (!ParsePlyType(reader.Next(), property.count_type)) {
+          return std::unexpected("bad PLY list count type");
+        }
+        type = reader.Next();
+      }
+      if (!ParsePlyType(type, property.type)) {
+        return std::unexpected("unknown PLY type '" + std::string(type) + "'");
+      }
+      property.name = reader.Next();
+      elements.back().properties.push_back(property);
+    } else if (keyword == kEndHeader) {
+      body = pos;
+    }
+  }
+  if (!has_format) {
+    return std::unexpected("PLY header has no format");
+  }
+
+  MeshData mesh;
+  PlyReader reader(bytes.subspan(body), format);
+  for (const auto& element : elements) {
+    // Counts are checked before anything is reserved for them
+    if (!reader.Holds(element, element.count)) {
+      return std::unexpected("PLY element '" + std::string(element.name) +
+                             "' has more records than the file holds");
+    }
+    if (element.name == "vertex") {
+      // Index of each property's coordinate, or 3 if it is not x, y or z
+      std::vector<int> axes;
+      for (const auto& property : element.properties) {
+        const auto axis = property.is_list ? 3
+                          : property.name == "x" ? 0
+                          : property.name == "y" ? 1
+                          : property.name == "z" ? 2
+                                                 : 3;
+        axes.push_back(axis);
+      }
+      if (std::count(axes.begin(), axes.end(), 0) != 1 ||
+          std::count(axes.begin(), axes.end(), 1) != 1 ||
+          std::count(axes.begin(), axes.end(), 2) != 1) {
+        return std::unexpected("PLY vertices need x, y and z");
+      }
+
+      mesh.vertices.reserve(element.count);
+      for (std::size_t i = 0; i < element.count; ++i) {
+        std::array<double, 3> position{};
+        for (std::size_t p = 0; p < axes.size(); ++p) {
+          const auto& property = element.properties[p];
+          const bool ok = axes[p] < 3
+                              ? reader.Read(property.type, position[axes[p]])
+                              : reader.Skip(property);
+          if (!ok) {
+            return std::unexpected("PLY vertex data ends early");
+          }
+        }
+        mesh.vertices.emplace_back(static_cast<math::Real>(position[0]),
+                                   static_cast<math::Real>(position[1]),
+                                   static_cast<math::Real>(position[2]));
+      }
+    } else if (element.name == "face") {
+      mesh.triangles.reserve(element.count);
+      for (std::size_t i = 0; i < element.count; ++i) {
+        for (const auto& property : element.properties) {
+          if (property.name != "vertex_indices" &&
+              property.name != "vertex_index") {
+            if (!reader.Skip(property)) {
+              return std::unexpected("PLY face data ends early");
+            }
+            continue;
+          }
+
+          std::uint32_t count = 0;
+          if (!property.is_list ||
+              !reader.ReadIndex(property.count_type, count) || count < 3) {
+            return std::unexpected("bad PLY face");
+          }
+          FanBuilder fan(mesh.triangles);
+          for (; count > 0; --count) {
+            std::uint32_t index = 0;
+            if (!reader.ReadIndex(property.type, index)) {
+              return std::unexpected(
+                  "PLY face index is missing, negative or not whole");
+            }
+            fan.Add(index);
+          }
+        }
+      }
+    } else {
+      for (std::size_t i = 0; i < element.count; ++i) {
+        for (const auto& property : element.properties) {
+          if (!reader.Skip(property)) {
+            return std::unexpected("PLY data ends early");
+          }
+        }
+      }
+    }
+  }
+
+  // Faces may come before the vertices, so indices are checked at the end
+  const auto vertex_count = mesh.vertices.size();
+  for (const auto& triangle : mesh.triangles) {
+    for (const auto index : triangle) {
+      if (index >= vertex_count) {
+        return std::unexpected("PLY face index out of range");
+      }
+    }
+  }
+  return mesh;
+}
+
+std::string Lowercase(std::string text) {
+  std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) {
+    return static_cast<char>(std::tolower(c));
+  });
+  return text;
+}
+}  // namespace
+
+std::expected<std::shared_ptr<const objects::Mesh>, std::string> LoadMesh(
+    const std::filesystem::path& path, const math::BVHBuildOptions& options,
+    MeshLoadStats* stats) {
+  const auto start = std::chrono::steady_clock::now();
+
+  const auto extension = Lowercase(path.extension().string());
+  if (extension != ".obj" && extension != ".ply") {
+    return std::unexpected(path.string() + ": unknown mesh format");
+  }
+
+  util::MappedFile file;
+  if (!file.Open(path)) {
+    return std::unexpected("cannot open " + path.string());
+  }
+  const auto bytes = file.Bytes();
+  auto data = extension == ".obj"
+                  ? ReadObj({reinterpret_cast<const char*>(bytes.data()),
+                             bytes.size()})
+                  : ReadPly(bytes);
+  if (!data) {
+    return std::unexpected(path.string() + ", " + data.error());
+  }
+  if (data->triangles.empty()) {
+    return std::unexpected(path.string() + " has no triangles");
+  }
+  file.Close();
+
+  const auto read_end = std::chrono::steady_clock::now();
+  auto mesh = std::make_shared<const objects::Mesh>(
+      std::move(data->vertices), std::move(data->triangles), options);
+
+  if (stats != nullptr) {
+    stats->bytes = bytes.size();
+    stats->read_ms =
+        std::chrono::duration<double, std::milli>(read_end - start).count();
+    stats->build_ms = std::chrono::duration<double, std::milli>(
+                          std::chrono::steady_clock::now() - read_end)
+                          .count();
+  }
+  return mesh;
+}
+
+}  // namespace polaris::scene
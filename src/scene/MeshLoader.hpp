@@ -0,0 +1,35 @@
+#ifndef POLARIS_SCENE_MESH_LOADER_HPP
+#define POLARIS_SCENE_MESH_LOADER_HPP
+
+#include <cstddef>
+#include <expected>
+#include <filesystem>
+#include <math/FlatBVH.hpp>
+#include <memory>
+#include <scene/objects/TriangleMesh.hpp>
+#include <string>
+
+// Mesh files. Wavefront OBJ (`v` and `f` lines; polygons are split into
+// fans, negative indices count back from the last vertex, anything else is
+// skipped) and PLY (ascii or binary of either byte order, with `vertex`
+// x/y/z and `face` vertex_indices). The file is mapped and parsed in place,
+// OBJ text in parallel chunks, so no copy of it is ever made.
+
+namespace polaris::scene {
+
+struct MeshLoadStats {
+  double read_ms = 0.0;   // Mapping and parsing the file
+  double build_ms = 0.0;  // The mesh's BVH
+  std::size_t bytes = 0;
+};
+
+// Loads the OBJ or PLY mesh at `path`, chosen by extension, and builds its
+// BVH with `options`
+[[nodiscard]] std::expected<std::shared_ptr<const objects::Mesh>, std::string>
+LoadMesh(const std::filesystem::path& path,
+         const math::BVHBuildOptions& options = {},
+         MeshLoadStats* stats = nullptr);
+
+}  // namespace polaris::scene
+
+#endif
@@ -0,0 +1,359 @@
+#include <cmath>
+#include <math/simd/PacketKernels.hpp>
+#include <scene/PrimitiveStore.hpp>
+#include <scene/objects/Instance.hpp>
+#include <scene/objects/Quad.hpp>
+#include <scene/objects/Sphere.hpp>
+#include <utility>
+
+namespace polaris::scene {
+namespace {
+template <typename T>
+std::size_t CapacityBytes(const std::vector<T>& v) {
+  return v.capacity() * sizeof(T);
+}
+}  // namespace
+
+void PrimitiveStore::AddSphere(const math::Vec3& centre,
+                               const math::Vec3& velocity, math::Real radius,
+                               std::uint32_t material) {
+  references_.push_back(static_cast<std::uint32_t>(radius_.size()) |
+                        kSphereKind);
+  centre_.push_back(centre);
+  velocity_.push_back(velocity);
+  radius_.push_back(std::fmax(0, radius));
+  sphere_material_.push_back(material);
+  bb_ = math::AABB(bb_, Bounds(references_.size() - 1));
+}
+
+void PrimitiveStore::AddQuad(const math::Vec3& q, const math::Vec3& u,
+                             const math::Vec3& v, std::uint32_t material) {
+  references_.push_back(static_cast<std::uint32_t>(q_.size()) | kQuadKind);
+  const auto n = u.Cross(v);
+  q_.push_back(q);
+  u_.push_back(u);
+  v_.push_back(v);
+  normal_.push_back(n.Normalized());
+  d_.push_back(normal_.back().Dot(q));
+  w_.push_back(n / n.Dot(n));
+  quad_material_.push_back(material);
+  bb_ = math::AABB(bb_, Bounds(references_.size() - 1));
+}
+
+void PrimitiveStore::AddObject(std::shared_ptr<Hittable> object) {
+  references_.push_back(static_cast<std::uint32_t>(objects_.size()) |
+                        kObjectKind);
+  bb_ = math::AABB(bb_, object->GetBounds());
+  objects_.push_back(std::move(object));
+}
+
+std::uint32_t PrimitiveStore::AddInstanced(
+    std::shared_ptr<const Hittable> object) {
+  instanced_.push_back(std::move(object));
+  return static_cast<std::uint32_t>(instanced_.size() - 1);
+}
+
+void PrimitiveStore::AddInstance(std::uint32_t object,
+                                 const math::Transform& to_world) {
+  references_.push_back(static_cast<std::uint32_t>(to_object_.size()) |
+                        kInstanceKind);
+  to_object_.push_back(to_world.Inverse());
+  instance_object_.push_back(object);
+  bb_ = math::AABB(bb_, Bounds(references_.size() - 1));
+}
+
+PrimitiveStore PrimitiveStore::Reordered(
+    std::span<const std::uint32_t> order) const {
+  PrimitiveStore result;
+  result.bb_ = bb_;
+  result.references_.reserve(order.size());
+  result.centre_.reserve(centre_.size());
+  result.velocity_.reserve(velocity_.size());
+  result.radius_.reserve(radius_.size());
+  result.sphere_material_.reserve(sphere_material_.size());
+  result.q_.reserve(q_.size());
+  result.u_.reserve(u_.size());
+  result.v_.reserve(v_.size());
+  result.w_.reserve(w_.size());
+  result.normal_.reserve(normal_.size());
+  result.d_.reserve(d_.size());
+  result.quad_material_.reserve(quad_material_.size());
+  result.objects_.reserve(objects_.size());
+  result.to_object_.reserve(to_object_.size());
+  result.instance_object_.reserve(instance_object_.size());
+  result.instanced_ = instanced_;
+
+  for (const auto position : order) {
+    const auto reference = references_[position];
+    const auto index = reference & kIndexMask;
+    switch (reference & kKindMask) {
+      case kSphereKind:
+        result.references_.push_back(
+            static_cast<std::uint32_t>(result.radius_.size()) | kSphereKind);
+        result.centre_.push_back(centre_[index]);
+        result.velocity_.push_back(velocity_[index]);
+        result.radius_.push_back(radius_[index]);
+        result.sphere_material_.push_back(sphere_material_[index]);
+        break;
+      case kQuadKind:
+        result.references_.push_back(
+            static_cast<std::uint32_t>(result.q_.size()) | kQuadKind);
+        result.q_.push_back(q_[index]);
+        result.u_.push_back(u_[index]);
+        result.v_.push_back(v_[index]);
+        result.w_.push_back(w_[index]);
+        result.normal_.push_back(normal_[index]);
+        result.d_.push_back(d_[index]);
+        result.quad_material_.push_back(quad_material_[index]);
+        break;
+      case kInstanceKind:
+        result.references_.push_back(
+            static_cast<std::uint32_t>(result.to_object_.size()) |
+            kInstanceKind);
+        result.to_object_.push_back(to_object_[index]);
+        result.instance_object_.push_back(instance_object_[index]);
+        break;
+      default:
+        result.references_.push_back(
+            static_cast<std::uint32_t>(result.objects_.size()) | kObjectKind);
+        result.objects_.push_back(objects_[index]);
+        break;
+    }
+  }
+  return result;
+}
+
+// Same bounds as objects::Sphere and objects::Quad give
+math::AABB PrimitiveStore::Bounds(std::size_t position) const {
+  const auto reference = references_[position];
+  const auto index = reference & kIndexMask;
+  switch (reference & kKindMask) {
+    case kSphereKind: {
+      const auto& centre = centre_[index];
+      const auto end = centre + velocity_[index];
+      const auto radius = radius_[index];
+      const math::Vec3 r(radius, radius, radius);
+      return {math::AABB(centre - r, centre + r), math::AABB(end - r, end + r)};
+    }
+    case kQuadKind: {
+      const auto& q = q_[index];
+      const auto& u = u_[index];
+      const auto& v = v_[index];
+      return {math::AABB(q, q + u + v), math::AABB(q + u, q + v)};
+    }
+    case kInstanceKind:
+      return to_object_[index].Inverse().Bounds(
+          instanced_[instance_object_[index]]->GetBounds());
+    default:
+      return objects_[index]->GetBounds();
+  }
+}
+
+bool PrimitiveStore::HitRange(std::size_t first, std::size_t count,
+                              const math::Ray& r, math::Real t_min,
+                              math::Real& closest_so_far,
+                              HitInfo& rec) const {
+  bool hit_anything = false;
+  for (auto i = first; i < first + count; ++i) {
+    const auto reference = references_[i];
+    const auto index = reference & kIndexMask;
+    const math::Interval t_interval(t_min, closest_so_far);
+
+    bool hit = false;
+    switch (reference & kKindMask) {
+      case kSphereKind:
+        hit = HitSphere(index, r, t_interval, rec);
+        break;
+      case kQuadKind:
+        hit = HitQuad(index, r, t_interval, rec);
+        break;
+      case kInstanceKind:
+        hit = HitInstance(index, r, t_interval, rec);
+        break;
+      default:
+        hit = objects_[index]->Hit(r, t_interval, rec);
+        break;
+    }
+    if (hit) {
+      hit_anything = true;
+      closest_so_far = rec.t_;
+    }
+  }
+  return hit_anything;
+}
+
+int PrimitiveStore::HitRangePacket(std::size_t first, std::size_t count,
+                                   const math::RayPacket& packet, int mask,
+                                   double t_min, PacketDistances& t_max,
+                                   PacketHitInfo& rec) const {
+  int hits = 0;
+  for (auto i = first; i < first + count; ++i) {
+    const auto reference = references_[i];
+    const auto index = reference & kIndexMask;
+    switch (reference & kKindMask) {
+      case kSphereKind:
+        hits |= HitSpherePacket(index, packet, mask, t_min, t_max, rec);
+        break;
+      case kQuadKind:
+        hits |= HitQuadPacket(index, packet, mask, t_min, t_max, rec);
+        break;
+      case kInstanceKind:
+        hits |= HitInstancePacket(index, packet, mask, t_min, t_max, rec);
+        break;
+      default:
+        hits |= objects_[index]->HitPacket(packet, mask, t_min, t_max, rec);
+        break;
+    }
+  }
+  return hits;
+}
+
+std::size_t PrimitiveStore::MemoryBytes() const {
+  return CapacityBytes(references_) + CapacityBytes(centre_) +
+         CapacityBytes(velocity_) + CapacityBytes(radius_) +
+         CapacityBytes(sphere_material_) + CapacityBytes(q_) +
+         CapacityBytes(u_) + CapacityBytes(v_) +
+         CapacityBytes(w_) + CapacityBytes(normal_) + CapacityBytes(d_) +
+         CapacityBytes(quad_material_) + CapacityBytes(objects_) +
+         CapacityBytes(to_object_) + CapacityBytes(instance_object_) +
+         CapacityBytes(instanced_);
+}
+
+bool PrimitiveStore::HitSphere(std::uint32_t index, const math::Ray& r,
+                               const math::Interval& t_interval,
+                               HitInfo& rec) const {
+  const auto centre = centre_[index] + (r.Time() * velocity_[index]);
+  math::Real t = 0;
+  if (!objects::Sphere::Intersect(centre, radius_[index], r, t_interval, t)) {
+    return false;
+  }
+  objects::Sphere::FillHitInfo(centre, radius_[index], r, t, rec);
+  rec.material_ = sphere_material_[index];
+  return true;
+}
+
+bool PrimitiveStore::HitQuad(std::uint32_t index, const math::Ray& r,
+                             const math::Interval& t_interval,
+                             HitInfo& rec) const {
+  math::Real t = 0;
+  math::Real alpha = 0;
+  math::Real beta = 0;
+  const math::Interval unit_interval(0, 1);
+  if (!objects::Quad::HitPlane(q_[index], u_[index], v_[index], w_[index],
+                               normal_[index], d_[index], r, t_interval, t,
+                               alpha, beta) ||
+      !unit_interval.Contains(alpha) || !unit_interval.Contains(beta)) {
+    return false;
+  }
+  rec.u_ = alpha;
+  rec.v_ = beta;
+  rec.t_ = t;
+  rec.point_ = r.at(t);
+  rec.material_ = quad_material_[index];
+  rec.uv_density_ = objects::Quad::UvDensity(w_[index]);
+  rec.SetNormal(r, normal_[index]);
+  return true;
+}
+
+int PrimitiveStore::HitSpherePacket(std::uint32_t index,
+                                    const math::RayPacket& packet, int mask,
+                                    double t_min, PacketDistances& t_max,
+                                    PacketHitInfo& rec) const {
+  math::simd::SphereParams params{};
+  for (std::size_t a = 0; a < 3; ++a) {
+    params.center[a] = centre_[index][a];
+    params.velocity[a] = velocity_[index][a];
+  }
+  params.radius = radius_[index];
+
+  PacketDistances t{};
+  const int hits = math::simd::GetPacketKernels().sphere(
+      packet.Lanes(), params, t_min, t_max.data(), mask, t.data());
+  for (int lane = 0; lane < math::RayPacket::kWidth; ++lane) {
+    if ((hits & (1 << lane)) != 0) {
+      const auto& r = packet[lane];
+      t_max[lane] = t[lane];
+      objects::Sphere::FillHitInfo(
+          centre_[index] + (r.Time() * velocity_[index]), radius_[index], r,
+          t[lane], rec[lane]);
+      rec[lane].material_ = sphere_material_[index];
+    }
+  }
+  return hits;
+}
+
+int PrimitiveStore::HitQuadPacket(std::uint32_t index,
+                                  const math::RayPacket& packet, int mask,
+                                  double t_min, PacketDistances& t_max,
+                                  PacketHitInfo& rec) const {
+  math::simd::QuadParams params{};
+  for (std::size_t a = 0; a < 3; ++a) {
+    params.q[a] = q_[index][a];
+    params.u[a] = u_[index][a];
+    params.v[a] = v_[index][a];
+    params.w[a] = w_[index][a];
+    params.normal[a] = normal_[index][a];
+  }
+  params.d = d_[index];
+
+  PacketDistances t{};
+  PacketDistances alpha{};
+  PacketDistances beta{};
+  const int hits = math::simd::GetPacketKernels().quad(
+      packet.Lanes(), params, t_min, t_max.data(), mask, t.data(),
+      alpha.data(), beta.data());
+  for (int lane = 0; lane < math::RayPacket::kWidth; ++lane) {
+    if ((hits & (1 << lane)) != 0) {
+      const auto& r = packet[lane];
+      t_max[lane] = t[lane];
+      rec[lane].t_ = t[lane];
+      rec[lane].point_ = r.at(t[lane]);
+      rec[lane].u_ = alpha[lane];
+      rec[lane].v_ = beta[lane];
+      rec[lane].material_ = quad_material_[index];
+      rec[lane].uv_density_ = objects::Quad::UvDensity(w_[index]);
+      rec[lane].SetNormal(r, normal_[index]);
+    }
+  }
+  return hits;
+}
+
+// Same as objects::Instance, which keeps the inverse it needs separately
+bool PrimitiveStore::HitInstance(std::uint32_t index, const math::Ray& r,
+                                 const math::Interval& t_interval,
+                                 HitInfo& rec) const {
+  const auto& to_object = to_object_[index];
+  if (!instanced_[instance_object_[index]]->Hit(to_object(r), t_interval,
+                                                rec)) {
+    return false;
+  }
+  objects::Instance::ToWorld(to_object.Inverse(), r, rec);
+  return true;
+}
+
+int PrimitiveStore::HitInstancePacket(std::uint32_t index,
+                                      const math::RayPacket& packet, int mask,
+                                      double t_min, PacketDistances& t_max,
+                                      PacketHitInfo& rec) const {
+  const auto& to_object = to_object_[index];
+  math::RayPacket local;
+  for (int lane = 0; lane < math::RayPacket::kWidth; ++lane) {
+    if ((mask & (1 << lane)) != 0) {
+      local.Set(lane, to_object(packet[lane]));
+    }
+  }
+
+  const int hits = instanced_[instance_object_[index]]->HitPacket(
+      local, mask, t_min, t_max, rec);
+  if (hits != 0) {
+    const auto to_world = to_object.Inverse();
+    for (int lane = 0; lane < math::RayPacket::kWidth; ++lane) {
+      if ((hits & (1 << lane)) != 0) {
+        objects::Instance::ToWorld(to_world, packet[lane], rec[lane]);
+      }
+    }
+  }
+  return hits;
+}
+
+}  // namespace polaris::scene
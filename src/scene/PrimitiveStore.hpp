@@ -0,0 +1,136 @@
+#ifndef POLARIS_SCENE_PRIMITIVE_STORE_HPP
+#define POLARIS_SCENE_PRIMITIVE_STORE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <math/AABB.hpp>
+#include <math/Common.hpp>
+#include <math/Interval.hpp>
+#include <math/Ray.hpp>
+#include <math/RayPacket.hpp>
+#include <math/Transform.hpp>
+#include <math/Vec.hpp>
+#include <memory>
+#include <scene/Hittable.hpp>
+#include <span>
+#include <vector>
+
+namespace polaris::scene {
+
+// Primitives kept by type in structure-of-arrays form. Spheres and quads are
+// plain records in one array per field, naming their material by its index
+// in the scene's MaterialTable, so each costs a few dozen bytes and no
+// allocation of its own. Instances are records too, naming the shared object
+// they place by index. Anything else, such as meshes, is kept as an
+// object. A position in the store refers to one primitive of any
+// type; accelerators reorder the store so each leaf covers a run of
+// positions.
+class PrimitiveStore {
+ public:
+  // Top bits of a reference, naming the arrays its index is into
+  static constexpr std::uint32_t kSphereKind = 0;
+  static constexpr std::uint32_t kQuadKind = 1U << 30;
+  static constexpr std::uint32_t kObjectKind = 2U << 30;
+  static constexpr std::uint32_t kInstanceKind = 3U << 30;
+  static constexpr std::uint32_t kKindMask = 3U << 30;
+  static constexpr std::uint32_t kIndexMask = ~kKindMask;
+
+  // Sphere moving from `centre` at time 0 by `velocity` per unit of time
+  void AddSphere(const math::Vec3& centre, const math::Vec3& velocity,
+                 math::Real radius, std::uint32_t material);
+  void AddQuad(const math::Vec3& q, const math::Vec3& u, const math::Vec3& v,
+               std::uint32_t material);
+  void AddObject(std::shared_ptr<Hittable> object);
+
+  // Makes `object` available to instances; returns the index AddInstance()
+  // takes for it
+  std::uint32_t AddInstanced(std::shared_ptr<const Hittable> object);
+  // Places the object AddInstanced() returned `object` for in the world
+  void AddInstance(std::uint32_t object, const math::Transform& to_world);
+
+  // Copy holding the primitive at order[i] at position i. Primitives of one
+  // type stay in their own arrays, in the order they appear in `order`.
+  [[nodiscard]] PrimitiveStore Reordered(
+      std::span<const std::uint32_t> order) const;
+
+  void Clear() { *this = {}; }
+
+  [[nodiscard]] math::AABB Bounds(std::size_t position) const;
+  [[nodiscard]] math::AABB GetBounds() const { return bb_; }
+
+  // Closest hit among the primitives at [first, first + count). Follows the
+  // contract of Hittable::Hit(), lowering `closest_so_far` on a hit.
+  [[nodiscard]] bool HitRange(std::size_t first, std::size_t count,
+                              const math::Ray& r, math::Real t_min,
+                              math::Real& closest_so_far, HitInfo& rec) const;
+
+  // Packet counterpart of HitRange(), following Hittable::HitPacket()
+  [[nodiscard]] int HitRangePacket(std::size_t first, std::size_t count,
+                                   const math::RayPacket& packet, int mask,
+                                   double t_min, PacketDistances& t_max,
+                                   PacketHitInfo& rec) const;
+
+  [[nodiscard]] std::size_t Size() const { return references_.size(); }
+  [[nodiscard]] bool Empty() const { return references_.empty(); }
+  [[nodiscard]] std::size_t SphereCount() const { return radius_.size(); }
+  [[nodiscard]] std::size_t QuadCount() const { return q_.size(); }
+  [[nodiscard]] std::size_t ObjectCount() const { return objects_.size(); }
+  [[nodiscard]] std::size_t InstanceCount() const {
+    return instance_object_.size();
+  }
+
+  // Bytes held by the store's own arrays. Objects count as their pointers,
+  // as what they hold (mesh buffers, shared groups) is not per primitive.
+  [[nodiscard]] std::size_t MemoryBytes() const;
+
+ private:
+  [[nodiscard]] bool HitSphere(std::uint32_t index, const math::Ray& r,
+                               const math::Interval& t_interval,
+                               HitInfo& rec) const;
+  [[nodiscard]] bool HitQuad(std::uint32_t index, const math::Ray& r,
+                             const math::Interval& t_interval,
+                             HitInfo& rec) const;
+  [[nodiscard]] int HitSpherePacket(std::uint32_t index,
+                                    const math::RayPacket& packet, int mask,
+                                    double t_min, PacketDistances& t_max,
+                                    PacketHitInfo& rec) const;
+  [[nodiscard]] int HitQuadPacket(std::uint32_t index,
+                                  const math::RayPacket& packet, int mask,
+                                  double t_min, PacketDistances& t_max,
+                                  PacketHitInfo& rec) const;
+  [[nodiscard]] bool HitInstance(std::uint32_t index, const math::Ray& r,
+                                 const math::Interval& t_interval,
+                                 HitInfo& rec) const;
+  [[nodiscard]] int HitInstancePacket(std::uint32_t index,
+                                      const math::RayPacket& packet, int mask,
+                                      double t_min, PacketDistances& t_max,
+                                      PacketHitInfo& rec) const;
+
+  std::vector<std::uint32_t> references_;  // Kind and index, per position
+  math::AABB bb_;
+
+  std::vector<math::Vec3> centre_;
+  std::vector<math::Vec3> velocity_;
+  std::vector<math::Real> radius_;
+  std::vector<std::uint32_t> sphere_material_;
+
+  // Plane terms as objects::Quad derives them
+  std::vector<math::Vec3> q_;
+  std::vector<math::Vec3> u_;
+  std::vector<math::Vec3> v_;
+  std::vector<math::Vec3> w_;
+  std::vector<math::Vec3> normal_;
+  std::vector<math::Real> d_;
+  std::vector<std::uint32_t> quad_material_;
+
+  std::vector<std::shared_ptr<Hittable>> objects_;
+
+  // Only the map into object space is kept; its inverse maps hits back
+  std::vector<math::Transform> to_object_;
+  std::vector<std::uint32_t> instance_object_;  // Index into instanced_
+  std::vector<std::shared_ptr<const Hittable>> instanced_;
+};
+
+}  // namespace polaris::scene
+
+#endif
@@ -0,0 +1,1018 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <math/Random.hpp>
+#include <scene/SceneCache.hpp>
+#include <scene/objects/Instance.hpp>
+#include <scene/objects/Quad.hpp>
+#include <scene/objects/Sphere.hpp>
+#include <system_error>
+#include <type_traits>
+
+namespace polaris::scene {
+namespace {
+constexpr std::array<char, 4> kCacheMagic{'P', 'L', 'S', 'C'};
+constexpr std::uint32_t kCacheVersion = 10;
+
+// Sections start on cache line boundaries, which also satisfies the
+// alignment of every record type
+constexpr std::size_t kSectionAlignment = 64;
+
+struct Section {
+  std::uint64_t offset = 0;
+  std::uint64_t count = 0;
+};
+
+struct CacheHeader {
+  std::array<char, 4> magic = kCacheMagic;
+  std::uint32_t version = kCacheVersion;
+  std::uint32_t header_size = sizeof(CacheHeader);
+  std::uint32_t real_size = sizeof(math::Real);
+  std::uint64_t source_hash = 0;
+
+  CameraSettings settings;
+  math::Vec3 look_from;
+  math::Vec3 look_at;
+  std::uint64_t line_count = 0;
+  std::uint64_t triangle_count = 0;  // Over all placed meshes
+  std::uint64_t instance_count = 0;
+  std::uint64_t texture_cache_bytes = 0;
+
+  Section textures;    // CachedTexture
+  Section materials;   // CachedMaterial
+  Section strings;         // Image and mesh paths
+  Section dependencies;    // CachedDependency
+  Section nodes;           // math::FlatBVHNode
+  Section primitives;      // Leaf order references
+  Section spheres;         // CachedSphere
+  Section quads;           // CachedQuad
+  Section meshes;          // CachedMesh
+  Section mesh_nodes;      // math::FlatBVHNode
+  Section mesh_vertices;   // math::Vec3
+  Section mesh_triangles;  // objects::MeshTriangle
+  Section groups;          // CachedGroup
+  Section group_nodes;     // math::FlatBVHNode
+  Section group_primitives;  // References in leaf order
+  Section instances;       // CachedInstance
+
+  std::uint64_t header_hash = 0;  // HeaderHash() of the fields above
+};
+
+struct CachedTexture {
+  TextureDesc::Kind kind = TextureDesc::Kind::Solid;
+  image::TextureFilter filter = image::TextureFilter::Trilinear;
+  std::uint32_t even = 0;
+  std::uint32_t odd = 0;
+  double colour[3] = {};
+  double scale = 0.0;
+  std::uint64_t path_offset = 0;  // Into the string section
+  std::uint64_t path_size = 0;
+};
+
+// Node and reference ranges of a group's BVH in the group sections. Child
+// and leaf offsets in the nodes are relative to the start of the ranges.
+struct CachedGroup {
+  std::uint64_t first_node = 0;
+  std::uint64_t node_count = 0;
+  std::uint64_t first_primitive = 0;
+  std::uint64_t primitive_count = 0;
+};
+
+// File besides the scene text that the cache was made from
+struct CachedDependency {
+  std::uint64_t path_offset = 0;  // Into the string section
+  std::uint64_t path_size = 0;
+  std::uint64_t hash = 0;         // HashFileContent() of the file
+};
+
+struct CachedMaterial {
+  MaterialDesc::Kind kind = MaterialDesc::Kind::Lambertian;
+  std::uint32_t texture = MaterialDesc::kNoTexture;
+  double albedo[3] = {};
+  double parameter = 0.0;
+};
+
+static_assert(std::is_trivially_copyable_v<CacheHeader>);
+static_assert(std::is_trivially_copyable_v<CachedTexture>);
+static_assert(std::is_trivially_copyable_v<CachedMaterial>);
+static_assert(std::is_trivially_copyable_v<CachedSphere>);
+static_assert(std::is_trivially_copyable_v<CachedQuad>);
+static_assert(std::is_trivially_copyable_v<CachedMesh>);
+static_assert(std::is_trivially_copyable_v<CachedDependency>);
+static_assert(std::is_trivially_copyable_v<CachedGroup>);
+static_assert(std::is_trivially_copyable_v<CachedInstance>);
+static_assert(std::is_trivially_copyable_v<objects::MeshTriangle>);
+static_assert(std::is_trivially_copyable_v<math::FlatBVHNode>);
+
+constexpr std::size_t AlignSection(std::size_t offset) {
+  return (offset + kSectionAlignment - 1) & ~(kSectionAlignment - 1);
+}
+
+// Appends sections to the cache file, padding each to kSectionAlignment
+class CacheWriter {
+ public:
+  explicit CacheWriter(std::ofstream& out) : out_(out) {}
+
+  template <typename T>
+  Section Write(std::span<const T> records) {
+    return WriteRuns(std::span<const std::span<const T>>(&records, 1));
+  }
+
+  // Writes one section holding several runs of records back to back
+  template <typename T>
+  Section WriteRuns(std::span<const std::span<const T>> runs) {
+    static constexpr char kPadding[kSectionAlignment] = {};
+    const auto offset = AlignSection(size_);
+    out_.write(kPadding, static_cast<std::streamsize>(offset - size_));
+    size_ = offset;
+    std::size_t count = 0;
+    for (const auto& records : runs) {
+      out_.write(reinterpret_cast<const char*>(records.data()),
+                 static_cast<std::streamsize>(records.size_bytes()));
+      size_ += records.size_bytes();
+      count += records.size();
+    }
+    return {offset, count};
+  }
+
+ private:
+  std::ofstream& out_;
+  std::size_t size_ = sizeof(CacheHeader);
+};
+
+template <typename T>
+std::span<const T> ReadSection(std::span<const std::byte> file,
+                               const Section& section, bool& ok) {
+  if (section.offset % alignof(T) != 0 || section.offset > file.size() ||
+      section.count > (file.size() - section.offset) / sizeof(T)) {
+    ok = false;
+    return {};
+  }
+  return {reinterpret_cast<const T*>(file.data() + section.offset),
+          static_cast<std::size_t>(section.count)};
+}
+
+// Hash of the header's bytes up to header_hash, which is all the checking
+// the camera settings and the section table get
+std::uint64_t HeaderHash(std::span<const std::byte> header) {
+  return HashFileContent(header.first(offsetof(CacheHeader, header_hash)));
+}
+
+void ToArray(const image::PixelF64& pixel, double (&out)[3]) {
+  out[0] = pixel.R();
+  out[1] = pixel.G();
+  out[2] = pixel.B();
+}
+
+// Records of the primitives written so far, in the order they were added
+struct PrimitiveRecords {
+  std::vector<CachedSphere> spheres;
+  std::vector<CachedQuad> quads;
+  std::vector<CachedMesh> meshes;
+  std::vector<CachedInstance> instances;
+};
+
+// Same bounds as the object constructors give
+math::AABB PrimitiveBounds(const SceneDescription& desc,
+                           const PrimitiveDesc& primitive,
+                           std::span<const math::AABB> group_bounds) {
+  switch (primitive.kind) {
+    case PrimitiveDesc::Kind::Mesh:
+      return desc.meshes[primitive.index].mesh->GetBounds();
+    case PrimitiveDesc::Kind::Instance: {
+      const auto& instance = desc.instances[primitive.index];
+      return instance.to_world.Bounds(group_bounds[instance.group]);
+    }
+    case PrimitiveDesc::Kind::Quad: {
+      const auto& q = primitive.a;
+      const auto& u = primitive.b;
+      const auto& v = primitive.c;
+      return {math::AABB(q, q + u + v), math::AABB(q + u, q + v)};
+    }
+    case PrimitiveDesc::Kind::Sphere:
+    case PrimitiveDesc::Kind::MovingSphere:
+      break;
+  }
+  const auto end = primitive.kind == PrimitiveDesc::Kind::MovingSphere
+                       ? primitive.b
+                       : primitive.a;
+  const auto radius = primitive.radius;
+  const math::Vec3 r(radius, radius, radius);
+  return {math::AABB(primitive.a - r, primitive.a + r),
+          math::AABB(end - r, end + r)};
+}
+
+// Appends the record of `primitive` and returns its reference
+std::uint32_t AddRecord(const SceneDescription& desc,
+                        const PrimitiveDesc& primitive,
+                        std::span<const CachedMesh> mesh_ranges,
+                        PrimitiveRecords& records) {
+  const auto index = [](const auto& list) {
+    return static_cast<std::uint32_t>(list.size());
+  };
+
+  switch (primitive.kind) {
+    case PrimitiveDesc::Kind::Mesh: {
+      const auto reference = index(records.meshes) | CachedScene::kMeshKind;
+      auto& mesh = records.meshes.emplace_back(mesh_ranges[primitive.index]);
+      mesh.material = primitive.material;
+      return reference;
+    }
+    case PrimitiveDesc::Kind::Instance: {
+      const auto reference =
+          index(records.instances) | CachedScene::kInstanceKind;
+      const auto& instance = desc.instances[primitive.index];
+      records.instances.push_back(
+          {instance.to_world, instance.to_world.Inverse(), instance.group});
+      return reference;
+    }
+    case PrimitiveDesc::Kind::Quad: {
+      const auto reference = index(records.quads) | CachedScene::kQuadKind;
+      auto& quad = records.quads.emplace_back();
+      quad.q = primitive.a;
+      quad.u = primitive.b;
+      quad.v = primitive.c;
+      const auto n = quad.u.Cross(quad.v);
+      quad.normal = n.Normalized();
+      quad.d = quad.normal.Dot(quad.q);
+      quad.w = n / n.Dot(n);
+      quad.material = primitive.material;
+      return reference;
+    }
+    case PrimitiveDesc::Kind::Sphere:
+    case PrimitiveDesc::Kind::MovingSphere:
+      break;
+  }
+
+  const auto reference = index(records.spheres) | CachedScene::kSphereKind;
+  auto& sphere = records.spheres.emplace_back();
+  sphere.centre = primitive.a;
+  sphere.velocity = primitive.kind == PrimitiveDesc::Kind::MovingSphere
+                        ? primitive.b - primitive.a
+                        : math::Vec3(0, 0, 0);
+  sphere.radius = std::fmax(0, primitive.radius);
+  sphere.material = primitive.material;
+  return reference;
+}
+
+// Builds the BVH over `primitives`. Their records are appended in leaf
+// order, so each leaf reads a contiguous run of them.
+void BuildLevel(const SceneDescription& desc,
+                std::span<const PrimitiveDesc> primitives,
+                std::span<const math::AABB> group_bounds,
+                std::span<const CachedMesh> mesh_ranges,
+                const math::BVHBuildOptions& options,
+                PrimitiveRecords& records,
+                std::vector<math::FlatBVHNode>& nodes,
+                std::vector<std::uint32_t>& references) {
+  std::vector<math::AABB> bounds;
+  bounds.reserve(primitives.size());
+  for (const auto& primitive : primitives) {
+    bounds.push_back(PrimitiveBounds(desc, primitive, group_bounds));
+  }
+
+  std::vector<std::uint32_t> order;
+  math::BuildFlatBVH(bounds, nodes, order, options);
+  bounds = {};
+
+  references.reserve(order.size());
+  for (const auto index : order) {
+    references.push_back(
+        AddRecord(desc, primitives[index], mesh_ranges, records));
+  }
+}
+
+// Whether the file at `path` still hashes to `hash`
+bool IsUnchanged(const std::filesystem::path& path, std::uint64_t hash) {
+  util::MappedFile file;
+  return file.Open(path) && HashFileContent(file.Bytes()) == hash;
+}
+
+// Whether nodes[begin, end) hold one subtree in depth-first order, shallow
+// enough for the traversal stacks, whose leaves index `primitive_count`
+// references at most
+bool IsValidSubtree(std::span<const math::FlatBVHNode> nodes,
+                    std::size_t begin, std::size_t end,
+                    std::size_t primitive_count, int depth) {
+  const auto& node = nodes[begin];
+  if (node.IsLeaf()) {
+    return end == begin + 1 &&
+           std::size_t{node.offset_} + node.count_ <= primitive_count;
+  }
+  const std::size_t second = node.offset_;
+  return depth < math::kFlatBVHStackSize && node.axis_ < 3 &&
+         second > begin + 1 && second < end &&
+         IsValidSubtree(nodes, begin + 1, second, primitive_count,
+                        depth + 1) &&
+         IsValidSubtree(nodes, second, end, primitive_count, depth + 1);
+}
+
+bool IsValidTree(std::span<const math::FlatBVHNode> nodes,
+                 std::size_t primitive_count) {
+  return nodes.empty() ||
+         IsValidSubtree(nodes, 0, nodes.size(), primitive_count, 0);
+}
+
+// Whether the record a primitive reference names exists. Group BVHs may not
+// reference instances, which would let a cache nest groups.
+bool IsValidReference(std::uint32_t reference, std::size_t spheres,
+                      std::size_t quads, std::size_t meshes,
+                      std::size_t instances) {
+  const auto index = reference & CachedScene::kIndexMask;
+  switch (reference & CachedScene::kKindMask) {
+    case CachedScene::kSphereKind:
+      return index < spheres;
+    case CachedScene::kQuadKind:
+      return index < quads;
+    case CachedScene::kMeshKind:
+      return index < meshes;
+    default:
+      return index < instances;
+  }
+}
+}  // namespace
+
+std::uint64_t HashFileContent(std::span<const std::byte> bytes) {
+  const std::string_view text(reinterpret_cast<const char*>(bytes.data()),
+                              bytes.size());
+  // Four independent lanes keep several multiplies in flight at once
+  std::array<std::uint64_t, 4> lanes{1, 2, 3, 4};
+  std::size_t i = 0;
+  for (; i + 32 <= text.size(); i += 32) {
+    for (std::size_t lane = 0; lane < 4; ++lane) {
+      std::uint64_t word = 0;
+      std::memcpy(&word, text.data() + i + (8 * lane), 8);
+      lanes[lane] = math::MixBits(lanes[lane] ^ word);
+    }
+  }
+  for (std::size_t lane = 0; i < text.size(); i += 8, ++lane) {
+    std::uint64_t word = 0;
+    std::memcpy(&word, text.data() + i,
+                std::min<std::size_t>(8, text.size() - i));
+    lanes[lane] = math::MixBits(lanes[lane] ^ word);
+  }
+  return math::Hash(lanes[0], lanes[1], lanes[2], lanes[3],
+                    static_cast<std::uint64_t>(text.size()));
+}
+
+bool WriteSceneCache(const SceneDescription& desc, std::uint64_t source_hash,
+                     const std::filesystem::path& path,
+                     const math::BVHBuildOptions& options) {
+  // Cleared as a whole first, so the padding between fields reaches the
+  // file as zeros instead of whatever the stack held
+  CacheHeader header;
+  std::memset(static_cast<void*>(&header), 0, sizeof(header));
+  header.magic = kCacheMagic;
+  header.version = kCacheVersion;
+  header.header_size = sizeof(CacheHeader);
+  header.real_size = sizeof(math::Real);
+  header.source_hash = source_hash;
+  header.settings = desc.settings;
+  header.look_from = desc.look_from;
+  header.look_at = desc.look_at;
+  header.line_count = desc.line_count;
+  header.triangle_count = desc.triangle_count;
+  header.instance_count = desc.instance_count;
+  header.texture_cache_bytes = desc.texture_cache_bytes;
+
+  std::vector<CachedTexture> textures;
+  std::string strings;
+  std::vector<CachedDependency> dependencies;
+  textures.reserve(desc.textures.size());
+  for (const auto& texture : desc.textures) {
+    // Images are found once, while parsing, and stored by absolute path.
+    // One found nowhere might turn up from another working directory, so
+    // the scene is not cached then.
+    if (texture.kind == TextureDesc::Kind::Image &&
+        !std::filesystem::path(texture.path).is_absolute()) {
+      return false;
+    }
+    auto& cached = textures.emplace_back();
+    cached.kind = texture.kind;
+    cached.even = texture.even;
+    cached.odd = texture.odd;
+    cached.filter = texture.filter;
+    ToArray(texture.colour, cached.colour);
+    cached.scale = texture.scale;
+    cached.path_offset = strings.size();
+    cached.path_size = texture.path.size();
+    strings += texture.path;
+  }
+
+  // Meshes are stored once per file, and their files are hashed so a
+  // change to one makes the cache stale
+  std::vector<CachedMesh> mesh_ranges;
+  std::vector<std::span<const math::FlatBVHNode>> mesh_nodes;
+  std::vector<std::span<const math::Vec3>> mesh_vertices;
+  std::vector<std::span<const objects::MeshTriangle>> mesh_triangles;
+  CachedMesh next_range;
+  for (const auto& mesh : desc.meshes) {
+    util::MappedFile file;
+    if (!file.Open(mesh.path)) {
+      return false;
+    }
+    std::error_code ec;
+    const auto path = std::filesystem::absolute(mesh.path, ec).string();
+    if (ec) {
+      return false;
+    }
+    dependencies.push_back(
+        {strings.size(), path.size(), HashFileContent(file.Bytes())});
+    strings += path;
+
+    const auto view = mesh.mesh->View();
+    next_range.node_count = view.nodes.size();
+    next_range.vertex_count = view.vertices.size();
+    next_range.triangle_count = view.triangles.size();
+    mesh_ranges.push_back(next_range);
+    next_range.first_node += view.nodes.size();
+    next_range.first_vertex += view.vertices.size();
+    next_range.first_triangle += view.triangles.size();
+    mesh_nodes.push_back(view.nodes);
+    mesh_vertices.push_back(view.vertices);
+    mesh_triangles.push_back(view.triangles);
+  }
+
+  std::vector<CachedMaterial> materials;
+  materials.reserve(desc.materials.size());
+  for (const auto& material : desc.materials) {
+    auto& cached = materials.emplace_back();
+    cached.kind = material.kind;
+    cached.texture = material.texture;
+    ToArray(material.albedo, cached.albedo);
+    cached.parameter = material.parameter;
+  }
+
+  // Groups come first, as instances take their bounds from them
+  PrimitiveRecords records;
+  std::vector<CachedGroup> groups;
+  std::vector<math::FlatBVHNode> group_nodes;
+  std::vector<std::uint32_t> group_references;
+  std::vector<math::AABB> group_bounds;
+  for (const auto& group : desc.groups) {
+    std::vector<math::FlatBVHNode> nodes;
+    std::vector<std::uint32_t> references;
+    BuildLevel(desc, group, {}, mesh_ranges, options, records, nodes,
+               references);
+    groups.push_back({group_nodes.size(), nodes.size(),
+                      group_references.size(), references.size()});
+    group_bounds.push_back(nodes.front().bounds_);
+    group_nodes.insert(group_nodes.end(), nodes.begin(), nodes.end());
+    group_references.insert(group_references.end(), references.begin(),
+                            references.end());
+  }
+
+  std::vector<math::FlatBVHNode> nodes;
+  std::vector<std::uint32_t> references;
+  BuildLevel(desc, desc.primitives, group_bounds, mesh_ranges, options,
+             records, nodes, references);
+
+  // Written beside the target and renamed over it once complete
+  auto temp_path = path;
+  temp_path += ".tmp";
+  {
+    std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+      return false;
+    }
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    CacheWriter writer(out);
+    header.textures = writer.Write(std::span<const CachedTexture>(textures));
+    header.materials =
+        writer.Write(std::span<const CachedMaterial>(materials));
+    header.strings = writer.Write(std::span<const char>(strings));
+    header.dependencies =
+        writer.Write(std::span<const CachedDependency>(dependencies));
+    header.nodes = writer.Write(std::span<const math::FlatBVHNode>(nodes));
+    header.primitives =
+        writer.Write(std::span<const std::uint32_t>(references));
+    header.spheres =
+        writer.Write(std::span<const CachedSphere>(records.spheres));
+    header.quads = writer.Write(std::span<const CachedQuad>(records.quads));
+    header.meshes = writer.Write(std::span<const CachedMesh>(records.meshes));
+    header.groups = writer.Write(std::span<const CachedGroup>(groups));
+    header.group_nodes =
+        writer.Write(std::span<const math::FlatBVHNode>(group_nodes));
+    header.group_primitives =
+        writer.Write(std::span<const std::uint32_t>(group_references));
+    header.instances =
+        writer.Write(std::span<const CachedInstance>(records.instances));
+    header.mesh_nodes = writer.WriteRuns(
+        std::span<const std::span<const math::FlatBVHNode>>(mesh_nodes));
+    header.mesh_vertices = writer.WriteRuns(
+        std::span<const std::span<const math::Vec3>>(mesh_vertices));
+    header.mesh_triangles = writer.WriteRuns(
+        std::span<const std::span<const objects::MeshTriangle>>(
+            mesh_triangles));
+
+    // The header goes last, so a cache cut short never has valid sections
+    header.header_hash = HeaderHash(std::as_bytes(std::span(&header, 1)));
+    out.seekp(0);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    if (!out.flush()) {
+      return false;
+    }
+  }
+
+  std::error_code ec;
+  std::filesystem::rename(temp_path, path, ec);
+  if (ec) {
+    std::filesystem::remove(temp_path, ec);
+    return false;
+  }
+  return true;
+}
+
+std::shared_ptr<CachedScene> CachedScene::Open(
+    const std::filesystem::path& path, std::uint64_t source_hash) {
+  util::MappedFile file;
+  if (!file.Open(path)) {
+    return nullptr;
+  }
+
+  const auto bytes = file.Bytes();
+  CacheHeader header;
+  if (bytes.size() < sizeof(header)) {
+    return nullptr;
+  }
+  std::memcpy(&header, bytes.data(), sizeof(header));
+  if (header.magic != kCacheMagic || header.version != kCacheVersion ||
+      header.header_size != sizeof(CacheHeader) ||
+      header.real_size != sizeof(math::Real) ||
+      header.source_hash != source_hash ||
+      header.header_hash != HeaderHash(bytes)) {
+    return nullptr;
+  }
+
+  bool ok = true;
+  const auto textures = ReadSection<CachedTexture>(bytes, header.textures, ok);
+  const auto materials =
+      ReadSection<CachedMaterial>(bytes, header.materials, ok);
+  const auto strings = ReadSection<char>(bytes, header.strings, ok);
+  const auto dependencies =
+      ReadSection<CachedDependency>(bytes, header.dependencies, ok);
+  const auto mesh_nodes =
+      ReadSection<math::FlatBVHNode>(bytes, header.mesh_nodes, ok);
+  const auto mesh_vertices =
+      ReadSection<math::Vec3>(bytes, header.mesh_vertices, ok);
+  const auto mesh_triangles =
+      ReadSection<objects::MeshTriangle>(bytes, header.mesh_triangles, ok);
+
+  std::shared_ptr<CachedScene> scene(new CachedScene());
+  scene->nodes_ = ReadSection<math::FlatBVHNode>(bytes, header.nodes, ok);
+  scene->primitives_ =
+      ReadSection<std::uint32_t>(bytes, header.primitives, ok);
+  scene->spheres_ = ReadSection<CachedSphere>(bytes, header.spheres, ok);
+  scene->quads_ = ReadSection<CachedQuad>(bytes, header.quads, ok);
+  scene->meshes_ = ReadSection<CachedMesh>(bytes, header.meshes, ok);
+  scene->instances_ =
+      ReadSection<CachedInstance>(bytes, header.instances, ok);
+  const auto groups = ReadSection<CachedGroup>(bytes, header.groups, ok);
+  const auto group_nodes =
+      ReadSection<math::FlatBVHNode>(bytes, header.group_nodes, ok);
+  const auto group_primitives =
+      ReadSection<std::uint32_t>(bytes, header.group_primitives, ok);
+  if (!ok) {
+    return nullptr;
+  }
+
+  for (const auto& dependency : dependencies) {
+    if (dependency.path_offset > strings.size() ||
+        dependency.path_size > strings.size() - dependency.path_offset ||
+        !IsUnchanged(std::string_view(strings.data() + dependency.path_offset,
+                                      dependency.path_size),
+                     dependency.hash)) {
+      return nullptr;
+    }
+  }
+
+  // Every index the traversal follows is checked once here, so a damaged
+  // cache is rebuilt instead of read out of bounds
+  const auto material_count = materials.size();
+  const auto sphere_count = scene->spheres_.size();
+  const auto quad_count = scene->quads_.size();
+  const auto mesh_count = scene->meshes_.size();
+  const auto instance_count = scene->instances_.size();
+  if (!IsValidTree(scene->nodes_, scene->primitives_.size())) {
+    return nullptr;
+  }
+  for (const auto reference : scene->primitives_) {
+    if (!IsValidReference(reference, sphere_count, quad_count, mesh_count,
+                          instance_count)) {
+      return nullptr;
+    }
+  }
+  for (const auto& sphere : scene->spheres_) {
+    if (sphere.material >= material_count) {
+      return nullptr;
+    }
+  }
+  for (const auto& quad : scene->quads_) {
+    if (quad.material >= material_count) {
+      return nullptr;
+    }
+  }
+
+  scene->mesh_views_.reserve(mesh_count);
+  for (const auto& mesh : scene->meshes_) {
+    if (mesh.first_node > mesh_nodes.size() ||
+        mesh.node_count > mesh_nodes.size() - mesh.first_node ||
+        mesh.first_vertex > mesh_vertices.size() ||
+        mesh.vertex_count > mesh_vertices.size() - mesh.first_vertex ||
+        mesh.first_triangle > mesh_triangles.size() ||
+        mesh.triangle_count > mesh_triangles.size() - mesh.first_triangle ||
+        mesh.material >= material_count) {
+      return nullptr;
+    }
+    const objects::MeshView view{
+        mesh_nodes.subspan(mesh.first_node, mesh.node_count),
+        mesh_vertices.subspan(mesh.first_vertex, mesh.vertex_count),
+        mesh_triangles.subspan(mesh.first_triangle, mesh.triangle_count)};
+    if (!IsValidTree(view.nodes, view.triangles.size())) {
+      return nullptr;
+    }
+    for (const auto& triangle : view.triangles) {
+      for (const auto vertex : triangle) {
+        if (vertex >= view.vertices.size()) {
+          return nullptr;
+        }
+      }
+    }
+    scene->mesh_views_.push_back(view);
+  }
+
+  scene->groups_.reserve(groups.size());
+  for (const auto& group : groups) {
+    if (group.node_count == 0 || group.first_node > group_nodes.size() ||
+        group.node_count > group_nodes.size() - group.first_node ||
+        group.first_primitive > group_primitives.size() ||
+        group.primitive_count >
+            group_primitives.size() - group.first_primitive) {
+      return nullptr;
+    }
+    const Level level{
+        group_nodes.subspan(group.first_node, group.node_count),
+        group_primitives.subspan(group.first_primitive,
+                                 group.primitive_count)};
+    if (!IsValidTree(level.nodes, level.primitives.size())) {
+      return nullptr;
+    }
+    for (const auto reference : level.primitives) {
+      if (!IsValidReference(reference, sphere_count, quad_count, mesh_count,
+                            0)) {
+        return nullptr;
+      }
+    }
+    scene->groups_.push_back(level);
+  }
+  for (const auto& instance : scene->instances_) {
+    if (instance.group >= groups.size()) {
+      return nullptr;
+    }
+  }
+
+  for (std::size_t i = 0; i < textures.size(); ++i) {
+    // Checkers only combine textures declared before them
+    const auto& cached = textures[i];
+    if (cached.kind > TextureDesc::Kind::Image ||
+        cached.filter > image::TextureFilter::Trilinear ||
+        (cached.kind == TextureDesc::Kind::Checker &&
+         (cached.even >= i || cached.odd >= i)) ||
+        cached.path_offset > strings.size() ||
+        cached.path_size > strings.size() - cached.path_offset) {
+      return nullptr;
+    }
+  }
+  for (const auto& cached : materials) {
+    if (cached.kind > MaterialDesc::Kind::Dielectric ||
+        (cached.texture != MaterialDesc::kNoTexture &&
+         cached.texture >= textures.size())) {
+      return nullptr;
+    }
+  }
+
+  scene->settings_ = header.settings;
+  scene->look_from_ = header.look_from;
+  scene->look_at_ = header.look_at;
+  scene->line_count_ = header.line_count;
+  scene->triangle_count_ = header.triangle_count;
+  scene->instance_count_ = header.instance_count;
+  scene->texture_cache_bytes_ = header.texture_cache_bytes;
+
+  std::vector<TextureDesc> texture_descs;
+  texture_descs.reserve(textures.size());
+  for (const auto& cached : textures) {
+    auto& desc = texture_descs.emplace_back();
+    desc.kind = cached.kind;
+    desc.colour = image::PixelF64(cached.colour[0], cached.colour[1],
+                                  cached.colour[2]);
+    desc.scale = cached.scale;
+    desc.even = cached.even;
+    desc.odd = cached.odd;
+    desc.filter = cached.filter;
+    desc.path.assign(strings.data() + cached.path_offset, cached.path_size);
+  }
+  const auto start = std::chrono::steady_clock::now();
+  scene->textures_ =
+      MakeTextures(texture_descs, scene->texture_cache_bytes_,
+                   &scene->texture_loads_);
+  scene->texture_ms_ = std::chrono::duration<double, std::milli>(
+                           std::chrono::steady_clock::now() - start)
+                           .count();
+  for (const auto& cached : materials) {
+    MaterialDesc desc;
+    desc.kind = cached.kind;
+    desc.albedo = image::PixelF64(cached.albedo[0], cached.albedo[1],
+                                  cached.albedo[2]);
+    desc.texture = cached.texture;
+    desc.parameter = cached.parameter;
+    scene->materials_.Add(MakeMaterial(desc, scene->textures_));
+  }
+
+  scene->file_ = std::move(file);
+  return scene;
+}
+
+bool CachedScene::Hit(const math::Ray& r, const math::Interval& t_interval,
+                      HitInfo& rec) const {
+  return HitLevel({nodes_, primitives_}, r, t_interval, rec);
+}
+
+int CachedScene::HitPacket(const math::RayPacket& packet, int mask,
+                           double t_min, PacketDistances& t_max,
+                           PacketHitInfo& rec) const {
+  return HitLevelPacket({nodes_, primitives_}, packet, mask, t_min, t_max,
+                        rec);
+}
+
+math::AABB CachedScene::GetBounds() const {
+  return nodes_.empty() ? math::AABB() : nodes_.front().bounds_;
+}
+
+std::size_t CachedScene::PrimitiveBytes() const {
+  std::size_t bytes = primitives_.size_bytes() + spheres_.size_bytes() +
+                      quads_.size_bytes() + meshes_.size_bytes() +
+                      instances_.size_bytes();
+  for (const auto& group : groups_) {
+    bytes += group.primitives.size_bytes();
+  }
+  return bytes;
+}
+
+bool CachedScene::HitLevel(const Level& level, const math::Ray& r,
+                           const math::Interval& t_interval,
+                           HitInfo& rec) const {
+  return math::TraverseFlatBVH(
+      level.nodes, r, t_interval,
+      [&](std::uint32_t first, std::uint32_t count, math::Real t_min,
+          math::Real& closest_so_far) {
+        bool hit_anything = false;
+        for (auto i = first; i < first + count; ++i) {
+          if (HitPrimitive(level.primitives[i], r,
+                           math::Interval(t_min, closest_so_far), rec)) {
+            hit_anything = true;
+            closest_so_far = rec.t_;
+          }
+        }
+        return hit_anything;
+      });
+}
+
+int CachedScene::HitLevelPacket(const Level& level,
+                                const math::RayPacket& packet, int mask,
+                                double t_min, PacketDistances& t_max,
+                                PacketHitInfo& rec) const {
+  return math::TraverseFlatBVHPacket(
+      level.nodes, packet, mask, t_min, t_max,
+      [&](std::uint32_t first, std::uint32_t count, int lanes) {
+        int hits = 0;
+        for (auto i = first; i < first + count; ++i) {
+          hits |= HitPrimitivePacket(level.primitives[i], packet, lanes,
+                                     t_min, t_max, rec);
+        }
+        return hits;
+      });
+}
+
+bool CachedScene::HitPrimitive(std::uint32_t primitive, const math::Ray& r,
+                               const math::Interval& t_interval,
+                               HitInfo& rec) const {
+  const auto index = primitive & kIndexMask;
+  const auto kind = primitive & kKindMask;
+  if (kind == kMeshKind) {
+    if (!objects::TriangleMesh::HitView(mesh_views_[index], r, t_interval,
+                                        rec)) {
+      return false;
+    }
+    rec.material_ = meshes_[index].material;
+    return true;
+  }
+  if (kind == kInstanceKind) {
+    const auto& instance = instances_[index];
+    if (!HitLevel(groups_[instance.group], instance.to_object(r), t_interval,
+                  rec)) {
+      return false;
+    }
+    objects::Instance::ToWorld(instance.to_world, r, rec);
+    return true;
+  }
+
+  math::Real t = 0;
+  if (kind == kSphereKind) {
+    const auto& sphere = spheres_[index];
+    const auto centre = sphere.centre + (r.Time() * sphere.velocity);
+    if (!objects::Sphere::Intersect(centre, sphere.radius, r, t_interval, t)) {
+      return false;
+    }
+    objects::Sphere::FillHitInfo(centre, sphere.radius, r, t, rec);
+    rec.material_ = sphere.material;
+    return true;
+  }
+
+  const auto& quad = quads_[index];
+  math::Real alpha = 0;
+  math::Real beta = 0;
+  const math::Interval unit_interval(0, 1);
+  if (!objects::Quad::HitPlane(quad.q, quad.u, quad.v, quad.w, quad.normal,
+                               quad.d, r, t_interval, t, alpha, beta) ||
+      !unit_interval.Contains(alpha) || !unit_interval.Contains(beta)) {
+    return false;
+  }
+  rec.u_ = alpha;
+  rec.v_ = beta;
+  rec.t_ = t;
+  rec.point_ = r.at(t);
+  rec.material_ = quad.material;
+  rec.uv_density_ = objects::Quad::UvDensity(quad.w);
+  rec.SetNormal(r, quad.normal);
+  return true;
+}
+
+int CachedScene::HitPrimitivePacket(std::uint32_t primitive,
+                                    const math::RayPacket& packet, int mask,
+                                    double t_min, PacketDistances& t_max,
+                                    PacketHitInfo& rec) const {
+  const auto index = primitive & kIndexMask;
+  const auto kind = primitive & kKindMask;
+  if (kind == kMeshKind) {
+    const int hits = objects::TriangleMesh::HitViewPacket(
+        mesh_views_[index], packet, mask, t_min, t_max, rec);
+    for (int lane = 0; lane < math::RayPacket::kWidth; ++lane) {
+      if ((hits & (1 << lane)) != 0) {
+        rec[lane].material_ = meshes_[index].material;
+      }
+    }
+    return hits;
+  }
+  if (kind == kInstanceKind) {
+    const auto& instance = instances_[index];
+    math::RayPacket local;
+    for (int lane = 0; lane < math::RayPacket::kWidth; ++lane) {
+      if ((mask & (1 << lane)) != 0) {
+        local.Set(lane, instance.to_object(packet[lane]));
+      }
+    }
+    const int hits = HitLevelPacket(groups_[instance.group], local, mask,
+                                    t_min, t_max, rec);
+    for (int lane = 0; lane < math::RayPacket::kWidth; ++lane) {
+      if ((hits & (1 << lane)) != 0) {
+        objects::Instance::ToWorld(instance.to_world, packet[lane],
+                                   rec[lane]);
+      }
+    }
+    return hits;
+  }
+
+  const auto& kernels = math::simd::GetPacketKernels();
+  PacketDistances t{};
+
+  if (kind == kSphereKind) {
+    const auto& sphere = spheres_[index];
+    math::simd::SphereParams params{};
+    for (std::size_t a = 0; a < 3; ++a) {
+      params.center[a] = sphere.centre[a];
+      params.velocity[a] = sphere.velocity[a];
+    }
+    params.radius = sphere.radius;
+
+    const int hits = kernels.sphere(packet.Lanes(), params, t_min,
+                                    t_max.data(), mask, t.data());
+    for (int lane = 0; lane < math::RayPacket::kWidth; ++lane) {
+      if ((hits & (1 << lane)) != 0) {
+        const auto& r = packet[lane];
+        t_max[lane] = t[lane];
+        objects::Sphere::FillHitInfo(
+            sphere.centre + (r.Time() * sphere.velocity), sphere.radius, r,
+            t[lane], rec[lane]);
+        rec[lane].material_ = sphere.material;
+      }
+    }
+    return hits;
+  }
+
+  const auto& quad = quads_[index];
+  math::simd::QuadParams params{};
+  for (std::size_t a = 0; a < 3; ++a) {
+    params.q[a] = quad.q[a];
+    params.u[a] = quad.u[a];
+    params.v[a] = quad.v[a];
+    params.w[a] = quad.w[a];
+    params.normal[a] = quad.normal[a];
+  }
+  params.d = quad.d;
+
+  PacketDistances alpha{};
+  PacketDistances beta{};
+  const int hits =
+      kernels.quad(packet.Lanes(), params, t_min, t_max.data(), mask,
+                   t.data(), alpha.data(), beta.data());
+  for (int lane = 0; lane < math::RayPacket::kWidth; ++lane) {
+    if ((hits & (1 << lane)) != 0) {
+      const auto& r = packet[lane];
+      t_max[lane] = t[lane];
+      rec[lane].t_ = t[lane];
+      rec[lane].point_ = r.at(t[lane]);
+      rec[lane].u_ = alpha[lane];
+      rec[lane].v_ = beta[lane];
+      rec[lane].material_ = quad.material;
+      rec[lane].uv_density_ = objects::Quad::UvDensity(quad.w);
+      rec[lane].SetNormal(r, quad.normal);
+    }
+  }
+  return hits;
+}
+
+std::expected<Scene, std::string> LoadSceneCached(
+    const std::filesystem::path& path,
+    const std::filesystem::path& cache_path) {
+  const auto start = std::chrono::steady_clock::now();
+
+  util::MappedFile source;
+  if (!source.Open(path)) {
+    return std::unexpected("cannot open " + path.string());
+  }
+  const std::string_view text(
+      reinterpret_cast<const char*>(source.Bytes().data()),
+      source.Bytes().size());
+  const auto hash = HashFileContent(source.Bytes());
+
+  auto cached = CachedScene::Open(cache_path, hash);
+  const bool from_cache = cached != nullptr;
+  if (!from_cache) {
+    auto desc = ParseSceneDescription(text, path.parent_path());
+    if (!desc) {
+      return std::unexpected(path.string() + ", " + desc.error());
+    }
+    // The cache holds flat BVHs only, so a scene asking for another
+    // structure is built from its description, which was parsed already
+    const auto flat = [](math::AcceleratorType type) {
+      return type == math::AcceleratorType::Flat;
+    };
+    std::string skipped;
+    if (!flat(desc->accelerator) ||
+        !std::ranges::all_of(desc->group_accelerators, flat)) {
+      skipped = "it holds flat BVHs only";
+    } else if (WriteSceneCache(*desc, hash, cache_path)) {
+      cached = CachedScene::Open(cache_path, hash);
+    }
+    if (!cached) {
+      auto scene = BuildScene(*desc);
+      scene.stats.bytes = text.size();
+      scene.stats.cache_skipped =
+          skipped.empty() ? "it could not be written" : std::move(skipped);
+      scene.stats.parse_ms = std::chrono::duration<double, std::milli>(
+                                 std::chrono::steady_clock::now() - start)
+                                 .count();
+      return scene;
+    }
+  }
+
+  Scene scene;
+  scene.settings = cached->Settings();
+  scene.look_from = cached->LookFrom();
+  scene.look_at = cached->LookAt();
+  scene.materials = cached->Materials();
+  scene.accelerator = math::AcceleratorType::Flat;
+  scene.texture_cache_bytes = cached->TextureCacheBytes();
+  scene.stats.bytes = text.size();
+  scene.stats.line_count = cached->LineCount();
+  scene.stats.primitive_count = cached->PrimitiveCount();
+  scene.stats.triangle_count = cached->TriangleCount();
+  scene.stats.instance_count = cached->InstanceCount();
+  scene.stats.primitive_bytes = cached->PrimitiveBytes();
+  scene.stats.from_cache = from_cache;
+  scene.stats.texture_ms = cached->TextureMs();
+  scene.stats.textures.assign(cached->TextureLoads().begin(),
+                              cached->TextureLoads().end());
+  scene.prebuilt = std::move(cached);
+  scene.stats.parse_ms = std::chrono::duration<double, std::milli>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
+  return scene;
+}
+
+}  // namespace polaris::scene
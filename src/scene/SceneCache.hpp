@@ -0,0 +1,199 @@
+#ifndef POLARIS_SCENE_SCENE_CACHE_HPP
+#define POLARIS_SCENE_SCENE_CACHE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <math/Common.hpp>
+#include <math/FlatBVH.hpp>
+#include <math/Transform.hpp>
+#include <math/Vec.hpp>
+#include <memory>
+#include <scene/Camera.hpp>
+#include <scene/Hittable.hpp>
+#include <scene/SceneDescription.hpp>
+#include <scene/SceneFile.hpp>
+#include <scene/material/MaterialTable.hpp>
+#include <scene/objects/TriangleMesh.hpp>
+#include <span>
+#include <string>
+#include <util/MappedFile.hpp>
+#include <vector>
+
+// Scene caches are binary files holding a parsed scene with its primitives
+// and flattened BVH already built. They are memory mapped and traced in
+// place, so opening one costs no parsing, no BVH build and no allocation
+// per primitive. Each cache records the hash of the scene text it was made
+// from and of every mesh file that text loads, and is rebuilt once any of
+// them changes. Files of another format version or of a build with another
+// math::Real are rebuilt too.
+
+namespace polaris::scene {
+
+// Sphere as stored in a cache, moving from `centre` at time 0 by `velocity`
+// per unit of time
+struct CachedSphere {
+  math::Vec3 centre;
+  math::Vec3 velocity;
+  math::Real radius = 0;
+  std::uint32_t material = 0;
+};
+
+// Quad as stored in a cache, with the plane terms objects::Quad derives
+struct CachedQuad {
+  math::Vec3 q;
+  math::Vec3 u;
+  math::Vec3 v;
+  math::Vec3 w;
+  math::Vec3 normal;
+  math::Real d = 0;
+  std::uint32_t material = 0;
+};
+
+// Mesh primitive as stored in a cache. The ranges index the cache's mesh
+// node, vertex and triangle sections, which meshes of one file share.
+struct CachedMesh {
+  std::uint64_t first_node = 0;
+  std::uint64_t node_count = 0;
+  std::uint64_t first_vertex = 0;
+  std::uint64_t vertex_count = 0;
+  std::uint64_t first_triangle = 0;
+  std::uint64_t triangle_count = 0;
+  std::uint32_t material = 0;
+};
+
+// Instance of a group as stored in a cache, with both directions of its
+// transform so neither is derived per ray
+struct CachedInstance {
+  math::Transform to_world;
+  math::Transform to_object;
+  std::uint32_t group = 0;
+};
+
+// Primitives and BVH of an open cache. Only the materials and textures are
+// built when a cache is opened; everything else is read from the mapping.
+class CachedScene : public Hittable {
+ public:
+  // Maps the cache at `path`. Returns nullptr unless it was written for
+  // scene text with hash `source_hash` by a compatible build, the mesh
+  // files it was made from are unchanged, and every index its records and
+  // BVHs hold is in range.
+  [[nodiscard]] static std::shared_ptr<CachedScene> Open(
+      const std::filesystem::path& path, std::uint64_t source_hash);
+
+  [[nodiscard]] bool Hit(const math::Ray& r, const math::Interval& t_interval,
+                         HitInfo& rec) const override;
+
+  [[nodiscard]] int HitPacket(const math::RayPacket& packet, int mask,
+                              double t_min, PacketDistances& t_max,
+                              PacketHitInfo& rec) const override;
+
+  [[nodiscard]] math::AABB GetBounds() const override;
+
+  [[nodiscard]] const CameraSettings& Settings() const { return settings_; }
+  [[nodiscard]] const math::Vec3& LookFrom() const { return look_from_; }
+  [[nodiscard]] const math::Vec3& LookAt() const { return look_at_; }
+  [[nodiscard]] std::size_t LineCount() const { return line_count_; }
+  [[nodiscard]] std::size_t PrimitiveCount() const {
+    return primitives_.size();
+  }
+  [[nodiscard]] std::size_t NodeCount() const { return nodes_.size(); }
+  [[nodiscard]] std::size_t TriangleCount() const { return triangle_count_; }
+  [[nodiscard]] std::size_t InstanceCount() const { return instance_count_; }
+  [[nodiscard]] std::size_t TextureCacheBytes() const {
+    return texture_cache_bytes_;
+  }
+  // Bytes of the mapped primitive records and references
+  [[nodiscard]] std::size_t PrimitiveBytes() const;
+  // Materials by the indices the cached records carry
+  [[nodiscard]] const material::MaterialTable& Materials() const {
+    return materials_;
+  }
+  // Image textures as loaded on opening
+  [[nodiscard]] std::span<const TextureLoad> TextureLoads() const {
+    return texture_loads_;
+  }
+  [[nodiscard]] double TextureMs() const { return texture_ms_; }
+
+  // Top bits of a primitive reference, naming the record list its index is
+  // into
+  static constexpr std::uint32_t kSphereKind = 0;
+  static constexpr std::uint32_t kMeshKind = 1U << 30;
+  static constexpr std::uint32_t kQuadKind = 2U << 30;
+  static constexpr std::uint32_t kInstanceKind = 3U << 30;
+  static constexpr std::uint32_t kKindMask = 3U << 30;
+  static constexpr std::uint32_t kIndexMask = ~kKindMask;
+
+ private:
+  // A BVH and the references its leaves index: the top level, or a group
+  // placed by instances
+  struct Level {
+    std::span<const math::FlatBVHNode> nodes;
+    std::span<const std::uint32_t> primitives;
+  };
+
+  CachedScene() = default;
+
+  [[nodiscard]] bool HitLevel(const Level& level, const math::Ray& r,
+                              const math::Interval& t_interval,
+                              HitInfo& rec) const;
+  [[nodiscard]] int HitLevelPacket(const Level& level,
+                                   const math::RayPacket& packet, int mask,
+                                   double t_min, PacketDistances& t_max,
+                                   PacketHitInfo& rec) const;
+
+  [[nodiscard]] bool HitPrimitive(std::uint32_t primitive, const math::Ray& r,
+                                  const math::Interval& t_interval,
+                                  HitInfo& rec) const;
+  [[nodiscard]] int HitPrimitivePacket(std::uint32_t primitive,
+                                       const math::RayPacket& packet, int mask,
+                                       double t_min, PacketDistances& t_max,
+                                       PacketHitInfo& rec) const;
+
+  util::MappedFile file_;
+  CameraSettings settings_;
+  math::Vec3 look_from_;
+  math::Vec3 look_at_;
+  std::size_t line_count_ = 0;
+  std::size_t triangle_count_ = 0;
+  std::size_t instance_count_ = 0;
+  std::size_t texture_cache_bytes_ = 0;
+
+  std::span<const math::FlatBVHNode> nodes_;
+  std::span<const std::uint32_t> primitives_;  // Leaf order
+  std::span<const CachedSphere> spheres_;
+  std::span<const CachedQuad> quads_;
+  std::span<const CachedMesh> meshes_;
+  std::vector<objects::MeshView> mesh_views_;  // One per entry of meshes_
+  std::span<const CachedInstance> instances_;
+  std::vector<Level> groups_;
+
+  std::vector<std::shared_ptr<texture::Texture>> textures_;
+  std::vector<TextureLoad> texture_loads_;
+  double texture_ms_ = 0.0;
+  material::MaterialTable materials_;
+};
+
+// Hash of file contents that caches are keyed by
+[[nodiscard]] std::uint64_t HashFileContent(std::span<const std::byte> bytes);
+
+// Writes the cache of a parsed scene, made from text with hash `source_hash`.
+// The file is replaced in one step, so readers never see half of one.
+bool WriteSceneCache(const SceneDescription& desc, std::uint64_t source_hash,
+                     const std::filesystem::path& path,
+                     const math::BVHBuildOptions& options = {});
+
+// Loads a scene file through the cache at `cache_path`, which is written
+// first if it is missing or stale. The scene comes with its cache as the
+// prebuilt acceleration structure, a flattened BVH. Scenes asking for
+// another accelerator, for the top level or a group, are not cached; they
+// are built as LoadScene() does, as are scenes whose cache cannot be
+// written, and stats.cache_skipped says why.
+[[nodiscard]] std::expected<Scene, std::string> LoadSceneCached(
+    const std::filesystem::path& path,
+    const std::filesystem::path& cache_path);
+
+}  // namespace polaris::scene
+
+#endif
@@ -0,0 +1,138 @@
+#include <chrono>
+#include <image/TileCache.hpp>
+#include <scene/SceneDescription.hpp>
+#include <scene/texture/CheckerTexture.hpp>
+#include <scene/texture/ImageTexture.hpp>
+#include <scene/texture/PerlinNoise.hpp>
+#include <scene/texture/SolidColour.hpp>
+#include <string_view>
+#include <unordered_map>
+#include <util/ThreadPool.hpp>
+
+namespace polaris::scene {
+
+std::shared_ptr<texture::Texture> MakeTexture(
+    const TextureDesc& desc,
+    std::span<const std::shared_ptr<texture::Texture>> textures,
+    std::size_t texture_cache_bytes) {
+  switch (desc.kind) {
+    case TextureDesc::Kind::Solid:
+      return std::make_shared<texture::SolidColour>(desc.colour);
+    case TextureDesc::Kind::Checker:
+      return std::make_shared<texture::CheckerTexture>(
+          desc.scale, textures[desc.even], textures[desc.odd]);
+    case TextureDesc::Kind::Noise:
+      return std::make_shared<texture::NoiseTexture>(desc.scale);
+    case TextureDesc::Kind::Image: {
+      image::TileCache* cache = nullptr;
+      if (texture_cache_bytes > 0) {
+        cache = &image::TileCache::Shared();
+        cache->SetBudget(texture_cache_bytes);
+      }
+      return std::make_shared<texture::ImageTexture>(desc.path.c_str(),
+                                                      desc.filter, cache);
+    }
+  }
+  return nullptr;
+}
+
+std::vector<std::shared_ptr<texture::Texture>> MakeTextures(
+    std::span<const TextureDesc> descs, std::size_t texture_cache_bytes,
+    std::vector<TextureLoad>* loads) {
+  std::vector<std::shared_ptr<texture::Texture>> textures(descs.size());
+
+  // Images of the same file load in one task, one after the other, so its
+  // tiled copy is written only once
+  std::vector<std::vector<std::size_t>> files;
+  std::unordered_map<std::string_view, std::size_t> file_ids;
+  for (std::size_t i = 0; i < descs.size(); ++i) {
+    if (descs[i].kind == TextureDesc::Kind::Image) {
+      const auto [id, added] = file_ids.try_emplace(descs[i].path,
+                                                    files.size());
+      if (added) {
+        files.emplace_back();
+      }
+      files[id->second].push_back(i);
+    }
+  }
+
+  std::vector<double> load_ms(descs.size());
+  util::TaskGroup group(util::ThreadPool::Default());
+  for (const auto& file : files) {
+    group.Run([&, texture_cache_bytes] {
+      for (const auto i : file) {
+        const auto start = std::chrono::steady_clock::now();
+        textures[i] = MakeTexture(descs[i], {}, texture_cache_bytes);
+        load_ms[i] = std::chrono::duration<double, std::milli>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+      }
+    });
+  }
+  group.Wait();
+
+  for (std::size_t i = 0; i < descs.size(); ++i) {
+    if (descs[i].kind != TextureDesc::Kind::Image) {
+      textures[i] = MakeTexture(descs[i], textures, texture_cache_bytes);
+    } else if (loads != nullptr) {
+      const auto& image =
+          static_cast<const texture::ImageTexture&>(*textures[i]);
+      loads->push_back({descs[i].path, load_ms[i], image.Width(),
+                        image.Height(), image.IsPaged()});
+    }
+  }
+  return textures;
+}
+
+material::AnyMaterial MakeMaterial(
+    const MaterialDesc& desc,
+    std::span<const std::shared_ptr<texture::Texture>> textures) {
+  switch (desc.kind) {
+    case MaterialDesc::Kind::Lambertian:
+      break;
+    case MaterialDesc::Kind::Metal:
+      return material::Metal(desc.albedo, desc.parameter);
+    case MaterialDesc::Kind::Dielectric:
+      return material::Dielectric(desc.parameter);
+  }
+  if (desc.texture != MaterialDesc::kNoTexture) {
+    return material::Lambertian(textures[desc.texture]);
+  }
+  return material::Lambertian(desc.albedo);
+}
+
+void AddPrimitive(const PrimitiveDesc& desc, std::span<const MeshDesc> meshes,
+                  HittableList& list) {
+  auto& primitives = list.Primitives();
+  switch (desc.kind) {
+    case PrimitiveDesc::Kind::Sphere:
+      primitives.AddSphere(desc.a, math::Vec3(0, 0, 0), desc.radius,
+                           desc.material);
+      break;
+    case PrimitiveDesc::Kind::MovingSphere:
+      primitives.AddSphere(desc.a, desc.b - desc.a, desc.radius,
+                           desc.material);
+      break;
+    case PrimitiveDesc::Kind::Quad:
+      primitives.AddQuad(desc.a, desc.b, desc.c, desc.material);
+      break;
+    case PrimitiveDesc::Kind::Mesh:
+      primitives.AddObject(std::make_shared<objects::TriangleMesh>(
+          meshes[desc.index].mesh, desc.material));
+      break;
+    case PrimitiveDesc::Kind::Instance:
+      break;
+  }
+}
+
+std::shared_ptr<Hittable> MakeGroup(
+    std::span<const PrimitiveDesc> group, std::span<const MeshDesc> meshes,
+    math::AcceleratorType type) {
+  HittableList list;
+  for (const auto& primitive : group) {
+    AddPrimitive(primitive, meshes, list);
+  }
+  return math::MakeAccelerator(type, list);
+}
+
+}  // namespace polaris::scene
@@ -0,0 +1,153 @@
+#ifndef POLARIS_SCENE_SCENE_DESCRIPTION_HPP
+#define POLARIS_SCENE_SCENE_DESCRIPTION_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <image/MipMap.hpp>
+#include <image/Pixel.hpp>
+#include <math/Accelerator.hpp>
+#include <math/Common.hpp>
+#include <math/Transform.hpp>
+#include <math/Vec.hpp>
+#include <memory>
+#include <scene/Camera.hpp>
+#include <scene/Hittable.hpp>
+#include <scene/HittableList.hpp>
+#include <scene/material/MaterialTable.hpp>
+#include <scene/objects/TriangleMesh.hpp>
+#include <scene/texture/Texture.hpp>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace polaris::scene {
+
+// Scene contents as declared in a scene file, before any object is built.
+// Textures and materials refer to earlier entries by index.
+struct TextureDesc {
+  enum class Kind : std::uint8_t { Solid, Checker, Noise, Image };
+
+  Kind kind = Kind::Solid;
+  image::PixelF64 colour;  // Solid
+  double scale = 1.0;      // Checker and noise
+  std::uint32_t even = 0;  // Checker
+  std::uint32_t odd = 0;
+  std::string path;        // Image
+  image::TextureFilter filter = image::TextureFilter::Trilinear;
+
+  bool operator==(const TextureDesc&) const = default;
+};
+
+struct MaterialDesc {
+  enum class Kind : std::uint8_t { Lambertian, Metal, Dielectric };
+  static constexpr std::uint32_t kNoTexture = ~0U;
+
+  Kind kind = Kind::Lambertian;
+  image::PixelF64 albedo;              // Lambertian and metal
+  std::uint32_t texture = kNoTexture;  // Replaces the Lambertian albedo
+  double parameter = 0.0;              // Metal fuzz, dielectric index
+
+  bool operator==(const MaterialDesc&) const = default;
+};
+
+struct PrimitiveDesc {
+  enum class Kind : std::uint8_t {
+    Sphere,
+    MovingSphere,
+    Quad,
+    Mesh,
+    Instance
+  };
+
+  Kind kind = Kind::Sphere;
+  std::uint32_t material = 0;  // Unused by instances
+  // Index into SceneDescription::meshes or SceneDescription::instances
+  std::uint32_t index = 0;
+  math::Vec3 a;  // Centre, or Q of a quad
+  math::Vec3 b;  // End centre of a moving sphere, or u of a quad
+  math::Vec3 c;  // v of a quad
+  math::Real radius = 0;
+};
+
+// Placement of a group; see objects::Instance
+struct InstanceDesc {
+  std::uint32_t group = 0;  // Index into SceneDescription::groups
+  math::Transform to_world;
+};
+
+// Mesh file, loaded while parsing as its triangles are not in the scene text
+struct MeshDesc {
+  std::string path;  // Resolved against the scene file's directory
+  std::shared_ptr<const objects::Mesh> mesh;
+};
+
+struct SceneDescription {
+  CameraSettings settings;
+  math::Vec3 look_from{0, 0, 0};
+  math::Vec3 look_at{0, 0, -1};
+  math::AcceleratorType accelerator = math::AcceleratorType::Flat;
+  // Image textures are paged in tiles through a shared cache of this many
+  // bytes when positive, and loaded whole when 0
+  std::size_t texture_cache_bytes = 0;
+
+  std::vector<TextureDesc> textures;
+  std::vector<MaterialDesc> materials;
+  std::vector<MeshDesc> meshes;
+  // Primitives of each group, which cannot themselves be instances
+  std::vector<std::vector<PrimitiveDesc>> groups;
+  // Structure each group is built into: the accelerator chosen before its
+  // first instance
+  std::vector<math::AcceleratorType> group_accelerators;
+  std::vector<InstanceDesc> instances;
+  std::vector<PrimitiveDesc> primitives;
+  std::size_t line_count = 0;
+  std::size_t triangle_count = 0;  // Over every placed mesh
+  std::size_t instance_count = 0;
+};
+
+// Builders of the objects a description stands for. `textures` holds the
+// objects of the entries declared before, `meshes` the meshes of the
+// description. Image textures are paged through the shared tile cache, with
+// a budget of `texture_cache_bytes`, unless it is 0.
+[[nodiscard]] std::shared_ptr<texture::Texture> MakeTexture(
+    const TextureDesc& desc,
+    std::span<const std::shared_ptr<texture::Texture>> textures,
+    std::size_t texture_cache_bytes = 0);
+
+// How long one image texture took to load, as MakeTextures() reports it
+struct TextureLoad {
+  std::string path;
+  double load_ms = 0.0;  // Decoding, or opening the tiled copy
+  int width = 0;         // 0 if the image could not be read
+  int height = 0;
+  bool paged = false;
+};
+
+// Builds every texture of `descs`, in their order. Image textures, which
+// refer to no other texture, are decoded in parallel on the default thread
+// pool first; the others are cheap and follow one by one. The time taken by
+// each image is added to `loads` if given.
+[[nodiscard]] std::vector<std::shared_ptr<texture::Texture>> MakeTextures(
+    std::span<const TextureDesc> descs, std::size_t texture_cache_bytes = 0,
+    std::vector<TextureLoad>* loads = nullptr);
+
+[[nodiscard]] material::AnyMaterial MakeMaterial(
+    const MaterialDesc& desc,
+    std::span<const std::shared_ptr<texture::Texture>> textures);
+
+// Adds the primitive `desc` stands for to `list`. Its material stays the
+// index into the description's materials, which the scene's MaterialTable
+// holds at the same indices. Instances are not primitives of their own; they
+// are built from the objects MakeGroup() returns.
+void AddPrimitive(const PrimitiveDesc& desc, std::span<const MeshDesc> meshes,
+                  HittableList& list);
+
+// Acceleration structure of type `type` over the primitives of a group,
+// which its instances share
+[[nodiscard]] std::shared_ptr<Hittable> MakeGroup(
+    std::span<const PrimitiveDesc> group, std::span<const MeshDesc> meshes,
+    math::AcceleratorType type);
+
+}  // namespace polaris::scene
+
+#endif
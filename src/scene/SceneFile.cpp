@@ -0,0 +1,954 @@
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <image/FrameBuffer.hpp>
+#include <image/RTWImage.hpp>
+#include <image/ToneMap.hpp>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <scene/MeshLoader.hpp>
+#include <scene/SceneDescription.hpp>
+#include <scene/SceneFile.hpp>
+#include <system_error>
+#include <unordered_map>
+#include <utility>
+#include <util/ThreadPool.hpp>
+#include <vector>
+
+namespace polaris::scene {
+namespace {
+using texture::Texture;
+
+// Runs of primitive lines are cut into chunks of this many lines, which are
+// parsed in parallel
+constexpr std::size_t kChunkLines = 16384;
+
+// Blank separated words of one line
+class Tokens {
+ public:
+  explicit Tokens(std::string_view line)
+      : rest_(line.substr(0, line.find('#'))) {}
+
+  // Next word, or an empty view at the end of the line
+  std::string_view Next() {
+    const auto begin = rest_.find_first_not_of(" \t\r");
+    if (begin == std::string_view::npos) {
+      rest_ = {};
+      return {};
+    }
+    rest_.remove_prefix(begin);
+    const auto end = std::min(rest_.find_first_of(" \t\r"), rest_.size());
+    const auto word = rest_.substr(0, end);
+    rest_.remove_prefix(end);
+    return word;
+  }
+
+  // Next word, left to be read again
+  [[nodiscard]] std::string_view Peek() const { return Tokens(*this).Next(); }
+
+  [[nodiscard]] bool Done() { return Next().empty(); }
+
+ private:
+  std::string_view rest_;
+};
+
+template <typename T>
+bool ParseValue(std::string_view word, T& value) {
+  const auto* end = word.data() + word.size();
+  auto [ptr, ec] = std::from_chars(word.data(), end, value);
+  return ec == std::errc() && ptr == end;
+}
+
+bool ParseReal(std::string_view word, math::Real& value) {
+  double parsed = 0.0;
+  if (!ParseValue(word, parsed)) {
+    return false;
+  }
+  value = static_cast<math::Real>(parsed);
+  return true;
+}
+
+bool ReadNumber(Tokens& tokens, double& value) {
+  return ParseValue(tokens.Next(), value);
+}
+
+bool ReadVec(Tokens& tokens, math::Vec3& v) {
+  math::Real x = 0;
+  math::Real y = 0;
+  math::Real z = 0;
+  if (!ParseReal(tokens.Next(), x) || !ParseReal(tokens.Next(), y) ||
+      !ParseReal(tokens.Next(), z)) {
+    return false;
+  }
+  v = math::Vec3(x, y, z);
+  return true;
+}
+
+bool ReadColour(Tokens& tokens, image::PixelF64& colour) {
+  double r = 0.0;
+  double g = 0.0;
+  double b = 0.0;
+  if (!ReadNumber(tokens, r) || !ReadNumber(tokens, g) ||
+      !ReadNumber(tokens, b)) {
+    return false;
+  }
+  colour = image::PixelF64(r, g, b);
+  return true;
+}
+
+template <typename E, std::size_t N>
+std::optional<E> FindEnum(
+    const std::array<std::pair<std::string_view, E>, N>& names,
+    std::string_view word) {
+  for (const auto& [name, entry] : names) {
+    if (name == word) {
+      return entry;
+    }
+  }
+  return std::nullopt;
+}
+
+template <typename E, std::size_t N>
+bool ReadEnum(Tokens& tokens,
+              const std::array<std::pair<std::string_view, E>, N>& names,
+              E& value) {
+  const auto entry = FindEnum(names, tokens.Next());
+  if (entry) {
+    value = *entry;
+  }
+  return entry.has_value();
+}
+
+// Hash of the fields of texture and material descriptions, so a declaration
+// equal to an earlier one can take over its entry
+struct DescHash {
+  template <typename... Fields>
+  static std::size_t Combine(const Fields&... fields) {
+    std::size_t seed = 0;
+    ((seed ^= std::hash<Fields>{}(fields) + 0x9e3779b97f4a7c15ULL +
+              (seed << 6) + (seed >> 2)),
+     ...);
+    return seed;
+  }
+
+  std::size_t operator()(const TextureDesc& desc) const noexcept {
+    return Combine(desc.kind, desc.colour.R(), desc.colour.G(),
+                   desc.colour.B(), desc.scale, desc.even, desc.odd,
+                   desc.path, desc.filter);
+  }
+
+  std::size_t operator()(const MaterialDesc& desc) const noexcept {
+    return Combine(desc.kind, desc.albedo.R(), desc.albedo.G(),
+                   desc.albedo.B(), desc.texture, desc.parameter);
+  }
+};
+
+constexpr std::array<std::pair<std::string_view, sampler::SamplerType>, 3>
+    kSamplerNames{{{"pcg", sampler::SamplerType::PCG},
+                   {"hash", sampler::SamplerType::Hash},
+                   {"sobol", sampler::SamplerType::Sobol}}};
+
+constexpr std::array<std::pair<std::string_view, TileOrder>, 3> kOrderNames{
+    {{"rows", TileOrder::RowMajor},
+     {"hilbert", TileOrder::Hilbert},
+     {"centre", TileOrder::CenterOut}}};
+
+constexpr std::array<std::pair<std::string_view, TraceMode>, 2> kModeNames{
+    {{"scalar", TraceMode::Scalar}, {"packet", TraceMode::Packet}}};
+
+constexpr std::array<std::pair<std::string_view, image::FileFormat>, 6>
+    kFormatNames{{{"bmp", image::FileFormat::BMP},
+                  {"png", image::FileFormat::PNG},
+                  {"jpg", image::FileFormat::JPG},
+                  {"hdr", image::FileFormat::HDR},
+                  {"pfm", image::FileFormat::PFM},
+                  {"exr", image::FileFormat::EXR}}};
+
+constexpr std::array<std::pair<std::string_view, image::ToneMapOperator>, 3>
+    kToneMapNames{{{"clamp", image::ToneMapOperator::Clamp},
+                   {"reinhard", image::ToneMapOperator::Reinhard},
+                   {"aces", image::ToneMapOperator::ACES}}};
+
+constexpr std::array<std::pair<std::string_view, image::TextureFilter>, 3>
+    kFilterNames{{{"nearest", image::TextureFilter::Nearest},
+                  {"bilinear", image::TextureFilter::Bilinear},
+                  {"trilinear", image::TextureFilter::Trilinear}}};
+
+constexpr std::array<std::pair<std::string_view, math::AcceleratorType>, 3>
+    kAcceleratorNames{{{"tree", math::AcceleratorType::Tree},
+                       {"flat", math::AcceleratorType::Flat},
+                       {"wide", math::AcceleratorType::Wide}}};
+
+bool IsPrimitive(std::string_view keyword) {
+  return keyword == "sphere" || keyword == "quad";
+}
+
+// Reads statements into a description. With a scene to fill, primitives
+// are built as they are parsed and only the primitives of groups are kept as
+// descriptions; without one, every primitive stays a description.
+class SceneParser {
+ public:
+  // Relative mesh paths are taken from `directory`
+  SceneParser(SceneDescription& desc, Scene* scene,
+              std::filesystem::path directory)
+      : desc_(desc), scene_(scene), directory_(std::move(directory)) {}
+
+  bool Parse(std::string_view text);
+
+  [[nodiscard]] const std::string& Error() const { return error_; }
+
+ private:
+  // Consecutive primitive lines, parsed together once the run ends
+  struct Chunk {
+    std::string_view text;
+    std::size_t first_line = 0;
+    std::size_t primitive_lines = 0;
+  };
+
+  struct ChunkResult {
+    std::vector<PrimitiveDesc> primitives;
+    std::string error;
+  };
+
+  bool Fail(std::size_t line, std::string_view message) {
+    error_ = "line " + std::to_string(line) + ": " + std::string(message);
+    return false;
+  }
+
+  bool Statement(std::string_view keyword, Tokens& tokens);
+  bool CameraStatement(Tokens& tokens);
+  bool RenderStatement(Tokens& tokens);
+  bool TextureStatement(Tokens& tokens);
+  bool MaterialStatement(Tokens& tokens);
+  bool InstanceStatement(Tokens& tokens);
+  bool MeshStatement(Tokens& tokens);
+
+  void ParseChunk(const Chunk& chunk, ChunkResult& result) const;
+  bool ParsePrimitive(std::string_view keyword, Tokens& tokens,
+                      PrimitiveDesc& primitive) const;
+  bool FlushRun();
+
+  // Whether parsed primitives go into the world right away
+  [[nodiscard]] bool Building() const {
+    return scene_ != nullptr && !in_group_;
+  }
+
+  // Replaces the path of each image texture by the file it names
+  void ResolveImages();
+  // Builds the textures and materials declared, into the scene's table
+  void BuildMaterials();
+  void Add(const PrimitiveDesc& primitive);
+
+  SceneDescription& desc_;
+  Scene* scene_;
+  std::filesystem::path directory_;
+  std::vector<std::filesystem::path> image_dirs_;  // Searched for images
+  std::string error_;
+  std::size_t line_ = 0;
+
+  std::unordered_map<std::string_view, std::uint32_t> texture_ids_;
+  std::unordered_map<std::string_view, std::uint32_t> material_ids_;
+  std::unordered_map<std::string_view, std::uint32_t> group_ids_;
+  std::unordered_map<std::string, std::uint32_t> mesh_ids_;  // By path
+  // Entries of desc_ by their contents; equal declarations share an entry
+  std::unordered_map<TextureDesc, std::uint32_t, DescHash> texture_entries_;
+  std::unordered_map<MaterialDesc, std::uint32_t, DescHash> material_entries_;
+  // Per group, the index of its acceleration structure in the world's store
+  // once the first instance needs it, and the triangles of its meshes
+  std::vector<std::optional<std::uint32_t>> group_objects_;
+  std::vector<bool> group_placed_;  // Whether any instance uses the group
+  std::vector<std::size_t> group_triangles_;
+  std::vector<std::shared_ptr<Texture>> textures_;
+
+  // Group being defined; primitives go to it instead of the world
+  std::string_view group_name_;
+  std::vector<PrimitiveDesc> group_;
+  std::size_t group_triangle_count_ = 0;
+  bool in_group_ = false;
+
+  std::vector<Chunk> run_;
+};
+
+bool SceneParser::Parse(std::string_view text) {
+  std::size_t pos = 0;
+  while (pos < text.size()) {
+    auto end = text.find('\n', pos);
+    if (end == std::string_view::npos) {
+      end = text.size();
+    }
+    const auto line = text.substr(pos, end - pos);
+    ++line_;
+
+    Tokens tokens(line);
+    const auto keyword = tokens.Next();
+    if (IsPrimitive(keyword)) {
+      // Only the line boundaries are found here; the numbers are parsed
+      // when the run is flushed
+      if (run_.empty() || run_.back().primitive_lines == kChunkLines) {
+        run_.push_back({text.substr(pos, 0), line_, 0});
+      }
+      auto& chunk = run_.back();
+      chunk.text = {chunk.text.data(),
+                    static_cast<std::size_t>(text.data() + end -
+                                             chunk.text.data())};
+      ++chunk.primitive_lines;
+    } else if (!keyword.empty()) {
+      if (!FlushRun() || !Statement(keyword, tokens)) {
+        return false;
+      }
+    }
+    pos = end + 1;
+  }
+
+  if (!FlushRun()) {
+    return false;
+  }
+  if (in_group_) {
+    return Fail(line_, "group '" + std::string(group_name_) + "' has no end");
+  }
+  desc_.line_count = line_;
+  ResolveImages();
+  BuildMaterials();
+  return true;
+}
+
+bool SceneParser::Statement(std::string_view keyword, Tokens& tokens) {
+  if (keyword == "camera") {
+    return CameraStatement(tokens);
+  }
+  if (keyword == "render") {
+    return RenderStatement(tokens);
+  }
+  if (keyword == "texture") {
+    return TextureStatement(tokens);
+  }
+  if (keyword == "material") {
+    return MaterialStatement(tokens);
+  }
+  if (keyword == "instance") {
+    return InstanceStatement(tokens);
+  }
+  if (keyword == "mesh") {
+    return MeshStatement(tokens);
+  }
+
+  if (keyword == "group") {
+    const auto name = tokens.Next();
+    if (in_group_) {
+      return Fail(line_, "groups cannot be nested");
+    }
+    if (name.empty() || group_ids_.contains(name) || !tokens.Done()) {
+      return Fail(line_, "expected a new group name");
+    }
+    group_name_ = name;
+    in_group_ = true;
+    return true;
+  }
+  if (keyword == "end") {
+    if (!in_group_) {
+      return Fail(line_, "end without group");
+    }
+    if (group_.empty()) {
+      return Fail(line_, "group '" + std::string(group_name_) + "' is empty");
+    }
+    group_ids_.emplace(group_name_,
+                       static_cast<std::uint32_t>(desc_.groups.size()));
+    desc_.groups.push_back(std::move(group_));
+    desc_.group_accelerators.push_back(desc_.accelerator);
+    group_placed_.push_back(false);
+    group_objects_.emplace_back();
+    group_triangles_.push_back(group_triangle_count_);
+    group_.clear();
+    group_triangle_count_ = 0;
+    in_group_ = false;
+    return true;
+  }
+
+  return Fail(line_, "unknown statement '" + std::string(keyword) + "'");
+}
+
+bool SceneParser::CameraStatement(Tokens& tokens) {
+  auto& settings = desc_.settings;
+  for (auto key = tokens.Next(); !key.empty(); key = tokens.Next()) {
+    bool ok = false;
+    if (key == "from") {
+      ok = ReadVec(tokens, desc_.look_from);
+    } else if (key == "at") {
+      ok = ReadVec(tokens, desc_.look_at);
+    } else if (key == "fov") {
+      ok = ReadNumber(tokens, settings.fov);
+    } else if (key == "defocus") {
+      ok = ReadNumber(tokens, settings.defocus_angle);
+    } else if (key == "focus") {
+      ok = ReadNumber(tokens, settings.focus_dist);
+    } else if (key == "width") {
+      ok = ParseValue(tokens.Next(), settings.image_width) &&
+           settings.image_width > 0;
+    } else if (key == "aspect") {
+      // Either a number or a ratio such as 16/9
+      const auto word = tokens.Next();
+      const auto slash = word.find('/');
+      double width = 0.0;
+      double height = 1.0;
+      ok = slash == std::string_view::npos
+               ? ParseValue(word, width)
+               : ParseValue(word.substr(0, slash), width) &&
+                     ParseValue(word.substr(slash + 1), height);
+      ok = ok && width > 0.0 && height > 0.0;
+      settings.aspect_ratio = width / height;
+    } else {
+      return Fail(line_, "unknown camera setting '" + std::string(key) + "'");
+    }
+
+    if (!ok) {
+      return Fail(line_, "bad value for camera " + std::string(key));
+    }
+  }
+  return true;
+}
+
+bool SceneParser::RenderStatement(Tokens& tokens) {
+  auto& settings = desc_.settings;
+  for (auto key = tokens.Next(); !key.empty(); key = tokens.Next()) {
+    bool ok = false;
+    if (key == "samples") {
+      ok = ParseValue(tokens.Next(), settings.samples_per_pixel);
+    } else if (key == "depth") {
+      ok = ParseValue(tokens.Next(), settings.max_depth_);
+    } else if (key == "roulette") {
+      ok = ParseValue(tokens.Next(), settings.roulette_depth);
+    } else if (key == "sampler") {
+      ok = ReadEnum(tokens, kSamplerNames, settings.sampler);
+    } else if (key == "seed") {
+      ok = ParseValue(tokens.Next(), settings.seed);
+    } else if (key == "adaptive") {
+      ok = ReadNumber(tokens, settings.adaptive_threshold);
+      // The counts are optional; no key starts with a digit
+      std::uint32_t count = 0;
+      if (ok && ParseValue(tokens.Peek(), count)) {
+        ok = ParseValue(tokens.Next(), settings.adaptive_min_samples) &&
+             ParseValue(tokens.Next(), settings.adaptive_max_samples) &&
+             settings.adaptive_min_samples <= settings.adaptive_max_samples;
+      }
+    } else if (key == "pass") {
+      ok = ParseValue(tokens.Next(), settings.pass_samples);
+    } else if (key == "tile") {
+      ok = ParseValue(tokens.Next(), settings.tile_size) &&
+           settings.tile_size > 0;
+    } else if (key == "order") {
+      ok = ReadEnum(tokens, kOrderNames, settings.tile_order);
+    } else if (key == "mode") {
+      ok = ReadEnum(tokens, kModeNames, settings.trace_mode);
+    } else if (key == "threads") {
+      ok = ParseValue(tokens.Next(), settings.thread_count);
+    } else if (key == "format") {
+      ok = ReadEnum(tokens, kFormatNames, settings.output_format_);
+    } else if (key == "exposure") {
+      ok = ReadNumber(tokens, settings.tone_map.exposure);
+    } else if (key == "tonemap") {
+      ok = ReadEnum(tokens, kToneMapNames, settings.tone_map.tone_operator);
+    } else if (key == "accelerator") {
+      ok = ReadEnum(tokens, kAcceleratorNames, desc_.accelerator);
+    } else if (key == "texcache") {
+      std::size_t mib = 0;
+      ok = ParseValue(tokens.Next(), mib) &&
+           mib <= std::numeric_limits<std::size_t>::max() >> 20;
+      desc_.texture_cache_bytes = mib << 20;
+    } else if (key == "imagepath") {
+      const auto dir = tokens.Next();
+      ok = !dir.empty();
+      image_dirs_.push_back(directory_ / dir);
+    } else {
+      return Fail(line_, "unknown render setting '" + std::string(key) + "'");
+    }
+
+    if (!ok) {
+      return Fail(line_, "bad value for render " + std::string(key));
+    }
+  }
+  return true;
+}
+
+bool SceneParser::TextureStatement(Tokens& tokens) {
+  const auto name = tokens.Next();
+  const auto type = tokens.Next();
+  if (name.empty() || texture_ids_.contains(name)) {
+    return Fail(line_, "expected a new texture name");
+  }
+
+  TextureDesc texture;
+  bool ok = false;
+  if (type == "solid") {
+    texture.kind = TextureDesc::Kind::Solid;
+    ok = ReadColour(tokens, texture.colour);
+  } else if (type == "checker") {
+    texture.kind = TextureDesc::Kind::Checker;
+    ok = ReadNumber(tokens, texture.scale) && texture.scale > 0.0;
+    const auto even = texture_ids_.find(tokens.Next());
+    const auto odd = texture_ids_.find(tokens.Next());
+    if (ok && even != texture_ids_.end() && odd != texture_ids_.end()) {
+      texture.even = even->second;
+      texture.odd = odd->second;
+    } else {
+      ok = false;
+    }
+  } else if (type == "noise") {
+    texture.kind = TextureDesc::Kind::Noise;
+    ok = ReadNumber(tokens, texture.scale);
+  } else if (type == "image") {
+    texture.kind = TextureDesc::Kind::Image;
+    texture.path = tokens.Next();
+    ok = !texture.path.empty();
+    if (const auto option = tokens.Next(); ok && !option.empty()) {
+      ok = option == "filter" &&
+           ReadEnum(tokens, kFilterNames, texture.filter);
+    }
+  } else {
+    return Fail(line_, "unknown texture type '" + std::string(type) + "'");
+  }
+
+  if (!ok || !tokens.Done()) {
+    return Fail(line_, "bad " + std::string(type) + " texture");
+  }
+  const auto [entry, added] = texture_entries_.try_emplace(
+      texture, static_cast<std::uint32_t>(desc_.textures.size()));
+  if (added) {
+    desc_.textures.push_back(std::move(texture));
+  }
+  texture_ids_.emplace(name, entry->second);
+  return true;
+}
+
+bool SceneParser::MaterialStatement(Tokens& tokens) {
+  const auto name = tokens.Next();
+  const auto type = tokens.Next();
+  if (name.empty() || material_ids_.contains(name)) {
+    return Fail(line_, "expected a new material name");
+  }
+
+  MaterialDesc material;
+  bool ok = false;
+  if (type == "lambertian") {
+    // Takes a colour or the name of a texture
+    material.kind = MaterialDesc::Kind::Lambertian;
+    Tokens lookahead = tokens;
+    const auto texture = texture_ids_.find(lookahead.Next());
+    if (texture != texture_ids_.end()) {
+      // A solid texture is the same as its colour given directly
+      tokens = lookahead;
+      const auto& desc = desc_.textures[texture->second];
+      if (desc.kind == TextureDesc::Kind::Solid) {
+        material.albedo = desc.colour;
+      } else {
+        material.texture = texture->second;
+      }
+      ok = true;
+    } else {
+      ok = ReadColour(tokens, material.albedo);
+    }
+  } else if (type == "metal") {
+    material.kind = MaterialDesc::Kind::Metal;
+    ok = ReadColour(tokens, material.albedo) &&
+         ReadNumber(tokens, material.parameter);
+  } else if (type == "dielectric") {
+    material.kind = MaterialDesc::Kind::Dielectric;
+    ok = ReadNumber(tokens, material.parameter) && material.parameter > 0.0;
+  } else {
+    return Fail(line_, "unknown material type '" + std::string(type) + "'");
+  }
+
+  if (!ok || !tokens.Done()) {
+    return Fail(line_, "bad " + std::string(type) + " material");
+  }
+  const auto [entry, added] = material_entries_.try_emplace(
+      material, static_cast<std::uint32_t>(desc_.materials.size()));
+  if (added) {
+    desc_.materials.push_back(material);
+  }
+  material_ids_.emplace(name, entry->second);
+  return true;
+}
+
+bool SceneParser::InstanceStatement(Tokens& tokens) {
+  const auto group = group_ids_.find(tokens.Next());
+  if (group == group_ids_.end()) {
+    return Fail(line_, "instance of an unknown group");
+  }
+  if (in_group_) {
+    return Fail(line_, "instances cannot be part of a group");
+  }
+
+  // A bare offset may follow the name; after that each step is applied on
+  // top of the ones before it
+  InstanceDesc instance;
+  instance.group = group->second;
+  math::Vec3 offset;
+  Tokens lookahead = tokens;
+  if (ReadVec(lookahead, offset)) {
+    tokens = lookahead;
+    instance.to_world = math::Transform::Translate(offset);
+  }
+  for (auto step = tokens.Next(); !step.empty(); step = tokens.Next()) {
+    math::Transform transform;
+    bool ok = false;
+    if (step == "translate") {
+      ok = ReadVec(tokens, offset);
+      transform = math::Transform::Translate(offset);
+    } else if (step == "rotate") {
+      math::Vec3 axis;
+      double degrees = 0.0;
+      ok = ReadVec(tokens, axis) && ReadNumber(tokens, degrees) &&
+           axis.LengthSquared() > 0;
+      transform = math::Transform::Rotate(axis, degrees);
+    } else if (step == "scale") {
+      // One factor for all axes or one per axis
+      math::Vec3 factors;
+      lookahead = tokens;
+      if (ReadVec(lookahead, factors)) {
+        tokens = lookahead;
+        ok = true;
+      } else {
+        math::Real factor = 0;
+        ok = ParseReal(tokens.Next(), factor);
+        factors = math::Vec3(factor, factor, factor);
+      }
+      ok = ok && factors[0] != 0 && factors[1] != 0 && factors[2] != 0;
+      transform = math::Transform::Scale(factors);
+    } else {
+      return Fail(line_, "unknown instance step '" + std::string(step) + "'");
+    }
+
+    if (!ok) {
+      return Fail(line_, "bad values for instance " + std::string(step));
+    }
+    instance.to_world = transform * instance.to_world;
+  }
+
+  desc_.triangle_count += group_triangles_[instance.group];
+  ++desc_.instance_count;
+  if (!group_placed_[instance.group]) {
+    group_placed_[instance.group] = true;
+    desc_.group_accelerators[instance.group] = desc_.accelerator;
+  }
+  if (scene_ == nullptr) {
+    PrimitiveDesc primitive;
+    primitive.kind = PrimitiveDesc::Kind::Instance;
+    primitive.index = static_cast<std::uint32_t>(desc_.instances.size());
+    desc_.instances.push_back(instance);
+    desc_.primitives.push_back(primitive);
+    return true;
+  }
+
+  // Groups are built once and shared by all their instances
+  auto& primitives = scene_->world.Primitives();
+  auto& object = group_objects_[instance.group];
+  if (!object) {
+    object = primitives.AddInstanced(
+        MakeGroup(desc_.groups[instance.group], desc_.meshes,
+                  desc_.group_accelerators[instance.group]));
+  }
+  primitives.AddInstance(*object, instance.to_world);
+  return true;
+}
+
+bool SceneParser::MeshStatement(Tokens& tokens) {
+  const auto material = material_ids_.find(tokens.Next());
+  const auto file = tokens.Next();
+  if (material == material_ids_.end() || file.empty() || !tokens.Done()) {
+    return Fail(line_, "expected mesh material path");
+  }
+  // Each file is loaded once however many meshes use it
+  auto path = (directory_ / file).lexically_normal().string();
+  auto id = mesh_ids_.find(path);
+  if (id == mesh_ids_.end()) {
+    auto mesh = LoadMesh(path);
+    if (!mesh) {
+      return Fail(line_, mesh.error());
+    }
+    id = mesh_ids_
+             .emplace(path, static_cast<std::uint32_t>(desc_.meshes.size()))
+             .first;
+    desc_.meshes.push_back({std::move(path), std::move(*mesh)});
+  }
+
+  PrimitiveDesc primitive;
+  primitive.kind = PrimitiveDesc::Kind::Mesh;
+  primitive.material = material->second;
+  primitive.index = id->second;
+  const auto triangles = desc_.meshes[id->second].mesh->TriangleCount();
+  if (in_group_) {
+    group_triangle_count_ += triangles;
+  } else {
+    desc_.triangle_count += triangles;
+  }
+
+  Add(primitive);
+  return true;
+}
+
+bool SceneParser::ParsePrimitive(std::string_view keyword, Tokens& tokens,
+                                 PrimitiveDesc& primitive) const {
+  const auto material = material_ids_.find(tokens.Next());
+  if (material == material_ids_.end()) {
+    return false;
+  }
+  primitive.material = material->second;
+
+  if (keyword == "sphere") {
+    primitive.kind = PrimitiveDesc::Kind::Sphere;
+    if (!ReadVec(tokens, primitive.a) ||
+        !ParseReal(tokens.Next(), primitive.radius)) {
+      return false;
+    }
+    const auto to = tokens.Next();
+    if (to.empty()) {
+      return true;
+    }
+    primitive.kind = PrimitiveDesc::Kind::MovingSphere;
+    return to == "to" && ReadVec(tokens, primitive.b) && tokens.Done();
+  }
+
+  primitive.kind = PrimitiveDesc::Kind::Quad;
+  return ReadVec(tokens, primitive.a) && ReadVec(tokens, primitive.b) &&
+         ReadVec(tokens, primitive.c) && tokens.Done();
+}
+
+void SceneParser::ParseChunk(const Chunk& chunk, ChunkResult& result) const {
+  result.primitives.reserve(chunk.primitive_lines);
+
+  std::size_t line = chunk.first_line;
+  std::size_t pos = 0;
+  while (pos < chunk.text.size()) {
+    auto end = chunk.text.find('\n', pos);
+    if (end == std::string_view::npos) {
+      end = chunk.text.size();
+    }
+    Tokens tokens(chunk.text.substr(pos, end - pos));
+    const auto keyword = tokens.Next();
+    if (!keyword.empty()) {
+      PrimitiveDesc primitive;
+      if (!ParsePrimitive(keyword, tokens, primitive)) {
+        result.error = "line " + std::to_string(line) + ": bad " +
+                       std::string(keyword) + " (unknown material or " +
+                       "wrong number of values)";
+        return;
+      }
+      result.primitives.push_back(primitive);
+    }
+    pos = end + 1;
+    ++line;
+  }
+}
+
+bool SceneParser::FlushRun() {
+  if (run_.empty()) {
+    return true;
+  }
+
+  std::vector<ChunkResult> results(run_.size());
+  if (run_.size() == 1) {
+    ParseChunk(run_.front(), results.front());
+  } else {
+    util::TaskGroup tasks(util::ThreadPool::Default());
+    for (std::size_t i = 0; i < run_.size(); ++i) {
+      tasks.Run([this, &results, i] { ParseChunk(run_[i], results[i]); });
+    }
+    tasks.Wait();
+  }
+  run_.clear();
+
+  // Chunks are appended in file order, so the scene does not depend on
+  // which thread parsed what. Spheres and quads are plain records in the
+  // world's store, so adding them is cheap enough to do here.
+  auto& primitives = in_group_ ? group_ : desc_.primitives;
+  for (auto& result : results) {
+    if (!result.error.empty()) {
+      error_ = std::move(result.error);
+      return false;
+    }
+    if (Building()) {
+      for (const auto& primitive : result.primitives) {
+        AddPrimitive(primitive, desc_.meshes, scene_->world);
+      }
+    } else {
+      primitives.insert(primitives.end(), result.primitives.begin(),
+                        result.primitives.end());
+    }
+  }
+  return true;
+}
+
+void SceneParser::ResolveImages() {
+  for (auto& texture : desc_.textures) {
+    if (texture.kind != TextureDesc::Kind::Image) {
+      continue;
+    }
+    // Paths found are made absolute, so they hold from any working
+    // directory, as in a scene cache. Names found nowhere are kept, for the
+    // texture to report.
+    std::error_code ec;
+    const auto found = [&](const std::filesystem::path& path) {
+      if (!std::filesystem::is_regular_file(path, ec)) {
+        return false;
+      }
+      auto absolute = std::filesystem::absolute(path, ec);
+      texture.path = (ec ? path : absolute).lexically_normal().string();
+      return true;
+    };
+    const auto in_dir = [&](const std::filesystem::path& dir) {
+      return found(dir / texture.path);
+    };
+    if (!in_dir(directory_) && !std::ranges::any_of(image_dirs_, in_dir)) {
+      found(image::RTWImage::FindFile(texture.path.c_str()));
+    }
+  }
+}
+
+void SceneParser::BuildMaterials() {
+  if (scene_ == nullptr) {
+    return;
+  }
+  const auto start = std::chrono::steady_clock::now();
+  textures_ = MakeTextures(desc_.textures, desc_.texture_cache_bytes,
+                           &scene_->stats.textures);
+  scene_->stats.texture_ms = std::chrono::duration<double, std::milli>(
+                                 std::chrono::steady_clock::now() - start)
+                                 .count();
+  // Primitives name materials by their index in the description, which
+  // the table keeps
+  auto& materials = scene_->materials;
+  while (materials.Size() < desc_.materials.size()) {
+    materials.Add(MakeMaterial(desc_.materials[materials.Size()], textures_));
+  }
+}
+
+void SceneParser::Add(const PrimitiveDesc& primitive) {
+  if (in_group_) {
+    group_.push_back(primitive);
+  } else if (scene_ != nullptr) {
+    AddPrimitive(primitive, desc_.meshes, scene_->world);
+  } else {
+    desc_.primitives.push_back(primitive);
+  }
+}
+
+// Copies what the scene keeps of its description, once its objects are built
+void SetSceneFields(const SceneDescription& desc, Scene& scene) {
+  scene.settings = desc.settings;
+  scene.look_from = desc.look_from;
+  scene.look_at = desc.look_at;
+  scene.accelerator = desc.accelerator;
+  scene.texture_cache_bytes = desc.texture_cache_bytes;
+  scene.stats.line_count = desc.line_count;
+  scene.stats.primitive_count = scene.world.Primitives().Size();
+  scene.stats.primitive_bytes = scene.world.Primitives().MemoryBytes();
+  scene.stats.triangle_count = desc.triangle_count;
+  scene.stats.instance_count = desc.instance_count;
+}
+}  // namespace
+
+std::expected<Scene, std::string> LoadScene(
+    const std::filesystem::path& path) {
+  const auto start = std::chrono::steady_clock::now();
+
+  // The whole file is read into one buffer, which names point into while
+  // parsing
+  std::error_code ec;
+  const auto size = std::filesystem::file_size(path, ec);
+  std::ifstream in(path, std::ios::binary);
+  if (ec || !in) {
+    return std::unexpected("cannot open " + path.string());
+  }
+  std::string text(size, '\0');
+  if (!in.read(text.data(), static_cast<std::streamsize>(size))) {
+    return std::unexpected("cannot read " + path.string());
+  }
+
+  auto scene = ParseScene(text, path.parent_path());
+  if (!scene) {
+    return std::unexpected(path.string() + ", " + scene.error());
+  }
+  scene->stats.parse_ms = std::chrono::duration<double, std::milli>(
+                              std::chrono::steady_clock::now() - start)
+                              .count();
+  return scene;
+}
+
+std::expected<Scene, std::string> ParseScene(
+    std::string_view text, const std::filesystem::path& directory) {
+  const auto start = std::chrono::steady_clock::now();
+
+  Scene scene;
+  SceneDescription desc;
+  SceneParser parser(desc, &scene, directory);
+  if (!parser.Parse(text)) {
+    return std::unexpected(parser.Error());
+  }
+
+  SetSceneFields(desc, scene);
+  scene.stats.bytes = text.size();
+  scene.stats.parse_ms = std::chrono::duration<double, std::milli>(
+                             std::chrono::steady_clock::now() - start)
+                             .count();
+  return scene;
+}
+
+std::expected<SceneDescription, std::string> ParseSceneDescription(
+    std::string_view text, const std::filesystem::path& directory) {
+  SceneDescription desc;
+  SceneParser parser(desc, nullptr, directory);
+  if (!parser.Parse(text)) {
+    return std::unexpected(parser.Error());
+  }
+  return desc;
+}
+
+Scene BuildScene(const SceneDescription& desc) {
+  Scene scene;
+  const auto start = std::chrono::steady_clock::now();
+  const auto textures = MakeTextures(desc.textures, desc.texture_cache_bytes,
+                                     &scene.stats.textures);
+  scene.stats.texture_ms = std::chrono::duration<double, std::milli>(
+                               std::chrono::steady_clock::now() - start)
+                               .count();
+  for (const auto& material : desc.materials) {
+    scene.materials.Add(MakeMaterial(material, textures));
+  }
+
+  // As while parsing, each group is built once and shared by its instances
+  auto& primitives = scene.world.Primitives();
+  std::vector<std::optional<std::uint32_t>> group_objects(desc.groups.size());
+  for (const auto& primitive : desc.primitives) {
+    if (primitive.kind != PrimitiveDesc::Kind::Instance) {
+      AddPrimitive(primitive, desc.meshes, scene.world);
+      continue;
+    }
+    const auto& instance = desc.instances[primitive.index];
+    auto& object = group_objects[instance.group];
+    if (!object) {
+      object = primitives.AddInstanced(
+          MakeGroup(desc.groups[instance.group], desc.meshes,
+                    desc.group_accelerators[instance.group]));
+    }
+    primitives.AddInstance(*object, instance.to_world);
+  }
+
+  SetSceneFields(desc, scene);
+  return scene;
+}
+
+std::optional<image::FileFormat> ParseFileFormat(std::string_view name) {
+  return FindEnum(kFormatNames, name);
+}
+
+std::optional<image::ToneMapOperator> ParseToneMapOperator(
+    std::string_view name) {
+  return FindEnum(kToneMapNames, name);
+}
+
+}  // namespace polaris::scene
@@ -0,0 +1,117 @@
+#ifndef POLARIS_SCENE_SCENE_FILE_HPP
+#define POLARIS_SCENE_SCENE_FILE_HPP
+
+#include <cstddef>
+#include <expected>
+#include <filesystem>
+#include <image/FrameBuffer.hpp>
+#include <image/ToneMap.hpp>
+#include <math/Accelerator.hpp>
+#include <math/Vec.hpp>
+#include <memory>
+#include <optional>
+#include <scene/Camera.hpp>
+#include <scene/Hittable.hpp>
+#include <scene/HittableList.hpp>
+#include <scene/SceneDescription.hpp>
+#include <scene/material/MaterialTable.hpp>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Scene description files. One statement per line, words separated by
+// blanks, `#` starts a comment; see scenes/ for examples.
+//
+//   camera from x y z | at x y z | fov deg | defocus deg | focus dist
+//          | width px | aspect a or w/h
+//   render samples n | depth n | roulette n | sampler pcg|hash|sobol
+//          | seed n | adaptive threshold [min max] | pass n | tile px
+//          | order rows|hilbert|centre | mode scalar|packet | threads n
+//          | format bmp|png|jpg|hdr|pfm|exr | exposure e
+//          | tonemap clamp|reinhard|aces | accelerator tree|flat|wide
+//          | texcache MiB | imagepath dir
+//   texture name solid r g b | checker scale even odd | noise scale
+//                | image path [filter nearest|bilinear|trilinear]
+//   material name lambertian r g b | lambertian texture | metal r g b fuzz
+//                 | dielectric ior
+//   sphere material x y z radius [to x y z]
+//   quad material qx qy qz ux uy uz vx vy vz
+//   mesh material path
+//   group name ... end
+//   instance group [tx ty tz] [translate x y z | rotate ax ay az deg
+//                             | scale s | scale sx sy sz]...
+//
+// Several key/value pairs may share a camera or render line. The optional
+// adaptive counts are the least and most samples a pixel takes (see
+// CameraSettings). Names must be declared before use. Meshes are OBJ or PLY files (see MeshLoader.hpp) with
+// paths relative to the scene file. A group's primitives are built into one
+// acceleration structure, using the accelerator chosen before its first
+// instance, which every instance shares; the steps of an instance are
+// applied in the order given. Image paths are looked up once, relative to
+// the scene file, then in each imagepath directory in the order given
+// (relative to the scene file too), then where RTWImage::FindFile looks.
+// Images are loaded in parallel once the whole file is read. They are
+// filtered trilinearly over their mip maps unless another filter is named.
+// With a texcache budget they are paged in tiles from a tiled copy of each
+// image, written beside it on first use, instead of being loaded whole.
+
+namespace polaris::scene {
+
+struct SceneLoadStats {
+  double parse_ms = 0.0;           // Reading, parsing and building objects
+  std::size_t bytes = 0;           // Size of the scene text
+  std::size_t line_count = 0;
+  std::size_t primitive_count = 0;
+  std::size_t triangle_count = 0;  // Over all placed meshes
+  std::size_t instance_count = 0;
+  std::size_t primitive_bytes = 0;  // Primitive records, not BVH or meshes
+  bool from_cache = false;         // Mapped from an up to date scene cache
+  double texture_ms = 0.0;         // Loading images, within parse_ms
+  // Why a scene loaded through a scene cache was parsed instead, if it was
+  std::string cache_skipped;
+  std::vector<TextureLoad> textures;  // Each image texture, in scene order
+};
+
+struct Scene {
+  CameraSettings settings;
+  math::Vec3 look_from{0, 0, 0};
+  math::Vec3 look_at{0, 0, -1};
+  math::AcceleratorType accelerator = math::AcceleratorType::Flat;
+  std::size_t texture_cache_bytes = 0;  // See SceneDescription
+  HittableList world;
+  material::MaterialTable materials;  // By the indices hits carry
+  // Acceleration structure that came ready-built with the scene, as from a
+  // scene cache; `world` is empty then
+  std::shared_ptr<Hittable> prebuilt;
+  SceneLoadStats stats;
+};
+
+// Parses a scene file. Errors name the line they were found on.
+[[nodiscard]] std::expected<Scene, std::string> LoadScene(
+    const std::filesystem::path& path);
+
+// Parses scene text that is already in memory. Mesh paths are relative to
+// `directory`.
+[[nodiscard]] std::expected<Scene, std::string> ParseScene(
+    std::string_view text, const std::filesystem::path& directory = {});
+
+// Parses scene text without building any objects but meshes
+[[nodiscard]] std::expected<SceneDescription, std::string>
+ParseSceneDescription(std::string_view text,
+                      const std::filesystem::path& directory = {});
+
+// Builds the objects of a description ParseSceneDescription() returned, as
+// ParseScene() would have. Only the size of the text and the load time are
+// left for the caller to fill in.
+[[nodiscard]] Scene BuildScene(const SceneDescription& desc);
+
+// Output formats and tone map operators by the names render statements
+// give them, for other front ends. Unknown names give std::nullopt.
+[[nodiscard]] std::optional<image::FileFormat> ParseFileFormat(
+    std::string_view name);
+[[nodiscard]] std::optional<image::ToneMapOperator> ParseToneMapOperator(
+    std::string_view name);
+
+}  // namespace polaris::scene
+
+#endif
@@ -6,14 +6,14 @@
 #include "scene/Hittable.hpp"
 
 namespace polaris::scene::material {
-class Dielectric : public Material {
+class Dielectric final : public Material {
 public:
   Dielectric(double refraction_index) : refraction_index_(refraction_index) {}
   ~Dielectric() override = default;
 
   bool Scatter(const math::Ray& in, const scene::HitInfo& info,
-                 image::PixelF64& attenuation,
-                 math::Ray& scattered) const noexcept override {
+                 image::PixelF64& attenuation, math::Ray& scattered,
+                 sampler::Sampler& sampler) const noexcept override {
     attenuation = image::PixelF64(1.0, 1.0, 1.0);
     double ri = info.front_face_ ? (1.0 / refraction_index_) : refraction_index_;
 
@@ -25,12 +25,14 @@ public:
     const bool cannot_refract = ri * sin_theta > 1.0;
     math::Vec3 direction;
 
-    if (cannot_refract || Reflectance(cos_theta, ri) > math::RandomDouble()) {
+    // Always draw, so later bounces see the same dimensions either way
+    const double u = sampler.Get1D();
+    if (cannot_refract || Reflectance(cos_theta, ri) > u) {
       direction = unit_direction.Reflect(info.normal_);
     } else {
       direction = unit_direction.Refract(info.normal_, ri);
     }
-    scattered = math::Ray(info.point_, direction, in.Time());
+    scattered = math::Ray(info.SpawnOrigin(direction), direction, in.Time());
     return true;
   }
 
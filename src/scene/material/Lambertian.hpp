@@ -4,38 +4,50 @@
 #include <image/Pixel.hpp>
 #include <math/Ray.hpp>
 #include <math/Vec.hpp>
+#include <memory>
 #include <scene/Hittable.hpp>
 #include <scene/material/Material.hpp>
 #include <scene/texture/Texture.hpp>
-#include <scene/texture/SolidColour.hpp>
 #include <utility>
 
 namespace polaris::scene::material {
 
-class Lambertian : public Material {
+// A constant albedo is kept inline, so only textures that vary cost a
+// virtual call per scattered ray.
+class Lambertian final : public Material {
  public:
-  explicit Lambertian(const image::PixelF64& albedo)
-    : texture_(std::make_shared<texture::SolidColour>(albedo)) {}
-  explicit Lambertian(std::shared_ptr<texture::Texture> texture)
-    : texture_(std::move(texture)) {}
+  explicit Lambertian(const image::PixelF64& albedo) : albedo_(albedo) {}
+  explicit Lambertian(std::shared_ptr<texture::Texture> texture) {
+    if (const auto constant = texture->ConstantValue()) {
+      albedo_ = *constant;
+    } else {
+      texture_ = std::move(texture);
+    }
+  }
   ~Lambertian() override = default;
 
   bool Scatter(const math::Ray& in, const scene::HitInfo& info,
-               image::PixelF64& attenuation,
-               math::Ray& scattered) const noexcept override {
-    auto scatter_direction = info.normal_ + math::Vec3::RandomUnitVector();
+               image::PixelF64& attenuation, math::Ray& scattered,
+               sampler::Sampler& sampler) const noexcept override {
+    auto scatter_direction =
+        info.normal_ + math::Vec3::RandomUnitVector(sampler);
 
     if (scatter_direction.NearZero()) {
       scatter_direction = info.normal_;
     }
 
-    scattered = math::Ray(info.point_, scatter_direction, in.Time());
-    attenuation = texture_->Value(info.u_, info.v_, info.point_);
+    scattered = math::Ray(info.SpawnOrigin(scatter_direction),
+                          scatter_direction, in.Time());
+    attenuation =
+        texture_ ? texture_->Filtered(info.u_, info.v_, info.point_,
+                                      info.footprint_)
+                 : albedo_;
     return true;
   }
 
  private:
-  std::shared_ptr<texture::Texture> texture_;
+  image::PixelF64 albedo_;
+  std::shared_ptr<texture::Texture> texture_;  // Null for a constant albedo
 };
 }  // namespace polaris::scene::material
 
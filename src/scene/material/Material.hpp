@@ -1,18 +1,15 @@
 #ifndef POLARIS_SCENE_MATERIAL_HPP
 #define POLARIS_SCENE_MATERIAL_HPP
 
+#include <concepts>
 #include <image/Pixel.hpp>
-
-namespace polaris::math {
-class Ray;
-} // namespace polaris::math
-
-namespace polaris::image {
-class PixelF64;
-} // namespace polaris::image
+#include <math/Ray.hpp>
+#include <scene/sampler/Sampler.hpp>
 
 namespace polaris::scene {
-struct HitInfo;
+template <std::floating_point T>
+struct BasicHitInfo;
+using HitInfo = BasicHitInfo<math::Real>;
 } // namespace polaris::scene
 
 namespace polaris::scene::material {
@@ -25,13 +22,16 @@ class Material {
   Material& operator=(Material&&) = default;
   virtual ~Material() = default;
 
+  // Random decisions draw from `sampler`, which the camera has positioned at
+  // the current path vertex.
   virtual bool Scatter(const math::Ray& in, const scene::HitInfo& hit,
-                       image::PixelF64& attenuation,
-                       math::Ray& scattered) const noexcept {
+                       image::PixelF64& attenuation, math::Ray& scattered,
+                       sampler::Sampler& sampler) const noexcept {
     (void)in;
     (void)hit;
     (void)attenuation;
     (void)scattered;
+    (void)sampler;
     return false;
   }
 
@@ -0,0 +1,52 @@
+#ifndef POLARIS_SCENE_MATERIAL_MATERIAL_TABLE_HPP
+#define POLARIS_SCENE_MATERIAL_MATERIAL_TABLE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <image/Pixel.hpp>
+#include <math/Ray.hpp>
+#include <scene/Hittable.hpp>
+#include <scene/material/Dielectric.hpp>
+#include <scene/material/Lambertian.hpp>
+#include <scene/material/Metal.hpp>
+#include <scene/sampler/Sampler.hpp>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace polaris::scene::material {
+
+// A material held by value. The alternatives are final, so scattering is a
+// switch over them that the compiler can inline rather than a virtual call.
+using AnyMaterial = std::variant<Lambertian, Metal, Dielectric>;
+
+// Every material of a scene, by the index hits record in HitInfo::material_
+class MaterialTable {
+ public:
+  // Returns the index hits on surfaces of `material` carry
+  std::uint32_t Add(AnyMaterial material) {
+    materials_.push_back(std::move(material));
+    return static_cast<std::uint32_t>(materials_.size() - 1);
+  }
+
+  // Material::Scatter() of the material at `index`
+  [[nodiscard]] bool Scatter(std::uint32_t index, const math::Ray& in,
+                             const HitInfo& hit, image::PixelF64& attenuation,
+                             math::Ray& scattered,
+                             sampler::Sampler& sampler) const noexcept {
+    return std::visit(
+        [&](const auto& material) {
+          return material.Scatter(in, hit, attenuation, scattered, sampler);
+        },
+        materials_[index]);
+  }
+
+  [[nodiscard]] std::size_t Size() const { return materials_.size(); }
+
+ private:
+  std::vector<AnyMaterial> materials_;
+};
+
+}  // namespace polaris::scene::material
+
+#endif
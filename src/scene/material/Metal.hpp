@@ -10,18 +10,18 @@
 
 namespace polaris::scene::material {
 
-class Metal : public Material {
+class Metal final : public Material {
  public:
   Metal(const image::PixelF64& albedo, double fuzz)
       : albedo_(albedo), fuzz_(std::clamp(fuzz, 0.0, 1.0)) {}
   ~Metal() override = default;
 
   bool Scatter(const math::Ray& in, const scene::HitInfo& info,
-               image::PixelF64& attenuation,
-               math::Ray& scattered) const noexcept override {
+               image::PixelF64& attenuation, math::Ray& scattered,
+               sampler::Sampler& sampler) const noexcept override {
     auto reflected = in.Direction().Normalized().Reflect(info.normal_);
-    reflected = reflected + (fuzz_ * math::Vec3::RandomUnitVector());
-    scattered = math::Ray(info.point_, reflected, in.Time());
+    reflected = reflected + (fuzz_ * math::Vec3::RandomUnitVector(sampler));
+    scattered = math::Ray(info.SpawnOrigin(reflected), reflected, in.Time());
     attenuation = albedo_;
     return (scattered.Direction().Dot(info.normal_) > 0);
   }
@@ -0,0 +1,55 @@
+#include <scene/objects/Instance.hpp>
+#include <utility>
+
+namespace polaris::scene::objects {
+
+Instance::Instance(std::shared_ptr<const Hittable> object,
+                   const math::Transform& to_world)
+    : object_(std::move(object)),
+      to_world_(to_world),
+      to_object_(to_world.Inverse()),
+      bb_(to_world.Bounds(object_->GetBounds())) {}
+
+bool Instance::Hit(const math::Ray& r, const math::Interval& t_interval,
+                   HitInfo& rec) const {
+  // The object space ray keeps the parameterisation of `r`, so t_interval
+  // and the distance found carry over unchanged
+  if (!object_->Hit(to_object_(r), t_interval, rec)) {
+    return false;
+  }
+  ToWorld(to_world_, r, rec);
+  return true;
+}
+
+int Instance::HitPacket(const math::RayPacket& packet, int mask,
+                        double t_min, PacketDistances& t_max,
+                        PacketHitInfo& rec) const {
+  math::RayPacket local;
+  for (int lane = 0; lane < math::RayPacket::kWidth; ++lane) {
+    if ((mask & (1 << lane)) != 0) {
+      local.Set(lane, to_object_(packet[lane]));
+    }
+  }
+
+  const int hits = object_->HitPacket(local, mask, t_min, t_max, rec);
+  for (int lane = 0; lane < math::RayPacket::kWidth; ++lane) {
+    if ((hits & (1 << lane)) != 0) {
+      ToWorld(to_world_, packet[lane], rec[lane]);
+    }
+  }
+  return hits;
+}
+
+void Instance::ToWorld(const math::Transform& to_world, const math::Ray& r,
+                       HitInfo& rec) {
+  // The facing of the normal survives the transform, as the sign of its dot
+  // product with the ray direction does
+  rec.point_ = r.at(rec.t_);
+  // The normal shrinks by the scale the transform grows lengths by
+  const auto normal = to_world.Normal(rec.normal_);
+  const auto length = normal.Length();
+  rec.normal_ = normal / length;
+  rec.uv_density_ *= static_cast<float>(length);
+}
+
+}  // namespace polaris::scene::objects
@@ -0,0 +1,45 @@
+#ifndef POLARIS_SCENE_OBJECTS_INSTANCE_HPP
+#define POLARIS_SCENE_OBJECTS_INSTANCE_HPP
+
+#include <math/AABB.hpp>
+#include <math/Ray.hpp>
+#include <math/Transform.hpp>
+#include <memory>
+#include <scene/Hittable.hpp>
+
+namespace polaris::scene::objects {
+
+// Places a shared object, usually the BVH of a group, in the world through an
+// affine transform. Rays are taken into object space instead of the object
+// being copied, so any number of instances cost one object and one transform
+// each.
+class Instance : public Hittable {
+ public:
+  Instance(std::shared_ptr<const Hittable> object,
+           const math::Transform& to_world);
+
+  [[nodiscard]] bool Hit(const math::Ray& r, const math::Interval& t_interval,
+                         HitInfo& rec) const override;
+
+  [[nodiscard]] int HitPacket(const math::RayPacket& packet, int mask,
+                              double t_min, PacketDistances& t_max,
+                              PacketHitInfo& rec) const override;
+
+  [[nodiscard]] math::AABB GetBounds() const override { return bb_; }
+
+  // Turns `rec`, filled in for the object space version of the world ray
+  // `r`, into a world space record. Shared with instances stored outside
+  // this class.
+  static void ToWorld(const math::Transform& to_world, const math::Ray& r,
+                      HitInfo& rec);
+
+ private:
+  std::shared_ptr<const Hittable> object_;
+  math::Transform to_world_;
+  math::Transform to_object_;
+  math::AABB bb_;
+};
+
+}  // namespace polaris::scene::objects
+
+#endif
@@ -1,37 +1,87 @@
+#include <math/simd/PacketKernels.hpp>
 #include <scene/objects/Quad.hpp>
 
 namespace polaris::scene::objects {
 bool Quad::Hit(const math::Ray& r, const math::Interval& t_interval,
                 HitInfo& rec) const {
-    auto demon = normal_.Dot(r.Direction());
+    math::Real t = 0;
+    math::Real alpha = 0;
+    math::Real beta = 0;
+    if(!HitPlane(Q_, u_, v_, w_, normal_, D_, r, t_interval, t, alpha, beta)) {
+        return false;
+    }
+
+    if(!IsInterior(alpha, beta, rec)) {
+        return false;
+    }
+
+    rec.t_ = t;
+    rec.point_ = r.at(t);
+    rec.material_ = mat_;
+    rec.uv_density_ = UvDensity(w_);
+    rec.SetNormal(r, normal_);
+
+    return true;
+}
+
+bool Quad::HitPlane(const math::Vec3& q, const math::Vec3& u,
+                    const math::Vec3& v, const math::Vec3& w,
+                    const math::Vec3& normal, math::Real d, const math::Ray& r,
+                    const math::Interval& t_interval, math::Real& t,
+                    math::Real& alpha, math::Real& beta) {
+    auto demon = normal.Dot(r.Direction());
 
     if(std::fabs(demon) < 1e-8) {
         return false;
     }
 
-    auto t = (D_ - normal_.Dot(r.Origin())) / demon;
+    t = (d - normal.Dot(r.Origin())) / demon;
     if(!t_interval.Contains(t)) {
         return false;
     }
 
-    auto intersection = r.at(t);
-    math::Vec3 planar_hitpt_vector = intersection - Q_;
-    auto alpha = w_.Dot(planar_hitpt_vector.Cross(v_));
-    auto beta = w_.Dot(u_.Cross(planar_hitpt_vector));
+    math::Vec3 planar_hitpt_vector = r.at(t) - q;
+    alpha = w.Dot(planar_hitpt_vector.Cross(v));
+    beta = w.Dot(u.Cross(planar_hitpt_vector));
+    return true;
+}
 
-    if(!IsInterior(alpha, beta, rec)) {
-        return false;
+int Quad::HitPacket(const math::RayPacket& packet, int mask, double t_min,
+                    PacketDistances& t_max, PacketHitInfo& rec) const {
+    math::simd::QuadParams params{};
+    for (std::size_t a = 0; a < 3; ++a) {
+        params.q[a] = Q_[a];
+        params.u[a] = u_[a];
+        params.v[a] = v_[a];
+        params.w[a] = w_[a];
+        params.normal[a] = normal_[a];
     }
+    params.d = D_;
 
-    rec.t_ = t;
-    rec.point_ = intersection;
-    rec.material_ = mat_;
-    rec.SetNormal(r, normal_);
+    PacketDistances t{};
+    PacketDistances alpha{};
+    PacketDistances beta{};
+    const int hits = math::simd::GetPacketKernels().quad(
+        packet.Lanes(), params, t_min, t_max.data(), mask, t.data(),
+        alpha.data(), beta.data());
 
-    return true;
+    for (int lane = 0; lane < math::RayPacket::kWidth; ++lane) {
+        if ((hits & (1 << lane)) != 0) {
+            const auto& r = packet[lane];
+            t_max[lane] = t[lane];
+            rec[lane].t_ = t[lane];
+            rec[lane].point_ = r.at(t[lane]);
+            rec[lane].u_ = alpha[lane];
+            rec[lane].v_ = beta[lane];
+            rec[lane].material_ = mat_;
+            rec[lane].uv_density_ = UvDensity(w_);
+            rec[lane].SetNormal(r, normal_);
+        }
+    }
+    return hits;
 }
 
-bool Quad::IsInterior(double a, double b, HitInfo& rec) const {
+bool Quad::IsInterior(math::Real a, math::Real b, HitInfo& rec) const {
     math::Interval unit_interval = math::Interval(0, 1);
 
     if(!unit_interval.Contains(a) || !unit_interval.Contains(b)) {
@@ -3,15 +3,15 @@
 
 #include <scene/Hittable.hpp>
 #include <math/AABB.hpp>
-#include <scene/material/Material.hpp>
-#include <utility>
+#include <cmath>
+#include <cstdint>
 #include <math/Vec.hpp>
 
 namespace polaris::scene::objects {
 class Quad : public Hittable {
 public:
-    Quad(const math::Vec3& q, const math::Vec3& u, const math::Vec3 v, std::shared_ptr<material::Material> mat)
-    : Q_(q), u_(u), v_(v), mat_(std::move(mat))
+    Quad(const math::Vec3& q, const math::Vec3& u, const math::Vec3 v, std::uint32_t mat)
+    : Q_(q), u_(u), v_(v), mat_(mat)
     {
         auto n = u.Cross(v);
         normal_ = n.Normalized();
@@ -29,7 +29,31 @@ public:
     [[nodiscard]] bool Hit(const math::Ray& r, const math::Interval& t_interval,
                          HitInfo& rec) const override;
 
-    [[nodiscard]] virtual bool IsInterior(double a, double b, HitInfo& rec) const;
+    // Uses the parallelogram interior test of the packet kernels, so shapes
+    // that override IsInterior must override this as well.
+    [[nodiscard]] int HitPacket(const math::RayPacket& packet, int mask,
+                                double t_min, PacketDistances& t_max,
+                                PacketHitInfo& rec) const override;
+
+    [[nodiscard]] virtual bool IsInterior(math::Real a, math::Real b,
+                                          HitInfo& rec) const;
+
+    // Plane test shared with quads stored outside this class. Finds where
+    // `r` crosses the plane of (q, u, v) within t_interval and the planar
+    // coordinates (alpha, beta) of that point along u and v.
+    [[nodiscard]] static bool HitPlane(const math::Vec3& q, const math::Vec3& u,
+                                       const math::Vec3& v, const math::Vec3& w,
+                                       const math::Vec3& normal, math::Real d,
+                                       const math::Ray& r,
+                                       const math::Interval& t_interval,
+                                       math::Real& t, math::Real& alpha,
+                                       math::Real& beta);
+
+    // HitInfo::uv_density_ of a quad with plane term `w`: one over the
+    // square root of its area, as |w| is one over the area
+    [[nodiscard]] static float UvDensity(const math::Vec3& w) {
+        return static_cast<float>(std::sqrt(w.Length()));
+    }
     
     [[nodiscard]] math::AABB GetBounds() const override { return bb_; }
 
@@ -38,10 +62,10 @@ private:
     math::Vec3 u_;
     math::Vec3 v_;
     math::Vec3 w_;
-    std::shared_ptr<material::Material> mat_;
+    std::uint32_t mat_ = 0;
     math::AABB bb_;
     math::Vec3 normal_;
-    double D_;
+    math::Real D_;
 };
 } // namespace polaris::scene::objects
 
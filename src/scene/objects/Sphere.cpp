@@ -1,13 +1,26 @@
+#include <math/simd/PacketKernels.hpp>
+#include <numbers>
 #include <scene/objects/Sphere.hpp>
 
 namespace polaris::scene::objects {
 bool Sphere::Hit(const math::Ray& r, const math::Interval& t_interval,
                  HitInfo& rec) const {
-  math::Vec3 current_center = center_.at(r.Time());
-  math::Vec3 oc = current_center - r.Origin();
+  math::Real t = 0;
+  if (!Intersect(center_.at(r.Time()), radius_, r, t_interval, t)) {
+    return false;
+  }
+
+  FillHitInfo(r, t, rec);
+  return true;
+}
+
+bool Sphere::Intersect(const math::Vec3& centre, math::Real radius,
+                       const math::Ray& r, const math::Interval& t_interval,
+                       math::Real& t) {
+  math::Vec3 oc = centre - r.Origin();
   auto a = r.Direction().LengthSquared();
   auto h = r.Direction().Dot(oc);
-  auto c = oc.LengthSquared() - (radius_ * radius_);
+  auto c = oc.LengthSquared() - (radius * radius);
 
   auto discriminant = (h * h) - (a * c);
   if (discriminant < 0) {
@@ -17,7 +30,7 @@ bool Sphere::Hit(const math::Ray& r, const math::Interval& t_interval,
   auto sqrtd = std::sqrt(discriminant);
 
   auto root_times_a = h - sqrtd;
-  auto t = root_times_a / a;
+  t = root_times_a / a;
   if (!t_interval.Surrounds(t)) {
     root_times_a = h + sqrtd;
     t = root_times_a / a;
@@ -25,18 +38,52 @@ bool Sphere::Hit(const math::Ray& r, const math::Interval& t_interval,
       return false;
     }
   }
+  return true;
+}
+
+int Sphere::HitPacket(const math::RayPacket& packet, int mask, double t_min,
+                      PacketDistances& t_max, PacketHitInfo& rec) const {
+  math::simd::SphereParams params{};
+  for (std::size_t a = 0; a < 3; ++a) {
+    params.center[a] = center_.Origin()[a];
+    params.velocity[a] = center_.Direction()[a];
+  }
+  params.radius = radius_;
+
+  PacketDistances t{};
+  const int hits = math::simd::GetPacketKernels().sphere(
+      packet.Lanes(), params, t_min, t_max.data(), mask, t.data());
 
+  for (int lane = 0; lane < math::RayPacket::kWidth; ++lane) {
+    if ((hits & (1 << lane)) != 0) {
+      t_max[lane] = t[lane];
+      FillHitInfo(packet[lane], t[lane], rec[lane]);
+    }
+  }
+  return hits;
+}
+
+void Sphere::FillHitInfo(const math::Ray& r, math::Real t,
+                         HitInfo& rec) const {
+  FillHitInfo(center_.at(r.Time()), radius_, r, t, rec);
+  rec.material_ = material_;
+}
+
+void Sphere::FillHitInfo(const math::Vec3& centre, math::Real radius,
+                         const math::Ray& r, math::Real t, HitInfo& rec) {
   rec.t_ = t;
   rec.point_ = r.at(t);
-  const math::Vec3 outward_normal = (rec.point_ - current_center) / radius_;
+  const math::Vec3 outward_normal = (rec.point_ - centre) / radius;
   rec.SetNormal(r, outward_normal);
   GetSphereUV(outward_normal, rec.u_, rec.v_);
-  rec.material_ = material_;
-
-  return true;
+  // u spans the equator and v half of it; this is the geometric mean of
+  // both rates there
+  rec.uv_density_ =
+      static_cast<float>(1 / (std::numbers::pi * std::numbers::sqrt2 * radius));
 }
 
-void Sphere::GetSphereUV(const math::Vec3& point, double& u, double& v) {
+void Sphere::GetSphereUV(const math::Vec3& point, math::Real& u,
+                         math::Real& v) {
   auto theta = std::acos(-point.Y());
   auto phi = std::atan2(-point.Z(), point.X()) + std::numbers::pi;
 
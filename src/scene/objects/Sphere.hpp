@@ -5,27 +5,26 @@
 #include <math/Ray.hpp>
 #include <math/Vec.hpp>
 #include <scene/Hittable.hpp>
-#include <scene/material/Material.hpp>
-#include <utility>
+#include <cstdint>
 
 namespace polaris::scene::objects {
 class Sphere : public Hittable {
  public:
   // Stationary Sphere
-  Sphere(const math::Vec3& static_centre, const double radius,
-          std::shared_ptr<material::Material> mat)
+  Sphere(const math::Vec3& static_centre, const math::Real radius,
+          std::uint32_t mat)
             : center_(static_centre, math::Vec3(0, 0, 0)),
               radius_(std::fmax(0, radius)),
-              material_(std::move(mat)) {
+              material_(mat) {
     auto r = math::Vec3(radius, radius, radius);
     bb_ = math::AABB(static_centre - r, static_centre + r);
   }
 
   Sphere(const math::Vec3& center1, const math::Vec3& center2,
-          const double radius, std::shared_ptr<material::Material> mat)
+          const math::Real radius, std::uint32_t mat)
             : center_(center1, center2 - center1),
               radius_(std::fmax(0, radius)),
-              material_(std::move(mat)) {
+              material_(mat) {
     auto r = math::Vec3(radius, radius, radius);
     const math::AABB box1(center_.at(0) - r, center_.at(0) + r);
     const math::AABB box2(center_.at(1) - r, center_.at(1) + r);
@@ -35,14 +34,32 @@ class Sphere : public Hittable {
   [[nodiscard]] bool Hit(const math::Ray& r, const math::Interval& t_interval,
                          HitInfo& rec) const override;
 
+  [[nodiscard]] int HitPacket(const math::RayPacket& packet, int mask,
+                              double t_min, PacketDistances& t_max,
+                              PacketHitInfo& rec) const override;
+
   [[nodiscard]] math::AABB GetBounds() const override { return bb_; }
 
-  static void GetSphereUV(const math::Vec3& point, double& u, double& v);
+  static void GetSphereUV(const math::Vec3& point, math::Real& u,
+                          math::Real& v);
+
+  // Geometry of a hit, shared with spheres stored outside this class. Finds
+  // the nearest t in t_interval where `r` meets the sphere at `centre`.
+  [[nodiscard]] static bool Intersect(const math::Vec3& centre,
+                                      math::Real radius, const math::Ray& r,
+                                      const math::Interval& t_interval,
+                                      math::Real& t);
+
+  // Fills everything in `rec` but the material
+  static void FillHitInfo(const math::Vec3& centre, math::Real radius,
+                          const math::Ray& r, math::Real t, HitInfo& rec);
 
  private:
+  void FillHitInfo(const math::Ray& r, math::Real t, HitInfo& rec) const;
+
   math::Ray center_;
-  double radius_ = 0.0;
-  std::shared_ptr<material::Material> material_;
+  math::Real radius_ = 0;
+  std::uint32_t material_ = 0;
   math::AABB bb_;
 };
 }  // namespace polaris::scene::objects
@@ -0,0 +1,276 @@
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <scene/objects/TriangleMesh.hpp>
+#include <utility>
+
+namespace polaris::scene::objects {
+namespace {
+using math::Real;
+
+// Ray prepared for the watertight test of Woop, Benthin and Wald
+// ("Watertight Ray/Triangle Intersection", JCGT 2013). Axes are permuted
+// and sheared so the ray runs along +z from the origin; a triangle is then
+// hit when its three 2D edge functions agree in sign. Both triangles on an
+// edge evaluate it the same way, so rays cannot slip through the seam.
+struct ShearedRay {
+  ShearedRay() = default;
+
+  explicit ShearedRay(const math::Ray& r) : origin(r.Origin()) {
+    const auto& d = r.Direction();
+    kz = 0;
+    for (int a = 1; a < 3; ++a) {
+      if (std::fabs(d[a]) > std::fabs(d[kz])) {
+        kz = a;
+      }
+    }
+    kx = (kz + 1) % 3;
+    ky = (kx + 1) % 3;
+    // Keeps the winding of the edge functions independent of direction
+    if (d[kz] < 0) {
+      std::swap(kx, ky);
+    }
+    sx = d[kx] / d[kz];
+    sy = d[ky] / d[kz];
+    sz = 1 / d[kz];
+  }
+
+  math::Vec3 origin;
+  int kx = 0;
+  int ky = 1;
+  int kz = 2;
+  Real sx = 0;
+  Real sy = 0;
+  Real sz = 0;
+};
+
+// Finds where `ray` crosses the triangle within (t_min, t_max) along with
+// the barycentric weights of its second and third corners
+bool IntersectTriangle(const ShearedRay& ray, const math::Vec3& p0,
+                       const math::Vec3& p1, const math::Vec3& p2, Real t_min,
+                       Real t_max, Real& t, Real& b1, Real& b2) {
+  const auto a = p0 - ray.origin;
+  const auto b = p1 - ray.origin;
+  const auto c = p2 - ray.origin;
+
+  const Real ax = a[ray.kx] - (ray.sx * a[ray.kz]);
+  const Real ay = a[ray.ky] - (ray.sy * a[ray.kz]);
+  const Real bx = b[ray.kx] - (ray.sx * b[ray.kz]);
+  const Real by = b[ray.ky] - (ray.sy * b[ray.kz]);
+  const Real cx = c[ray.kx] - (ray.sx * c[ray.kz]);
+  const Real cy = c[ray.ky] - (ray.sy * c[ray.kz]);
+
+  Real u = (cx * by) - (cy * bx);
+  Real v = (ax * cy) - (ay * cx);
+  Real w = (bx * ay) - (by * ax);
+
+  // A zero edge function in float may be rounding; double settles it
+  if constexpr (sizeof(Real) == sizeof(float)) {
+    if (u == 0 || v == 0 || w == 0) {
+      u = static_cast<Real>((double(cx) * by) - (double(cy) * bx));
+      v = static_cast<Real>((double(ax) * cy) - (double(ay) * cx));
+      w = static_cast<Real>((double(bx) * ay) - (double(by) * ax));
+    }
+  }
+
+  if ((u < 0 || v < 0 || w < 0) && (u > 0 || v > 0 || w > 0)) {
+    return false;
+  }
+  const Real det = u + v + w;
+  if (det == 0) {
+    return false;
+  }
+
+  const Real az = ray.sz * a[ray.kz];
+  const Real bz = ray.sz * b[ray.kz];
+  const Real cz = ray.sz * c[ray.kz];
+  const Real inv_det = 1 / det;
+  t = ((u * az) + (v * bz) + (w * cz)) * inv_det;
+  if (!(t > t_min && t < t_max)) {
+    return false;
+  }
+  b1 = v * inv_det;
+  b2 = w * inv_det;
+  return true;
+}
+
+// Bounds of a triangle grown by a few ulps of its coordinates. A ray through
+// a vertex or edge may only graze the exact box, and the slab test would drop
+// it to rounding, leaving a hole the triangle test itself does not have.
+math::AABB PaddedBounds(const math::Vec3& p0, const math::Vec3& p1,
+                        const math::Vec3& p2) {
+  constexpr Real kPadding = sizeof(Real) == sizeof(float) ? 0x1p-20 : 0x1p-48;
+  std::array<math::Interval, 3> axes;
+  for (std::size_t a = 0; a < 3; ++a) {
+    const auto lo = std::min({p0[a], p1[a], p2[a]});
+    const auto hi = std::max({p0[a], p1[a], p2[a]});
+    const auto pad = kPadding * std::max(std::fabs(lo), std::fabs(hi));
+    axes[a] = math::Interval(lo - pad, hi + pad);
+  }
+  return {axes[0], axes[1], axes[2]};
+}
+
+// Closest triangle found so far along one ray
+struct TriangleHit {
+  std::uint32_t triangle = 0;
+  Real t = 0;
+  Real b1 = 0;
+  Real b2 = 0;
+};
+
+void FillHitInfo(const MeshView& mesh, const TriangleHit& hit,
+                 const math::Ray& r, HitInfo& rec) {
+  const auto& triangle = mesh.triangles[hit.triangle];
+  const auto& p0 = mesh.vertices[triangle[0]];
+  const auto& p1 = mesh.vertices[triangle[1]];
+  const auto& p2 = mesh.vertices[triangle[2]];
+
+  rec.t_ = hit.t;
+  rec.point_ = r.at(hit.t);
+  rec.u_ = hit.b1;
+  rec.v_ = hit.b2;
+  // The barycentric triangle has area 1/2, the world one half of `length`
+  const auto normal = (p1 - p0).Cross(p2 - p0);
+  const auto length = normal.Length();
+  rec.SetNormal(r, normal / length);
+  rec.uv_density_ = static_cast<float>(1 / std::sqrt(length));
+}
+}  // namespace
+
+Mesh::Mesh(std::vector<math::Vec3> vertices,
+           std::vector<MeshTriangle> triangles,
+           const math::BVHBuildOptions& options)
+    : vertices_(std::move(vertices)) {
+  std::vector<math::AABB> bounds;
+  bounds.reserve(triangles.size());
+  for (const auto& triangle : triangles) {
+    bounds.push_back(PaddedBounds(vertices_[triangle[0]],
+                                  vertices_[triangle[1]],
+                                  vertices_[triangle[2]]));
+  }
+
+  std::vector<std::uint32_t> order;
+  stats_ = math::BuildFlatBVH(bounds, nodes_, order, options);
+
+  // Leaves then read a contiguous run of triangles
+  triangles_.reserve(order.size());
+  for (const auto index : order) {
+    triangles_.push_back(triangles[index]);
+  }
+}
+
+math::AABB Mesh::GetBounds() const {
+  return nodes_.empty() ? math::AABB() : nodes_.front().bounds_;
+}
+
+TriangleMesh::TriangleMesh(std::shared_ptr<const Mesh> mesh,
+                           std::uint32_t mat)
+    : mesh_(std::move(mesh)),
+      material_(mat),
+      bb_(mesh_->GetBounds()) {}
+
+bool TriangleMesh::Hit(const math::Ray& r, const math::Interval& t_interval,
+                       HitInfo& rec) const {
+  if (!HitView(mesh_->View(), r, t_interval, rec)) {
+    return false;
+  }
+  rec.material_ = material_;
+  return true;
+}
+
+int TriangleMesh::HitPacket(const math::RayPacket& packet, int mask,
+                            double t_min, PacketDistances& t_max,
+                            PacketHitInfo& rec) const {
+  const int hits =
+      HitViewPacket(mesh_->View(), packet, mask, t_min, t_max, rec);
+  for (int lane = 0; lane < math::RayPacket::kWidth; ++lane) {
+    if ((hits & (1 << lane)) != 0) {
+      rec[lane].material_ = material_;
+    }
+  }
+  return hits;
+}
+
+bool TriangleMesh::HitView(const MeshView& mesh, const math::Ray& r,
+                           const math::Interval& t_interval, HitInfo& rec) {
+  const ShearedRay ray(r);
+  TriangleHit best;
+
+  // Only the closest triangle's record is filled in, after the traversal
+  const bool hit = math::TraverseFlatBVH(
+      mesh.nodes, r, t_interval,
+      [&](std::uint32_t first, std::uint32_t count, Real t_min,
+          Real& closest_so_far) {
+        bool hit_anything = false;
+        for (auto i = first; i < first + count; ++i) {
+          const auto& triangle = mesh.triangles[i];
+          TriangleHit candidate{i};
+          if (IntersectTriangle(ray, mesh.vertices[triangle[0]],
+                                mesh.vertices[triangle[1]],
+                                mesh.vertices[triangle[2]], t_min,
+                                closest_so_far, candidate.t, candidate.b1,
+                                candidate.b2)) {
+            best = candidate;
+            closest_so_far = candidate.t;
+            hit_anything = true;
+          }
+        }
+        return hit_anything;
+      });
+
+  if (!hit) {
+    return false;
+  }
+  FillHitInfo(mesh, best, r, rec);
+  return true;
+}
+
+int TriangleMesh::HitViewPacket(const MeshView& mesh,
+                                const math::RayPacket& packet, int mask,
+                                double t_min, PacketDistances& t_max,
+                                PacketHitInfo& rec) {
+  constexpr int kWidth = math::RayPacket::kWidth;
+  std::array<ShearedRay, kWidth> rays;
+  for (int lane = 0; lane < kWidth; ++lane) {
+    if ((mask & (1 << lane)) != 0) {
+      rays[lane] = ShearedRay(packet[lane]);
+    }
+  }
+
+  // Triangles are the outer loop so each one's corners are fetched once for
+  // all lanes
+  std::array<TriangleHit, kWidth> best;
+  const int hits = math::TraverseFlatBVHPacket(
+      mesh.nodes, packet, mask, t_min, t_max,
+      [&](std::uint32_t first, std::uint32_t count, int lanes) {
+        int leaf_hits = 0;
+        for (auto i = first; i < first + count; ++i) {
+          const auto& triangle = mesh.triangles[i];
+          const auto& p0 = mesh.vertices[triangle[0]];
+          const auto& p1 = mesh.vertices[triangle[1]];
+          const auto& p2 = mesh.vertices[triangle[2]];
+          for (int lane = 0; lane < kWidth; ++lane) {
+            TriangleHit candidate{i};
+            if ((lanes & (1 << lane)) != 0 &&
+                IntersectTriangle(rays[lane], p0, p1, p2,
+                                  static_cast<Real>(t_min),
+                                  static_cast<Real>(t_max[lane]), candidate.t,
+                                  candidate.b1, candidate.b2)) {
+              best[lane] = candidate;
+              t_max[lane] = candidate.t;
+              leaf_hits |= 1 << lane;
+            }
+          }
+        }
+        return leaf_hits;
+      });
+
+  for (int lane = 0; lane < kWidth; ++lane) {
+    if ((hits & (1 << lane)) != 0) {
+      FillHitInfo(mesh, best[lane], packet[lane], rec[lane]);
+    }
+  }
+  return hits;
+}
+
+}  // namespace polaris::scene::objects
@@ -0,0 +1,89 @@
+#ifndef POLARIS_SCENE_OBJECTS_TRIANGLE_MESH_HPP
+#define POLARIS_SCENE_OBJECTS_TRIANGLE_MESH_HPP
+
+#include <array>
+#include <cstdint>
+#include <math/AABB.hpp>
+#include <math/FlatBVH.hpp>
+#include <math/Ray.hpp>
+#include <math/Vec.hpp>
+#include <memory>
+#include <scene/Hittable.hpp>
+#include <span>
+#include <vector>
+
+namespace polaris::scene::objects {
+
+// Indices of the three corners of a triangle in its mesh's vertex buffer
+using MeshTriangle = std::array<std::uint32_t, 3>;
+
+// A mesh and its BVH as plain arrays, whether owned by a Mesh or mapped from
+// a scene cache. Triangles are stored in the leaf order of the nodes.
+struct MeshView {
+  std::span<const math::FlatBVHNode> nodes;
+  std::span<const math::Vec3> vertices;
+  std::span<const MeshTriangle> triangles;
+};
+
+// Triangles sharing one vertex buffer, with a BVH of their own. A mesh is
+// immutable once built, so any number of objects can share it.
+class Mesh {
+ public:
+  // Every index in `triangles` must be below vertices.size()
+  Mesh(std::vector<math::Vec3> vertices, std::vector<MeshTriangle> triangles,
+       const math::BVHBuildOptions& options = {});
+
+  [[nodiscard]] MeshView View() const { return {nodes_, vertices_, triangles_}; }
+  [[nodiscard]] math::AABB GetBounds() const;
+
+  [[nodiscard]] std::size_t VertexCount() const { return vertices_.size(); }
+  [[nodiscard]] std::size_t TriangleCount() const { return triangles_.size(); }
+  [[nodiscard]] const math::BVHBuildStats& BuildStats() const {
+    return stats_;
+  }
+
+ private:
+  std::vector<math::Vec3> vertices_;
+  std::vector<MeshTriangle> triangles_;  // Leaf order
+  std::vector<math::FlatBVHNode> nodes_;
+  math::BVHBuildStats stats_;
+};
+
+// One material over a shared mesh
+class TriangleMesh : public Hittable {
+ public:
+  TriangleMesh(std::shared_ptr<const Mesh> mesh, std::uint32_t mat);
+
+  [[nodiscard]] bool Hit(const math::Ray& r, const math::Interval& t_interval,
+                         HitInfo& rec) const override;
+
+  [[nodiscard]] int HitPacket(const math::RayPacket& packet, int mask,
+                              double t_min, PacketDistances& t_max,
+                              PacketHitInfo& rec) const override;
+
+  [[nodiscard]] math::AABB GetBounds() const override { return bb_; }
+
+  [[nodiscard]] const Mesh& GetMesh() const { return *mesh_; }
+
+  // Traversal shared with meshes stored outside this class. Fills
+  // everything in `rec` but the material; (u, v) are the barycentric
+  // coordinates of the hit along the triangle's second and third corners.
+  [[nodiscard]] static bool HitView(const MeshView& mesh, const math::Ray& r,
+                                    const math::Interval& t_interval,
+                                    HitInfo& rec);
+
+  [[nodiscard]] static int HitViewPacket(const MeshView& mesh,
+                                         const math::RayPacket& packet,
+                                         int mask, double t_min,
+                                         PacketDistances& t_max,
+                                         PacketHitInfo& rec);
+
+ private:
+  std::shared_ptr<const Mesh> mesh_;
+  std::uint32_t material_ = 0;
+  math::AABB bb_;
+};
+
+}  // namespace polaris::scene::objects
+
+#endif
@@ -0,0 +1,17 @@
+#include <scene/sampler/Sampler.hpp>
+
+namespace polaris::scene::sampler {
+
+std::unique_ptr<Sampler> MakeSampler(SamplerType type, std::uint64_t seed) {
+  switch (type) {
+    case SamplerType::Sobol:
+      return std::make_unique<SobolSampler>(seed);
+    case SamplerType::Hash:
+      return std::make_unique<HashSampler>(seed);
+    case SamplerType::PCG:
+    default:
+      return std::make_unique<PcgSampler>(seed);
+  }
+}
+
+}  // namespace polaris::scene::sampler
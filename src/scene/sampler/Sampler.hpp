@@ -0,0 +1,161 @@
+#ifndef POLARIS_SCENE_SAMPLER_SAMPLER_HPP
+#define POLARIS_SCENE_SAMPLER_SAMPLER_HPP
+
+#include <array>
+#include <cstdint>
+#include <math/LowDiscrepancy.hpp>
+#include <math/Random.hpp>
+#include <memory>
+
+namespace polaris::scene::sampler {
+
+using Sample2D = std::array<double, 2>;
+
+// Source of the random numbers for one path at a time. Every value is a pure
+// function of (seed, pixel, sample index, dimension), where the dimension
+// counts the values drawn since StartPixelSample(). This keeps images
+// bit-identical for a given seed no matter which thread renders which tile.
+class Sampler {
+ public:
+  Sampler() = default;
+  Sampler(const Sampler&) = default;
+  Sampler& operator=(const Sampler&) = default;
+  Sampler(Sampler&&) = default;
+  Sampler& operator=(Sampler&&) = default;
+  virtual ~Sampler() = default;
+
+  // Positions the sampler at `dimension` of sample `index` of pixel (x, y)
+  virtual void StartPixelSample(int x, int y, std::uint32_t index,
+                                std::uint32_t dimension = 0) = 0;
+
+  // Uniform values in [0, 1)
+  [[nodiscard]] virtual double Get1D() = 0;
+  [[nodiscard]] virtual Sample2D Get2D() = 0;
+
+  // Independent copy for another render thread
+  [[nodiscard]] virtual std::unique_ptr<Sampler> Clone() const = 0;
+};
+
+// Runs one PCG32 stream per pixel and jumps to the sample's offset in it
+class PcgSampler final : public Sampler {
+ public:
+  explicit PcgSampler(std::uint64_t seed) : seed_(seed) {}
+
+  void StartPixelSample(int x, int y, std::uint32_t index,
+                        std::uint32_t dimension = 0) override {
+    rng_.SetSequence(math::Hash(x, y, seed_));
+    rng_.Advance((static_cast<std::uint64_t>(index) << 16U) + dimension);
+  }
+
+  [[nodiscard]] double Get1D() override { return rng_.Uniform<double>(); }
+
+  [[nodiscard]] Sample2D Get2D() override {
+    const auto u = rng_.Uniform<double>();
+    return {u, rng_.Uniform<double>()};
+  }
+
+  [[nodiscard]] std::unique_ptr<Sampler> Clone() const override {
+    return std::make_unique<PcgSampler>(*this);
+  }
+
+ private:
+  std::uint64_t seed_;
+  math::Pcg32 rng_;
+};
+
+// Stateless counter-based sampler: every value is a hash of its coordinates
+class HashSampler final : public Sampler {
+ public:
+  explicit HashSampler(std::uint64_t seed) : seed_(seed) {}
+
+  void StartPixelSample(int x, int y, std::uint32_t index,
+                        std::uint32_t dimension = 0) override {
+    pixel_hash_ = math::Hash(seed_, x, y, index);
+    dimension_ = dimension;
+  }
+
+  [[nodiscard]] double Get1D() override {
+    const auto bits = math::HashCombine(pixel_hash_, dimension_++);
+    return math::BitsToUnit<double>(static_cast<std::uint32_t>(bits >> 32U));
+  }
+
+  [[nodiscard]] Sample2D Get2D() override {
+    const auto u = Get1D();
+    return {u, Get1D()};
+  }
+
+  [[nodiscard]] std::unique_ptr<Sampler> Clone() const override {
+    return std::make_unique<HashSampler>(*this);
+  }
+
+ private:
+  std::uint64_t seed_;
+  std::uint64_t pixel_hash_ = 0;
+  std::uint32_t dimension_ = 0;
+};
+
+// Low-discrepancy sampler. Every pair of dimensions is a 2D Sobol sequence
+// over the pixel's samples, Owen scrambled and shuffled with a hash of the
+// pixel and dimension ("padded" Sobol, as in pbrt-v4), so pixel, lens, time
+// and each bounce are all stratified without the sequences correlating. The
+// shuffle keeps power-of-two prefixes stratified, so progressive and adaptive
+// rendering can stop at any such sample count, and maps them onto themselves,
+// so later samples continue the sequence rather than repeat it.
+class SobolSampler final : public Sampler {
+ public:
+  explicit SobolSampler(std::uint64_t seed) : seed_(seed) {}
+
+  void StartPixelSample(int x, int y, std::uint32_t index,
+                        std::uint32_t dimension = 0) override {
+    pixel_hash_ = math::Hash(x, y, seed_);
+    index_ = index;
+    dimension_ = dimension;
+  }
+
+  [[nodiscard]] double Get1D() override {
+    const auto hash = math::HashCombine(pixel_hash_, dimension_++);
+    const auto index = Permute(hash);
+    return Sample(index, 0, static_cast<std::uint32_t>(hash >> 32U));
+  }
+
+  [[nodiscard]] Sample2D Get2D() override {
+    const auto hash = math::HashCombine(pixel_hash_, dimension_);
+    dimension_ += 2;
+    const auto index = Permute(hash);
+    return {Sample(index, 0, static_cast<std::uint32_t>(hash)),
+            Sample(index, 1, static_cast<std::uint32_t>(hash >> 32U))};
+  }
+
+  [[nodiscard]] std::unique_ptr<Sampler> Clone() const override {
+    return std::make_unique<SobolSampler>(*this);
+  }
+
+ private:
+  [[nodiscard]] std::uint32_t Permute(std::uint64_t hash) const {
+    return math::NestedOwenScramble(index_, static_cast<std::uint32_t>(hash));
+  }
+
+  [[nodiscard]] static double Sample(std::uint32_t index, int dimension,
+                                     std::uint32_t scramble) {
+    return math::BitsToUnit<double>(
+        math::ScrambledSobolBits(index, dimension, scramble));
+  }
+
+  std::uint64_t seed_;
+  std::uint64_t pixel_hash_ = 0;
+  std::uint32_t index_ = 0;
+  std::uint32_t dimension_ = 0;
+};
+
+enum class SamplerType : std::uint8_t {
+  PCG = 0,  // PcgSampler
+  Hash,     // HashSampler
+  Sobol,    // SobolSampler
+};
+
+[[nodiscard]] std::unique_ptr<Sampler> MakeSampler(SamplerType type,
+                                                   std::uint64_t seed);
+
+}  // namespace polaris::scene::sampler
+
+#endif
@@ -1,32 +1,78 @@
 #ifndef POLARIS_SCENE_IMAGE_TEXTURE_HPP
 #define POLARIS_SCENE_IMAGE_TEXTURE_HPP
 
+#include <image/MipMap.hpp>
 #include <image/RTWImage.hpp>
+#include <image/TileCache.hpp>
+#include <image/TiledImage.hpp>
 #include <scene/texture/Texture.hpp>
 #include <math/Interval.hpp>
+#include <iostream>
+#include <memory>
 
 namespace polaris::scene::texture {
+// The image is kept only as its mip map; lookups through Filtered() use
+// `filter`, while Value() always takes the nearest full size texel. Given a
+// tile cache, the mip map stays on disk, in a tiled copy beside the image,
+// and is paged in through the cache. Images whose copy cannot be written
+// are loaded whole instead. `filename` is opened as given, not looked for;
+// see RTWImage::FindFile.
 class ImageTexture : public Texture {
 public:
-  explicit ImageTexture(const char* filename) : image_(filename) {}
+  explicit ImageTexture(const char* filename,
+                        image::TextureFilter filter = image::TextureFilter::Trilinear,
+                        image::TileCache* cache = nullptr)
+      : filter_(filter) {
+    if (cache != nullptr) {
+      image::TiledImage tiled;
+      if (tiled.OpenFor(filename)) {
+        paged_ = cache->Add(std::move(tiled));
+        return;
+      }
+    }
+    image::RTWImage image;
+    if (!image.load(filename)) {
+      std::cerr << "ERROR: Could not load image file '" << filename << "'.\n";
+      return;
+    }
+    mip_map_ = image::MipMap(image.Data(), image.Width(), image.Height());
+  }
 
   image::PixelF64 Value(double u, double v,
                         const math::Vec3  /*p*/) const noexcept override {
-    if (image_.Height() <= 0) { return image::PixelF64{0, 1, 1}; }
+    if (!IsLoaded()) { return image::PixelF64{0, 1, 1}; }
 
     u = math::Interval{0, 1}.Clamp(u);
     v = 1.0 - math::Interval{0, 1}.Clamp(v);
+    return paged_ ? image::NearestLookup(*paged_, 0, u, v)
+                  : image::NearestLookup(mip_map_, 0, u, v);
+  }
 
-    auto i = static_cast<int>(u * image_.Width());
-    auto j = static_cast<int>(v * image_.Height());
-    const auto *pixel = image_.PixelData(i, j);
+  image::PixelF64 Filtered(double u, double v, const math::Vec3 /*p*/,
+                           double width) const noexcept override {
+    if (!IsLoaded()) { return image::PixelF64{0, 1, 1}; }
+
+    u = math::Interval{0, 1}.Clamp(u);
+    v = 1.0 - math::Interval{0, 1}.Clamp(v);
+    return paged_ ? image::FilteredLookup(*paged_, filter_, u, v, width)
+                  : image::FilteredLookup(mip_map_, filter_, u, v, width);
+  }
 
-    auto color_scale = 1.0 / 255.0;
-    return {color_scale * pixel[0], color_scale * pixel[1], color_scale * pixel[2]};
+  [[nodiscard]] bool IsLoaded() const { return paged_ || !mip_map_.Empty(); }
+  [[nodiscard]] bool IsPaged() const { return paged_ != nullptr; }
+  // Of the full size image, or 0 if it was not loaded
+  [[nodiscard]] int Width() const {
+    return paged_ ? paged_->Width(0) : IsLoaded() ? mip_map_.Width(0) : 0;
+  }
+  [[nodiscard]] int Height() const {
+    return paged_ ? paged_->Height(0) : IsLoaded() ? mip_map_.Height(0) : 0;
   }
 
 private:
-  image::RTWImage image_;
+
+  image::MipMap mip_map_;
+  std::shared_ptr<image::PagedImage> paged_;
+  image::TextureFilter filter_;
 };
 } // namespace polaris::scene::texture
 
@@ -1,26 +1,31 @@
-#ifndef POLARIS_SCENE_IMAGE_TEXTURE_HPP
-#define POLARIS_SCENE_IMAGE_TEXTURE_HPP
+#ifndef POLARIS_SCENE_PERLIN_NOISE_HPP
+#define POLARIS_SCENE_PERLIN_NOISE_HPP
 
-#include <algorithm>
 #include <random>
+#include <utility>
 #include <scene/texture/Texture.hpp>
 #include <math/Interval.hpp>
-#include <image/RTWImage.hpp>
 #include <image/Pixel.hpp>
 #include <math/Common.hpp>
+#include <math/Random.hpp>
 #include <math/Vec.hpp>
 
 namespace polaris::scene {
 class Perlin {
 public:
+    // Gradients and permutations come from their own generator, so every
+    // noise texture is the same on every run whatever was drawn before it
     Perlin() {
+        math::Pcg32 generator;
         for(size_t i{}; i < point_count_; ++i) {
-            rand_vec_[i] = math::Vec3::RandomUnitVector();
+            const auto u1 = generator.Uniform<math::Real>();
+            const auto u2 = generator.Uniform<math::Real>();
+            rand_vec_[i] = math::Vec3::UnitVectorFromSample(u1, u2);
         }
 
-        PerlinGeneratePerm(perm_x_);
-        PerlinGeneratePerm(perm_y_);
-        PerlinGeneratePerm(perm_z_);
+        PerlinGeneratePerm(perm_x_, generator);
+        PerlinGeneratePerm(perm_y_, generator);
+        PerlinGeneratePerm(perm_z_, generator);
     }
 
     double Noise(const math::Vec3& point) const {
@@ -63,17 +68,17 @@ public:
     }
 
 private:
-    static void PerlinGeneratePerm(int* p)
+    // One Fisher-Yates pass
+    static void PerlinGeneratePerm(int* p, math::Pcg32& generator)
     {
         for(int i{}; i < point_count_; ++i) {
             p[i] = i;
         }
 
-        for(int i{}; i < point_count_ - 1; i++) {
-            std::random_device rd;
-            std::mt19937 gen(rd());
-            std::shuffle(p, p + point_count_, gen);
-        } 
+        for(int i = point_count_ - 1; i > 0; --i) {
+            std::uniform_int_distribution<int> distribution(0, i);
+            std::swap(p[i], p[distribution(generator)]);
+        }
     }
 
     static double PerlinInterpolation(const math::Vec3 c[2][2][2], double u, double v, double w) {
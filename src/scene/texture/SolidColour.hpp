@@ -15,6 +15,10 @@ public:
                         const math::Vec3  /*p*/) const noexcept override {
     return albedo_;
   }
+
+  std::optional<image::PixelF64> ConstantValue() const noexcept override {
+    return albedo_;
+  }
 private:
   image::PixelF64 albedo_;
 };
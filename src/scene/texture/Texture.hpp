@@ -2,6 +2,7 @@
 #define POLARIS_SCENE_TEXTURE_HPP
 
 #include <image/Pixel.hpp>
+#include <optional>
 
 namespace polaris::scene::texture {
 class Texture {
@@ -20,6 +21,19 @@ public:
     (void)p;
     return {0, 0, 0};
   }
+
+  // Value averaged over a footprint `width` wide in uv units around (u, v).
+  // Textures that are not filtered return Value().
+  virtual image::PixelF64 Filtered(double u, double v, const math::Vec3 p,
+                                   double width) const noexcept {
+    (void)width;
+    return Value(u, v, p);
+  }
+
+  // The value at every point, for textures that do not vary
+  virtual std::optional<image::PixelF64> ConstantValue() const noexcept {
+    return std::nullopt;
+  }
 };
 } // namespace polaris::scene::texture
 
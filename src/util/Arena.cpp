@@ -0,0 +1,40 @@
+#include <algorithm>
+#include <cstdint>
+#include <util/Arena.hpp>
+
+namespace polaris::util {
+
+void* Arena::Allocate(std::size_t bytes, std::size_t alignment) {
+  // Blocks past the current one are left over from before a Rewind()
+  for (; current_ < blocks_.size(); ++current_, used_ = 0) {
+    const auto& block = blocks_[current_];
+    const auto base = reinterpret_cast<std::uintptr_t>(block.data.get());
+    const auto start = (base + used_ + alignment - 1) & ~(alignment - 1);
+    if (start + bytes <= base + block.size) {
+      used_ = start + bytes - base;
+      return reinterpret_cast<void*>(start);
+    }
+  }
+
+  const auto size = std::max(next_block_size_, bytes + alignment);
+  next_block_size_ = std::min(next_block_size_ * 2, kMaxBlockSize);
+  blocks_.push_back({std::make_unique_for_overwrite<std::byte[]>(size), size});
+  current_ = blocks_.size() - 1;
+  used_ = 0;
+  return Allocate(bytes, alignment);
+}
+
+std::size_t Arena::BytesReserved() const {
+  std::size_t bytes = 0;
+  for (const auto& block : blocks_) {
+    bytes += block.size;
+  }
+  return bytes;
+}
+
+Arena& ThreadScratch() {
+  thread_local Arena scratch;
+  return scratch;
+}
+
+}  // namespace polaris::util
@@ -0,0 +1,108 @@
+#ifndef POLARIS_UTIL_ARENA_HPP
+#define POLARIS_UTIL_ARENA_HPP
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace polaris::util {
+
+// Monotonic allocator. Allocations are bumped off a few large blocks and only
+// given back all at once, by Rewind(), Reset() or destruction, so thousands
+// of small objects cost a handful of heap allocations. Objects made in an
+// arena are never destroyed and must be trivially destructible; they refer to
+// each other by plain pointers that stay valid for the arena's lifetime.
+class Arena {
+ public:
+  // Blocks start at `block_size` bytes and double up to a limit
+  explicit Arena(std::size_t block_size = kDefaultBlockSize)
+      : next_block_size_(block_size) {}
+
+  Arena(Arena&&) noexcept = default;
+  Arena& operator=(Arena&&) noexcept = default;
+  Arena(const Arena&) = delete;
+  Arena& operator=(const Arena&) = delete;
+
+  // `alignment` must be a power of two
+  [[nodiscard]] void* Allocate(std::size_t bytes, std::size_t alignment);
+
+  template <typename T, typename... Args>
+  [[nodiscard]] T* Create(Args&&... args) {
+    static_assert(std::is_trivially_destructible_v<T>,
+                  "Arena objects are never destroyed");
+    return ::new (Allocate(sizeof(T), alignof(T)))
+        T(std::forward<Args>(args)...);
+  }
+
+  // `count` value-initialised objects
+  template <typename T>
+  [[nodiscard]] std::span<T> CreateArray(std::size_t count) {
+    static_assert(std::is_trivially_destructible_v<T>,
+                  "Arena objects are never destroyed");
+    auto* data = static_cast<T*>(Allocate(sizeof(T) * count, alignof(T)));
+    std::uninitialized_value_construct_n(data, count);
+    return {data, count};
+  }
+
+  // A point in the arena's history that Rewind() goes back to
+  struct Marker {
+    std::size_t block = 0;
+    std::size_t used = 0;
+  };
+
+  [[nodiscard]] Marker Mark() const { return {current_, used_}; }
+
+  // Gives back everything allocated since `marker` was taken. The blocks
+  // are kept and reused by later allocations.
+  void Rewind(Marker marker) {
+    current_ = marker.block;
+    used_ = marker.used;
+  }
+
+  void Reset() { Rewind({}); }
+
+  // Bytes held in blocks, used or not
+  [[nodiscard]] std::size_t BytesReserved() const;
+  [[nodiscard]] std::size_t BlockCount() const { return blocks_.size(); }
+
+  static constexpr std::size_t kDefaultBlockSize = std::size_t{64} << 10;
+  static constexpr std::size_t kMaxBlockSize = std::size_t{64} << 20;
+
+ private:
+  struct Block {
+    std::unique_ptr<std::byte[]> data;
+    std::size_t size = 0;
+  };
+
+  std::vector<Block> blocks_;
+  std::size_t current_ = 0;  // Block allocations are bumped off
+  std::size_t used_ = 0;     // Bytes of it in use
+  std::size_t next_block_size_;
+};
+
+// Rewinds an arena to where it was on construction when leaving the scope
+class ArenaScope {
+ public:
+  explicit ArenaScope(Arena& arena) : arena_(arena), marker_(arena.Mark()) {}
+  ~ArenaScope() { arena_.Rewind(marker_); }
+
+  ArenaScope(const ArenaScope&) = delete;
+  ArenaScope& operator=(const ArenaScope&) = delete;
+
+ private:
+  Arena& arena_;
+  Arena::Marker marker_;
+};
+
+// Arena owned by the calling thread, for data that lives no longer than the
+// task using it. Tasks take an ArenaScope on it, so a task that helps run
+// others while it waits gets its memory back intact.
+[[nodiscard]] Arena& ThreadScratch();
+
+}  // namespace polaris::util
+
+#endif
@@ -0,0 +1,125 @@
+#include <cstdint>
+#include <fstream>
+#include <new>
+#include <util/MappedFile.hpp>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define POLARIS_HAS_MMAP
+#endif
+
+namespace polaris::util {
+namespace {
+constexpr std::align_val_t kBufferAlignment{64};
+}  // namespace
+
+MappedFile::~MappedFile() { Close(); }
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : data_(std::exchange(other.data_, nullptr)),
+      size_(std::exchange(other.size_, 0)),
+      mapped_(other.mapped_) {}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+  if (this != &other) {
+    Close();
+    data_ = std::exchange(other.data_, nullptr);
+    size_ = std::exchange(other.size_, 0);
+    mapped_ = other.mapped_;
+  }
+  return *this;
+}
+
+bool MappedFile::Open(const std::filesystem::path& path) {
+  Close();
+
+#ifdef POLARIS_HAS_MMAP
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat info {};
+  if (::fstat(fd, &info) != 0 || info.st_size <= 0) {
+    ::close(fd);
+    return false;
+  }
+
+  const auto size = static_cast<std::size_t>(info.st_size);
+  void* data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);  // The mapping keeps the file open
+  if (data == MAP_FAILED) {
+    return false;
+  }
+  data_ = static_cast<const std::byte*>(data);
+  size_ = size;
+  mapped_ = true;
+  return true;
+#else
+  std::ifstream in(path, std::ios::binary | std::ios::ate);
+  if (!in) {
+    return false;
+  }
+  const auto size = static_cast<std::size_t>(in.tellg());
+  if (size == 0) {
+    return false;
+  }
+  auto* buffer = static_cast<std::byte*>(::operator new(size, kBufferAlignment));
+  in.seekg(0);
+  if (!in.read(reinterpret_cast<char*>(buffer),
+               static_cast<std::streamsize>(size))) {
+    ::operator delete(buffer, kBufferAlignment);
+    return false;
+  }
+  data_ = buffer;
+  size_ = size;
+  mapped_ = false;
+  return true;
+#endif
+}
+
+void MappedFile::AdviseRandom() const {
+#ifdef POLARIS_HAS_MMAP
+  if (mapped_) {
+    ::madvise(const_cast<std::byte*>(data_), size_, MADV_RANDOM);
+  }
+#endif
+}
+
+void MappedFile::Discard(std::span<const std::byte> bytes) const {
+#ifdef POLARIS_HAS_MMAP
+  if (!mapped_ || bytes.empty()) {
+    return;
+  }
+  const auto page = static_cast<std::uintptr_t>(::sysconf(_SC_PAGESIZE));
+  const auto begin = reinterpret_cast<std::uintptr_t>(bytes.data());
+  const auto first = (begin + page - 1) & ~(page - 1);
+  const auto last = (begin + bytes.size()) & ~(page - 1);
+  if (first < last) {
+    ::madvise(reinterpret_cast<void*>(first), last - first, MADV_DONTNEED);
+  }
+#else
+  (void)bytes;
+#endif
+}
+
+void MappedFile::Close() {
+  if (data_ == nullptr) {
+    return;
+  }
+#ifdef POLARIS_HAS_MMAP
+  if (mapped_) {
+    ::munmap(const_cast<std::byte*>(data_), size_);
+  }
+#endif
+  if (!mapped_) {
+    ::operator delete(const_cast<std::byte*>(data_), kBufferAlignment);
+  }
+  data_ = nullptr;
+  size_ = 0;
+}
+
+}  // namespace polaris::util
@@ -0,0 +1,48 @@
+#ifndef POLARIS_UTIL_MAPPED_FILE_HPP
+#define POLARIS_UTIL_MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <filesystem>
+#include <span>
+
+namespace polaris::util {
+
+// Read-only view of a whole file. POSIX systems map the file into memory, so
+// pages are only read once touched; elsewhere it is read into a buffer. The
+// data is aligned to at least 64 bytes either way.
+class MappedFile {
+ public:
+  MappedFile() = default;
+  ~MappedFile();
+
+  MappedFile(MappedFile&& other) noexcept;
+  MappedFile& operator=(MappedFile&& other) noexcept;
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  // Replaces the current view; false if the file cannot be read
+  bool Open(const std::filesystem::path& path);
+  void Close();
+
+  [[nodiscard]] std::span<const std::byte> Bytes() const {
+    return {data_, size_};
+  }
+  [[nodiscard]] bool IsOpen() const { return data_ != nullptr; }
+
+  // Tells the system the view is read in no particular order, so it reads
+  // no further ahead of each page touched than it must
+  void AdviseRandom() const;
+
+  // Drops the whole pages within `bytes` of the view from memory; they are
+  // read from the file again when next touched. Buffered views keep them.
+  void Discard(std::span<const std::byte> bytes) const;
+
+ private:
+  const std::byte* data_ = nullptr;
+  std::size_t size_ = 0;
+  bool mapped_ = false;  // Whether data_ is a mapping or a heap buffer
+};
+
+}  // namespace polaris::util
+
+#endif
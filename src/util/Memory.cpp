@@ -0,0 +1,24 @@
+#include <util/Memory.hpp>
+
+#if defined(__linux__)
+#include <fstream>
+#include <string>
+#endif
+
+namespace polaris::util {
+
+std::size_t PeakMemoryBytes() {
+#if defined(__linux__)
+  // VmHWM is the high water mark of the resident set, in kB
+  std::ifstream status("/proc/self/status");
+  std::string line;
+  while (std::getline(status, line)) {
+    if (line.starts_with("VmHWM:")) {
+      return std::stoull(line.substr(6)) * 1024;
+    }
+  }
+#endif
+  return 0;
+}
+
+}  // namespace polaris::util
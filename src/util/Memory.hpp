@@ -0,0 +1,14 @@
+#ifndef POLARIS_UTIL_MEMORY_HPP
+#define POLARIS_UTIL_MEMORY_HPP
+
+#include <cstddef>
+
+namespace polaris::util {
+
+// Largest resident set size the process has had so far, in bytes, or 0 where
+// the platform does not report it (only Linux does for now)
+[[nodiscard]] std::size_t PeakMemoryBytes();
+
+}  // namespace polaris::util
+
+#endif
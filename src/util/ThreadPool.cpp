@@ -0,0 +1,226 @@
+#include <algorithm>
+#include <util/ThreadPool.hpp>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace polaris::util {
+namespace {
+// Pool and queue the current thread works for, if any
+thread_local const ThreadPool* tls_pool = nullptr;
+thread_local std::size_t tls_queue = 0;
+
+// Logical CPUs the calling thread may run on, empty if unknown
+std::vector<int> AllowedCpus() {
+  std::vector<int> cpus;
+#if defined(__linux__)
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+      if (CPU_ISSET(cpu, &set)) {
+        cpus.push_back(cpu);
+      }
+    }
+  }
+#endif
+  return cpus;
+}
+
+void PinToCpu(std::jthread& thread, int cpu) {
+#if defined(__linux__)
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set);
+#else
+  (void)thread;
+  (void)cpu;
+#endif
+}
+}  // namespace
+
+ThreadPool::ThreadPool(std::size_t thread_count, bool pin_threads) {
+  // Outside submissions need a queue even when no worker owns one
+  queues_.resize(std::max<std::size_t>(thread_count, 1));
+  for (auto& queue : queues_) {
+    queue = std::make_unique<WorkQueue>();
+  }
+
+  // Only CPUs in the affinity mask, which a taskset or a container may
+  // have narrowed; pinning outside of it would fail
+  const auto cpus = pin_threads ? AllowedCpus() : std::vector<int>();
+  workers_.reserve(thread_count);
+  for (std::size_t i = 0; i < thread_count; ++i) {
+    workers_.emplace_back(
+        [this, i](const std::stop_token& stop) { WorkerLoop(stop, i); });
+    if (!cpus.empty()) {
+      PinToCpu(workers_.back(), cpus[i % cpus.size()]);
+    }
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  for (auto& worker : workers_) {
+    worker.request_stop();
+  }
+  has_work_.notify_all();
+}
+
+void ThreadPool::Submit(std::function<void()> task) {
+  // Counted first so a racing pop can never take the count below zero
+  queued_.fetch_add(1, std::memory_order_release);
+
+  const int worker = WorkerIndex();
+  if (worker >= 0) {
+    // Newest first keeps a worker on the subtree it is busy with
+    auto& queue = *queues_[worker];
+    const std::scoped_lock lock(queue.mutex);
+    queue.tasks.push_front(std::move(task));
+  } else {
+    const auto index =
+        next_queue_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+    auto& queue = *queues_[index];
+    const std::scoped_lock lock(queue.mutex);
+    queue.tasks.push_back(std::move(task));
+  }
+
+  // Taking the lock orders this against a worker about to go to sleep
+  { const std::scoped_lock lock(sleep_mutex_); }
+  has_work_.notify_one();
+}
+
+bool ThreadPool::RunPendingTask() {
+  std::function<void()> task;
+  const int worker = WorkerIndex();
+  const bool found =
+      worker >= 0 ? PopLocal(worker, task) || Steal(worker, task)
+                  : TakeFront(task);
+  if (!found) {
+    return false;
+  }
+
+  task();
+  return true;
+}
+
+void ThreadPool::WakeWaiters() {
+  // Taking the lock orders this against a waiter checking its condition
+  { const std::scoped_lock lock(sleep_mutex_); }
+  has_work_.notify_all();
+}
+
+ThreadPool& ThreadPool::Default() {
+  static ThreadPool pool(std::thread::hardware_concurrency());
+  return pool;
+}
+
+int ThreadPool::WorkerIndex() const {
+  return tls_pool == this ? static_cast<int>(tls_queue) : -1;
+}
+
+bool ThreadPool::PopLocal(std::size_t index, std::function<void()>& task) {
+  auto& queue = *queues_[index];
+  const std::scoped_lock lock(queue.mutex);
+  if (queue.tasks.empty()) {
+    return false;
+  }
+  task = std::move(queue.tasks.front());
+  queue.tasks.pop_front();
+  queued_.fetch_sub(1, std::memory_order_relaxed);
+  return true;
+}
+
+bool ThreadPool::Steal(std::size_t thief, std::function<void()>& task) {
+  // The back of a deque holds its oldest spawned task, usually the largest
+  for (std::size_t i = 1; i < queues_.size(); ++i) {
+    auto& queue = *queues_[(thief + i) % queues_.size()];
+    const std::scoped_lock lock(queue.mutex);
+    if (!queue.tasks.empty()) {
+      task = std::move(queue.tasks.back());
+      queue.tasks.pop_back();
+      queued_.fetch_sub(1, std::memory_order_relaxed);
+      return true;
+    }
+  }
+  return false;
+}
+
+bool ThreadPool::TakeFront(std::function<void()>& task) {
+  // Threads outside the pool help in submission order
+  for (std::size_t i = 0; i < queues_.size(); ++i) {
+    if (PopLocal(i, task)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void ThreadPool::WorkerLoop(const std::stop_token& stop, std::size_t index) {
+  tls_pool = this;
+  tls_queue = index;
+
+  while (true) {
+    std::function<void()> task;
+    if (PopLocal(index, task) || Steal(index, task)) {
+      task();
+      continue;
+    }
+
+    std::unique_lock lock(sleep_mutex_);
+    if (!has_work_.wait(lock, stop, [this] {
+          return queued_.load(std::memory_order_acquire) != 0;
+        })) {
+      return;  // Stop requested
+    }
+  }
+}
+
+TaskGroup::~TaskGroup() {
+  // Tasks reference this group, so they must finish before it goes away
+  Finish();
+}
+
+void TaskGroup::Run(std::function<void()> task) {
+  pending_.fetch_add(1, std::memory_order_relaxed);
+  pool_.Submit([this, task = std::move(task)] {
+    try {
+      task();
+    } catch (...) {
+      const std::scoped_lock lock(error_mutex_);
+      if (!error_) {
+        error_ = std::current_exception();
+      }
+    }
+    // The group may be gone as soon as the count reaches zero, so the pool
+    // is fetched first
+    auto& pool = pool_;
+    if (pending_.fetch_sub(1, std::memory_order_release) == 1) {
+      pool.WakeWaiters();
+    }
+  });
+}
+
+void TaskGroup::Wait() {
+  Finish();
+  if (error_) {
+    std::rethrow_exception(std::exchange(error_, nullptr));
+  }
+}
+
+void TaskGroup::Finish() {
+  const auto done = [this] {
+    return pending_.load(std::memory_order_acquire) == 0;
+  };
+  while (!done()) {
+    if (!pool_.RunPendingTask()) {
+      pool_.WaitForWork(done);
+    }
+  }
+}
+
+}  // namespace polaris::util
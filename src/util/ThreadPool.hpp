@@ -0,0 +1,107 @@
+#ifndef POLARIS_UTIL_THREAD_POOL_HPP
+#define POLARIS_UTIL_THREAD_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace polaris::util {
+
+// Fixed set of worker threads, each with its own task deque. A worker runs
+// the tasks it spawned itself newest first and steals the oldest task of
+// another worker once its own deque is empty. Tasks submitted from outside
+// the pool are dealt round robin over the deques, so they start roughly, but
+// not strictly, in submission order. Threads that wait on a TaskGroup help
+// out by running queued tasks, so tasks may spawn and wait on further tasks
+// without starving the pool, and only sleep once there is none to run.
+class ThreadPool {
+ public:
+  // A pool of zero threads runs all of its tasks on the threads waiting for
+  // them. Pinned workers are bound to one logical CPU each, dealt round
+  // robin from the CPUs the constructing thread may run on (Linux only).
+  explicit ThreadPool(std::size_t thread_count, bool pin_threads = false);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  void Submit(std::function<void()> task);
+
+  // Runs one queued task on the calling thread, if there is one.
+  bool RunPendingTask();
+
+  [[nodiscard]] std::size_t ThreadCount() const { return workers_.size(); }
+
+  // Process-wide pool sized to the hardware concurrency.
+  static ThreadPool& Default();
+
+ private:
+  friend class TaskGroup;
+  struct alignas(64) WorkQueue {
+    std::mutex mutex;
+    std::deque<std::function<void()>> tasks;
+  };
+
+  // Index of the calling thread's queue, or -1 if it is not one of ours
+  [[nodiscard]] int WorkerIndex() const;
+
+  bool PopLocal(std::size_t index, std::function<void()>& task);
+  bool Steal(std::size_t thief, std::function<void()>& task);
+  bool TakeFront(std::function<void()>& task);
+
+  void WorkerLoop(const std::stop_token& stop, std::size_t index);
+
+  // Blocks the calling thread until a task is queued or `done()` holds.
+  // Whatever makes `done()` true must call WakeWaiters() afterwards.
+  template <typename Done>
+  void WaitForWork(Done&& done) {
+    std::unique_lock lock(sleep_mutex_);
+    has_work_.wait(lock, [&] {
+      return queued_.load(std::memory_order_acquire) != 0 || done();
+    });
+  }
+  void WakeWaiters();
+
+  std::vector<std::unique_ptr<WorkQueue>> queues_;
+  std::atomic<std::size_t> next_queue_{0};  // Round robin for outside tasks
+  std::atomic<std::size_t> queued_{0};      // Tasks in all queues
+
+  std::mutex sleep_mutex_;
+  std::condition_variable_any has_work_;
+  std::vector<std::jthread> workers_;
+};
+
+// Tracks a batch of tasks submitted to a pool so the caller can wait for all
+// of them. The first exception thrown by a task is rethrown from Wait().
+class TaskGroup {
+ public:
+  explicit TaskGroup(ThreadPool& pool) : pool_(pool) {}
+  ~TaskGroup();
+
+  TaskGroup(const TaskGroup&) = delete;
+  TaskGroup& operator=(const TaskGroup&) = delete;
+
+  void Run(std::function<void()> task);
+  void Wait();
+
+ private:
+  // Runs queued tasks until the group's are done, sleeping while there are
+  // none to run
+  void Finish();
+
+  ThreadPool& pool_;
+  std::atomic<std::size_t> pending_{0};
+  std::mutex error_mutex_;
+  std::exception_ptr error_;
+};
+
+}  // namespace polaris::util
+
+#endif